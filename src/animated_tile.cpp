@@ -12,25 +12,44 @@
 #include "stdafx.h"
 #include "core/alloc_func.hpp"
 #include "core/smallvec_type.hpp"
+#include "core/mem_func.hpp"
 #include "tile_cmd.h"
 #include "viewport_func.h"
 #include "framerate_type.h"
+#include "date_func.h"
+#include <unordered_map>
 
 #include "safeguards.h"
 
-/** The table/list with animated tiles. */
+/**
+ * The table/list with animated tiles, in the order they are animated. Deleted
+ * tiles are replaced by INVALID_TILE until the next animation loop removes them.
+ */
 SmallVector<TileIndex, 256> _animated_tiles;
 
+/** Animation speed of each entry in #_animated_tiles, or #ANIMATION_SPEED_UNKNOWN if it has to be animated every tick. */
+static SmallVector<byte, 256> _animated_tile_speeds;
+
+/** Position of each animated tile in #_animated_tiles. */
+static std::unordered_map<TileIndex, uint> _animated_tile_positions;
+
+/** Position in #_animated_tiles of the tile being animated right now. */
+static uint _animated_tile_current = UINT_MAX;
+
+static const byte ANIMATION_SPEED_UNKNOWN = 0xFF; ///< The tile has no fixed animation speed (yet).
+
 /**
  * Removes the given tile from the animated tile table.
  * @param tile the tile to remove
  */
 void DeleteAnimatedTile(TileIndex tile)
 {
-	TileIndex *to_remove = _animated_tiles.Find(tile);
-	if (to_remove != _animated_tiles.End()) {
-		/* The order of the remaining elements must stay the same, otherwise the animation loop may miss a tile. */
-		_animated_tiles.ErasePreservingOrder(to_remove);
+	std::unordered_map<TileIndex, uint>::iterator it = _animated_tile_positions.find(tile);
+	if (it != _animated_tile_positions.end()) {
+		/* The order of the remaining elements must stay the same, otherwise the animation loop may miss a tile.
+		 * So just leave a hole here, which the animation loop closes. */
+		_animated_tiles[it->second] = INVALID_TILE;
+		_animated_tile_positions.erase(it);
 		MarkTileDirtyByTile(tile);
 	}
 }
@@ -43,31 +62,112 @@ void DeleteAnimatedTile(TileIndex tile)
 void AddAnimatedTile(TileIndex tile)
 {
 	MarkTileDirtyByTile(tile);
-	_animated_tiles.Include(tile);
+	if (!_animated_tile_positions.insert(std::make_pair(tile, _animated_tiles.Length())).second) return;
+	*_animated_tiles.Append() = tile;
+	*_animated_tile_speeds.Append() = ANIMATION_SPEED_UNKNOWN;
+}
+
+/**
+ * Tell the animation loop that an animated tile only changes its animation
+ * every (1 << speed) ticks, so it can skip the tile in between. This has to be
+ * undone with #ResetAnimatedTileSpeed when the speed could change.
+ * @param tile  The animated tile.
+ * @param speed The fixed animation speed of the tile.
+ */
+void SetAnimatedTileSpeed(TileIndex tile, byte speed)
+{
+	uint pos = _animated_tile_current;
+	if (pos >= _animated_tiles.Length() || _animated_tiles[pos] != tile) {
+		std::unordered_map<TileIndex, uint>::const_iterator it = _animated_tile_positions.find(tile);
+		if (it == _animated_tile_positions.end()) return;
+		pos = it->second;
+	}
+	_animated_tile_speeds[pos] = speed;
+}
+
+/**
+ * Make the animation loop animate a tile every tick again, because whatever
+ * decided its animation speed has changed.
+ * @param tile The tile that changed.
+ */
+void ResetAnimatedTileSpeed(TileIndex tile)
+{
+	std::unordered_map<TileIndex, uint>::const_iterator it = _animated_tile_positions.find(tile);
+	if (it != _animated_tile_positions.end()) _animated_tile_speeds[it->second] = ANIMATION_SPEED_UNKNOWN;
+}
+
+/**
+ * Remove the holes left by deleted tiles from the animated tile table.
+ */
+void CompactAnimatedTiles()
+{
+	uint count = 0;
+	for (uint i = 0; i < _animated_tiles.Length(); i++) {
+		TileIndex tile = _animated_tiles[i];
+		if (tile == INVALID_TILE) continue;
+		if (count != i) {
+			_animated_tiles[count] = tile;
+			_animated_tile_speeds[count] = _animated_tile_speeds[i];
+			_animated_tile_positions[tile] = count;
+		}
+		count++;
+	}
+	_animated_tiles.Resize(count);
+	_animated_tile_speeds.Resize(count);
+}
+
+/**
+ * Rebuild the lookup tables after #_animated_tiles has been filled directly,
+ * e.g. by loading a savegame. Duplicates are removed, keeping the first entry.
+ * The animation speeds are forgotten.
+ */
+void RebuildAnimatedTileIndex()
+{
+	_animated_tile_positions.clear();
+	uint count = 0;
+	for (uint i = 0; i < _animated_tiles.Length(); i++) {
+		TileIndex tile = _animated_tiles[i];
+		if (tile == INVALID_TILE || !_animated_tile_positions.insert(std::make_pair(tile, count)).second) continue;
+		_animated_tiles[count++] = tile;
+	}
+	_animated_tiles.Resize(count);
+	_animated_tile_speeds.Resize(count);
+	MemSetT(_animated_tile_speeds.Begin(), ANIMATION_SPEED_UNKNOWN, count);
 }
 
 /**
  * Animate all tiles in the animated tile list, i.e.\ call AnimateTile on them.
+ * Tiles with a known animation speed are only animated when their next frame is due.
  */
 void AnimateAnimatedTiles()
 {
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
 
-	const TileIndex *ti = _animated_tiles.Begin();
-	while (ti < _animated_tiles.End()) {
-		const TileIndex curr = *ti;
-		AnimateTile(curr);
-		/* During the AnimateTile call, DeleteAnimatedTile could have been called,
-		 * deleting an element we've already processed and pushing the rest one
-		 * slot to the left. We can detect this by checking whether the index
-		 * in the current slot has changed - if it has, an element has been deleted,
-		 * and we should process the current slot again instead of going forward.
-		 * NOTE: this will still break if more than one animated tile is being
-		 *       deleted during the same AnimateTile call, but no code seems to
-		 *       be doing this anyway.
-		 */
-		if (*ti == curr) ++ti;
+	/* Tiles can be added and deleted by AnimateTile. Added tiles are appended
+	 * and still animated in this loop; deleted tiles leave a hole that is
+	 * closed by moving the following entries down while walking the list. */
+	uint count = 0;
+	for (uint i = 0; i < _animated_tiles.Length(); i++) {
+		TileIndex tile = _animated_tiles[i];
+		if (tile == INVALID_TILE) continue;
+
+		byte speed = _animated_tile_speeds[i];
+		if (speed == ANIMATION_SPEED_UNKNOWN || _tick_counter % (1 << speed) == 0) {
+			_animated_tile_current = i;
+			AnimateTile(tile);
+			if (_animated_tiles[i] == INVALID_TILE) continue;
+		}
+
+		if (count != i) {
+			_animated_tiles[count] = tile;
+			_animated_tile_speeds[count] = _animated_tile_speeds[i];
+			_animated_tile_positions[tile] = count;
+		}
+		count++;
 	}
+	_animated_tile_current = UINT_MAX;
+	_animated_tiles.Resize(count);
+	_animated_tile_speeds.Resize(count);
 }
 
 /**
@@ -76,4 +176,6 @@ void AnimateAnimatedTiles()
 void InitializeAnimatedTiles()
 {
 	_animated_tiles.Clear();
+	_animated_tile_speeds.Clear();
+	_animated_tile_positions.clear();
 }
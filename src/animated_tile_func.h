@@ -16,7 +16,11 @@
 
 void AddAnimatedTile(TileIndex tile);
 void DeleteAnimatedTile(TileIndex tile);
+void SetAnimatedTileSpeed(TileIndex tile, byte speed);
+void ResetAnimatedTileSpeed(TileIndex tile);
 void AnimateAnimatedTiles();
 void InitializeAnimatedTiles();
+void CompactAnimatedTiles();
+void RebuildAnimatedTileIndex();
 
 #endif /* ANIMATED_TILE_FUNC_H */
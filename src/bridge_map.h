@@ -44,7 +44,7 @@ static inline bool IsBridgeTile(TileIndex t)
  */
 static inline bool IsBridgeAbove(TileIndex t)
 {
-	return GB(_m[t].type, 2, 2) != 0;
+	return GB(_m_type[t], 2, 2) != 0;
 }
 
 /**
@@ -68,7 +68,7 @@ static inline BridgeType GetBridgeType(TileIndex t)
 static inline Axis GetBridgeAxis(TileIndex t)
 {
 	assert(IsBridgeAbove(t));
-	return (Axis)(GB(_m[t].type, 2, 2) - 1);
+	return (Axis)(GB(_m_type[t], 2, 2) - 1);
 }
 
 TileIndex GetNorthernBridgeEnd(TileIndex t);
@@ -93,7 +93,7 @@ static inline int GetBridgePixelHeight(TileIndex tile)
  */
 static inline void ClearSingleBridgeMiddle(TileIndex t, Axis a)
 {
-	ClrBit(_m[t].type, 2 + a);
+	ClrBit(_m_type[t], 2 + a);
 }
 
 /**
@@ -113,7 +113,7 @@ static inline void ClearBridgeMiddle(TileIndex t)
  */
 static inline void SetBridgeMiddle(TileIndex t, Axis a)
 {
-	SetBit(_m[t].type, 2 + a);
+	SetBit(_m_type[t], 2 + a);
 }
 
 /**
@@ -256,6 +256,7 @@ void VehicleCargoList::Append(CargoPacket *cp, MoveToAction action)
 	assert(cp != NULL);
 	assert(action == MTA_LOAD ||
 			(action == MTA_KEEP && this->action_counts[MTA_LOAD] == 0));
+	this->AgePendingCargo();
 	this->AddToMeta(cp, action);
 
 	if (this->count == cp->count) {
@@ -288,6 +289,7 @@ void VehicleCargoList::Append(CargoPacket *cp, MoveToAction action)
 template<class Taction>
 void VehicleCargoList::ShiftCargo(Taction action)
 {
+	this->AgePendingCargo();
 	Iterator it(this->packets.begin());
 	while (it != this->packets.end() && action.MaxMove() > 0) {
 		CargoPacket *cp = *it;
@@ -310,6 +312,7 @@ void VehicleCargoList::ShiftCargo(Taction action)
 template<class Taction>
 void VehicleCargoList::PopCargo(Taction action)
 {
+	this->AgePendingCargo();
 	if (this->packets.empty()) return;
 	Iterator it(--(this->packets.end()));
 	Iterator begin(this->packets.begin());
@@ -394,6 +397,37 @@ void VehicleCargoList::AgeCargo()
 	}
 }
 
+/**
+ * Execute aging requested by RequestAgeCargo, if any.
+ * Only this list and its packets are touched, so lists of different
+ * vehicles can be aged concurrently. Everything that changes the packets
+ * of the list calls this first, so packets leave the list aged exactly as
+ * if the aging had not been deferred.
+ */
+void VehicleCargoList::AgePendingCargo()
+{
+	if (!this->aging_pending) return;
+	this->aging_pending = false;
+	this->AgeCargo();
+}
+
+/**
+ * Get the sum of the days in transit of all cargo entities, as it will be
+ * after executing pending aging.
+ * @return The before mentioned number.
+ */
+uint VehicleCargoList::CargoDaysInTransit() const
+{
+	uint days = this->cargo_days_in_transit;
+	if (!this->aging_pending) return days;
+
+	for (ConstIterator it(this->packets.begin()); it != this->packets.end(); it++) {
+		const CargoPacket *cp = *it;
+		if (cp->days_in_transit != 0xFF) days += cp->count;
+	}
+	return days;
+}
+
 /**
  * Sets loaded_at_xy to the current station for all cargo to be transfered.
  * This is done when stopping or skipping while the vehicle is unloading. In
@@ -403,6 +437,7 @@ void VehicleCargoList::AgeCargo()
  */
 void VehicleCargoList::SetTransferLoadPlace(TileIndex xy)
 {
+	this->AgePendingCargo();
 	uint sum = 0;
 	for (Iterator it = this->packets.begin(); sum < this->action_counts[MTA_TRANSFER]; ++it) {
 		CargoPacket *cp = *it;
@@ -451,6 +486,7 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 {
 	this->AssertCountConsistency();
 	assert(this->action_counts[MTA_LOAD] == 0);
+	this->AgePendingCargo();
 	this->action_counts[MTA_TRANSFER] = this->action_counts[MTA_DELIVER] = this->action_counts[MTA_KEEP] = 0;
 	Iterator deliver = this->packets.end();
 	Iterator it = this->packets.begin();
@@ -541,6 +577,7 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 /** Invalidates the cached data and rebuild it. */
 void VehicleCargoList::InvalidateCache()
 {
+	this->AgePendingCargo();
 	this->feeder_share = 0;
 	this->Parent::InvalidateCache();
 }
@@ -579,6 +616,7 @@ template<>
 uint VehicleCargoList::Reassign<VehicleCargoList::MTA_DELIVER, VehicleCargoList::MTA_TRANSFER>(uint max_move, TileOrStationID next_station)
 {
 	max_move = min(this->action_counts[MTA_DELIVER], max_move);
+	this->AgePendingCargo();
 
 	uint sum = 0;
 	for (Iterator it(this->packets.begin()); sum < this->action_counts[MTA_TRANSFER] + max_move;) {
@@ -287,6 +287,7 @@ protected:
 
 	Money feeder_share;                     ///< Cache for the feeder share.
 	uint action_counts[NUM_MOVE_TO_ACTION]; ///< Counts of cargo to be transfered, delivered, kept and loaded.
+	bool aging_pending;                     ///< Whether the cargo has to be aged by AgePendingCargo.
 
 	template<class Taction>
 	void ShiftCargo(Taction action);
@@ -330,6 +331,9 @@ public:
 	friend class CargoReturn;
 	friend class VehicleCargoReroute;
 
+	/** Create the cargo list. */
+	VehicleCargoList() : aging_pending(false) {}
+
 	/**
 	 * Returns source of the first cargo packet in this list.
 	 * @return The before mentioned source.
@@ -408,6 +412,39 @@ public:
 
 	void AgeCargo();
 
+	/**
+	 * Request aging of the cargo, to be executed later by AgePendingCargo.
+	 * Until then the list behaves as if it had been aged already; changing
+	 * the list executes the aging first.
+	 */
+	inline void RequestAgeCargo()
+	{
+		this->aging_pending = true;
+	}
+
+	/**
+	 * Check whether aging of the cargo has been requested but not executed yet.
+	 * @return True if AgePendingCargo still has to be called.
+	 */
+	inline bool IsAgingPending() const
+	{
+		return this->aging_pending;
+	}
+
+	void AgePendingCargo();
+
+	uint CargoDaysInTransit() const;
+
+	/**
+	 * Returns average number of days in transit for a cargo entity,
+	 * including requested but not yet executed aging.
+	 * @return The before mentioned number.
+	 */
+	inline uint DaysInTransit() const
+	{
+		return this->count == 0 ? 0 : this->CargoDaysInTransit() / this->count;
+	}
+
 	void InvalidateCache();
 
 	void SetTransferLoadPlace(TileIndex xy);
@@ -400,4 +400,5 @@ extern const TileTypeProcs _tile_type_clear_procs = {
 	NULL,                     ///< vehicle_enter_tile_proc
 	GetFoundation_Clear,      ///< get_foundation_proc
 	TerraformTile_Clear,      ///< terraform_tile_proc
+	TileLoopBatch<MP_CLEAR, TileLoop_Clear>, ///< tile_loop_batch_proc
 };
@@ -26,6 +26,11 @@
 #include "signal_func.h"
 #include "core/backup_type.hpp"
 #include "object_base.h"
+#include "train.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "road_map.h"
+#include "station_map.h"
+#include "tunnelbridge_map.h"
 
 #include "table/strings.h"
 
@@ -429,6 +434,65 @@ bool IsCommandAllowedWhilePaused(uint32 cmd)
 
 static int _docommand_recursive = 0;
 
+/**
+ * Is a command being tested or executed at the moment?
+ * @return true iff we are inside #DoCommand or #DoCommandPInternal.
+ */
+bool IsCommandRunning()
+{
+	return _docommand_recursive != 0;
+}
+
+/**
+ * Check whether a tile carries road.
+ * @param tile The tile to check.
+ * @return True for road, road stop and road tunnel or bridge tiles.
+ */
+static bool TileCarriesRoad(TileIndex tile)
+{
+	switch (GetTileType(tile)) {
+		case MP_ROAD:         return true;
+		case MP_STATION:      return IsRoadStop(tile);
+		case MP_TUNNELBRIDGE: return GetTunnelBridgeTransportType(tile) == TRANSPORT_ROAD;
+		default:              return false;
+	}
+}
+
+/**
+ * Check whether executing a command may change the roads the road
+ * destination fields of YAPF are built from. Commands that are built from
+ * other commands, like clearing an area, are covered by the commands they
+ * execute. This looks at the tile before the command changes it.
+ * @param cmd The command to execute.
+ * @param tile The tile the command is executed on.
+ * @return True if the road destination fields have to be rebuilt afterwards.
+ */
+static bool CommandMayChangeRoads(uint32 cmd, TileIndex tile)
+{
+	switch (cmd & CMD_ID_MASK) {
+		case CMD_BUILD_ROAD:
+		case CMD_BUILD_LONG_ROAD:
+		case CMD_REMOVE_LONG_ROAD:
+		case CMD_BUILD_ROAD_DEPOT:
+		case CMD_BUILD_ROAD_STOP:
+		case CMD_REMOVE_ROAD_STOP:
+		case CMD_BUILD_BRIDGE:
+		case CMD_BUILD_TUNNEL:
+		case CMD_TERRAFORM_LAND:
+			return true;
+
+		/* Demolishing roads and building or removing level crossings.
+		 * Towns and industries clear many tiles without road. */
+		case CMD_LANDSCAPE_CLEAR:
+		case CMD_BUILD_SINGLE_RAIL:
+		case CMD_REMOVE_SINGLE_RAIL:
+			return tile < MapSize() && TileCarriesRoad(tile);
+
+		default:
+			return false;
+	}
+}
+
 /**
  * Shorthand for calling the long DoCommand with a container.
  *
@@ -493,7 +557,15 @@ CommandCost DoCommand(TileIndex tile, uint32 p1, uint32 p2, DoCommandFlag flags,
 	/* Execute the command here. All cost-relevant functions set the expenses type
 	 * themselves to the cost object at some point */
 	if (_docommand_recursive == 1) _cleared_object_areas.Clear();
-	res = proc(tile, flags, p1, p2, text);
+	/* The road fields and signal blocks only depend on the map, so they may not outlive a change of it.
+	 * Whether the roads may change has to be checked before the command changes the tile. */
+	if (CommandMayChangeRoads(cmd, tile)) {
+		res = proc(tile, flags, p1, p2, text);
+		if (res.Succeeded()) YapfNotifyRoadLayoutChange();
+	} else {
+		res = proc(tile, flags, p1, p2, text);
+	}
+	if (_command_proc_table[cmd & CMD_ID_MASK].type == CMDT_LANDSCAPE_CONSTRUCTION) ClearSignalBlockCache();
 	if (res.Failed()) {
 error:
 		_docommand_recursive--;
@@ -629,6 +701,9 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd,
 	assert(_docommand_recursive == 0);
 	_docommand_recursive = 1;
 
+	/* The path searches running in the background must not see the game change. */
+	CancelTrainPathLookahead();
+
 	/* Reset the state. */
 	_additional_cash_required = 0;
 
@@ -717,9 +792,13 @@ CommandCost DoCommandPInternal(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd,
 	/* Actually try and execute the command. If no cost-type is given
 	 * use the construction one */
 	_cleared_object_areas.Clear();
+	/* See DoCommand about the road fields and signal blocks. */
+	bool may_change_roads = CommandMayChangeRoads(cmd_id, tile);
 	BasePersistentStorageArray::SwitchMode(PSM_ENTER_COMMAND);
 	CommandCost res2 = proc(tile, flags | DC_EXEC, p1, p2, text);
 	BasePersistentStorageArray::SwitchMode(PSM_LEAVE_COMMAND);
+	if (may_change_roads && res2.Succeeded()) YapfNotifyRoadLayoutChange();
+	if (_command_proc_table[cmd_id].type == CMDT_LANDSCAPE_CONSTRUCTION) ClearSignalBlockCache();
 
 	if (cmd_id == CMD_COMPANY_CTRL) {
 		cur_company.Trash();
@@ -38,6 +38,10 @@
 #include "console_func.h"
 #include "engine_base.h"
 #include "game/game.hpp"
+#include "town.h"
+#include "linkgraph/linkgraphschedule.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "pathfinder/pathfinder_stats.h"
 #include "table/strings.h"
 
 #include "safeguards.h"
@@ -1926,6 +1930,136 @@ DEF_CONSOLE_CMD(ConFramerateWindow)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConLinkGraphBenchmark)
+{
+	if (argc == 0) {
+		IConsoleHelp("Run the link graph handlers on copies of all link graphs and print the time each handler takes. Usage: 'linkgraph_benchmark [<runs>]'");
+		IConsoleHelp("Every job is run <runs> times, default 1, and the fastest time is shown together with a checksum of the results.");
+		IConsoleHelp("The game itself is not changed.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint32 runs = 1;
+	if (argc == 2 && (!GetArgumentInteger(&runs, argv[1]) || runs == 0)) return false;
+
+	LinkGraphSchedule::Benchmark(runs);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConClosestTownBenchmark)
+{
+	if (argc == 0) {
+		IConsoleHelp("Look up the closest town of random tiles with the k-d tree of towns and by checking all towns, and print the time both take. Usage: 'closest_town_benchmark [<lookups>]'");
+		IConsoleHelp("The default number of lookups is 100000. The game itself is not changed.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint32 queries = 100000;
+	if (argc == 2 && (!GetArgumentInteger(&queries, argv[1]) || queries == 0)) return false;
+
+	BenchmarkClosestTown(queries);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConMapLayoutBenchmark)
+{
+	if (argc == 0) {
+		IConsoleHelp("Time sweeps over the map with the tile types and heights in arrays of their own and over a copy with them interleaved with the other tile data. Usage: 'map_layout_benchmark [<runs>]'");
+		IConsoleHelp("Every sweep is run <runs> times, default 5, and the fastest time is shown. The game itself is not changed.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	uint32 runs = 5;
+	if (argc == 2 && (!GetArgumentInteger(&runs, argv[1]) || runs == 0)) return false;
+
+	BenchmarkMapLayout(runs);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConLinkGraphCompare)
+{
+	if (argc == 0) {
+		IConsoleHelp("Run the link graph handlers on copies of all link graphs with both backends of the multi-commodity flow solver and compare the flows. Usage: 'linkgraph_compare'");
+		IConsoleHelp("The game itself is not changed.");
+		return true;
+	}
+
+	if (argc > 1) return false;
+
+	LinkGraphSchedule::CompareSolvers();
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConYapfCache)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show how well the rail segment cost cache and the road destination fields of YAPF work. Usage: 'yapf_cache [reset]'");
+		IConsoleHelp("With 'reset' the build, hit, miss, invalidation and flush counters are set to zero afterwards.");
+		return true;
+	}
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset") != 0)) return false;
+
+	YapfSegmentCacheStats stats;
+	YapfGetSegmentCacheStats(&stats);
+	uint lookups = stats.hits + stats.misses;
+	IConsolePrintF(CC_DEFAULT, "Cached segments: %u", stats.segments);
+	IConsolePrintF(CC_DEFAULT, "Hits:            %u (%u%%)", stats.hits, lookups == 0 ? 0 : (uint)((uint64)stats.hits * 100 / lookups));
+	IConsolePrintF(CC_DEFAULT, "Misses:          %u", stats.misses);
+	IConsolePrintF(CC_DEFAULT, "Invalidated:     %u", stats.invalidated);
+	IConsolePrintF(CC_DEFAULT, "Full flushes:    %u", stats.flushes);
+
+	YapfRoadFieldStats field_stats;
+	YapfGetRoadFieldStats(&field_stats);
+	uint choices = field_stats.hits + field_stats.misses;
+	IConsolePrintF(CC_DEFAULT, "Road destination fields: %u (%u nodes)", field_stats.fields, field_stats.nodes);
+	IConsolePrintF(CC_DEFAULT, "Fields built:    %u", field_stats.builds);
+	IConsolePrintF(CC_DEFAULT, "Field hits:      %u (%u%%)", field_stats.hits, choices == 0 ? 0 : (uint)((uint64)field_stats.hits * 100 / choices));
+	IConsolePrintF(CC_DEFAULT, "Field misses:    %u", field_stats.misses);
+	IConsolePrintF(CC_DEFAULT, "Field flushes:   %u", field_stats.flushes);
+
+	if (argc == 2) {
+		YapfResetSegmentCacheStats();
+		YapfResetRoadFieldStats();
+	}
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConPathfinderStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show how many path searches were done per vehicle type and how long they took. Usage: 'pfstats [reset]'");
+		IConsoleHelp("With 'reset' the statistics are set to zero afterwards.");
+		return true;
+	}
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset") != 0)) return false;
+
+	static const VehicleType types[] = { VEH_TRAIN, VEH_ROAD, VEH_SHIP };
+	static const char * const names[] = { "Trains", "Road vehicles", "Ships" };
+
+	IConsolePrintF(CC_DEFAULT, "%-14s %9s %9s %6s %7s %10s %8s %8s %8s %8s", "", "searches", "avg nodes", "cache", "limited", "total ms", "p50 us", "p95 us", "p99 us", "max us");
+	for (uint i = 0; i < lengthof(types); i++) {
+		PathfinderStats stats;
+		GetPathfinderStats(types[i], &stats);
+		uint64 costs = stats.cache_hits + stats.cost_calcs;
+		IConsolePrintF(CC_DEFAULT, "%-14s %9u %9u %5u%% %7u %10.1f %8u %8u %8u %8u", names[i], stats.searches,
+				stats.searches == 0 ? 0 : (uint)(stats.nodes / stats.searches),
+				costs == 0 ? 0 : (uint)(stats.cache_hits * 100 / costs),
+				stats.exhausted, stats.total_us / 1000.0,
+				(uint)stats.GetLatencyPercentile(50), (uint)stats.GetLatencyPercentile(95), (uint)stats.GetLatencyPercentile(99), (uint)stats.max_us);
+	}
+
+	if (argc == 2) ResetPathfinderStats();
+	return true;
+}
+
 /*******************************
  * console command registration
  *******************************/
@@ -2058,6 +2192,12 @@ void IConsoleStdLibRegister()
 #endif
 	IConsoleCmdRegister("fps",     ConFramerate);
 	IConsoleCmdRegister("fps_wnd", ConFramerateWindow);
+	IConsoleCmdRegister("linkgraph_benchmark", ConLinkGraphBenchmark);
+	IConsoleCmdRegister("linkgraph_compare", ConLinkGraphCompare);
+	IConsoleCmdRegister("closest_town_benchmark", ConClosestTownBenchmark);
+	IConsoleCmdRegister("map_layout_benchmark", ConMapLayoutBenchmark);
+	IConsoleCmdRegister("yapf_cache", ConYapfCache);
+	IConsoleCmdRegister("pfstats",    ConPathfinderStats);
 
 	/* NewGRF development stuff */
 	IConsoleCmdRegister("reload_newgrfs",  ConNewGRFReload, ConHookNewGRFDeveloperTool);
@@ -0,0 +1,342 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file kdtree.hpp K-d tree template specialised for 2-dimensional Manhattan geometry */
+
+#ifndef KDTREE_HPP
+#define KDTREE_HPP
+
+#include "math_func.hpp"
+#include <vector>
+#include <algorithm>
+
+/**
+ * K-dimensional tree, specialised for 2-dimensional space.
+ * The tree is balanced when it is built; inserted elements are added as
+ * leaves and the whole tree is rebuilt when too many of them accumulated.
+ * Removing an element rebuilds the subtree below it.
+ *
+ * The shape of the tree depends on the history of insertions and removals,
+ * so the order in which FindContained reports elements is not stable between
+ * e.g. a server and a client that just loaded the game. Callers that affect
+ * the game state must not depend on that order. FindNearest is stable, as
+ * ties are broken by the smallest element.
+ *
+ * @tparam T       Type stored in the tree; should be cheap to copy and have a total order.
+ * @tparam TxyFunc Functor type, returning the x (dim = 0) or y (dim = 1) coordinate of an element.
+ * @tparam CoordT  Type of coordinates.
+ * @tparam DistT   Type of (Manhattan) distances.
+ */
+template <typename T, typename TxyFunc, typename CoordT, typename DistT>
+class Kdtree {
+	/** A node in the tree, also holding one element. */
+	struct Node {
+		T element;    ///< Element stored at this node.
+		size_t left;  ///< Index of the node with smaller coordinates on the split axis.
+		size_t right; ///< Index of the node with larger or equal coordinates on the split axis.
+	};
+
+	static const size_t INVALID_NODE = SIZE_MAX; ///< Index of "no node".
+
+	std::vector<Node> nodes;       ///< Storage of all nodes, including unused ones.
+	std::vector<size_t> free_list; ///< Indices of unused nodes in #nodes.
+	size_t root;                   ///< Index of the root node.
+	size_t count;                  ///< Number of elements in the tree.
+	size_t unbalanced;             ///< Number of insertions since the last full build.
+	TxyFunc xyfunc;                ///< Functor giving the coordinates of an element.
+
+	/** Comparator of elements on a single axis, used while building. */
+	struct AxisCompare {
+		const TxyFunc &xyfunc; ///< Functor giving the coordinates of an element.
+		int dim;               ///< Axis to compare on.
+
+		AxisCompare(const TxyFunc &xyfunc, int dim) : xyfunc(xyfunc), dim(dim) {}
+
+		bool operator()(const T &a, const T &b) const
+		{
+			return this->xyfunc(a, this->dim) < this->xyfunc(b, this->dim);
+		}
+	};
+
+	/**
+	 * Get an unused node, and store an element in it.
+	 * @param element The element to store.
+	 * @return Index of the node.
+	 */
+	size_t AddNode(const T &element)
+	{
+		Node n = { element, INVALID_NODE, INVALID_NODE };
+		if (this->free_list.empty()) {
+			this->nodes.push_back(n);
+			return this->nodes.size() - 1;
+		}
+		size_t idx = this->free_list.back();
+		this->free_list.pop_back();
+		this->nodes[idx] = n;
+		return idx;
+	}
+
+	/**
+	 * Build a balanced subtree from a range of elements.
+	 * @param begin First element of the range; the range gets reordered.
+	 * @param end   One past the last element of the range.
+	 * @param level Depth of the subtree root, determining its split axis.
+	 * @return Index of the subtree root.
+	 */
+	size_t BuildSubtree(T *begin, T *end, int level)
+	{
+		if (begin == end) return INVALID_NODE;
+
+		T *mid = begin + (end - begin) / 2;
+		std::nth_element(begin, mid, end, AxisCompare(this->xyfunc, level % 2));
+		size_t idx = this->AddNode(*mid);
+		size_t left = this->BuildSubtree(begin, mid, level + 1);
+		size_t right = this->BuildSubtree(mid + 1, end, level + 1);
+		this->nodes[idx].left = left;
+		this->nodes[idx].right = right;
+		return idx;
+	}
+
+	/**
+	 * Collect all elements of a subtree and release its nodes.
+	 * @param node_idx Root of the subtree.
+	 * @param elements Vector to add the elements to.
+	 */
+	void ReleaseSubtree(size_t node_idx, std::vector<T> &elements)
+	{
+		if (node_idx == INVALID_NODE) return;
+		const Node n = this->nodes[node_idx];
+		elements.push_back(n.element);
+		this->free_list.push_back(node_idx);
+		this->ReleaseSubtree(n.left, elements);
+		this->ReleaseSubtree(n.right, elements);
+	}
+
+	/** Rebuild the whole tree from its elements. */
+	void Rebuild()
+	{
+		std::vector<T> elements;
+		elements.reserve(this->count);
+		this->ReleaseSubtree(this->root, elements);
+		this->Build(elements.begin(), elements.end());
+	}
+
+	/**
+	 * Remove an element from a subtree.
+	 * @param element  The element to remove.
+	 * @param node_idx Root of the subtree.
+	 * @param level    Depth of the subtree root.
+	 * @param[out] new_root Root of the subtree after removal.
+	 * @return True if the element was found and removed.
+	 */
+	bool RemoveRecursive(const T &element, size_t node_idx, int level, size_t &new_root)
+	{
+		new_root = node_idx;
+		if (node_idx == INVALID_NODE) return false;
+
+		Node &n = this->nodes[node_idx];
+		if (n.element == element) {
+			/* Rebuild the subtree below the removed node. */
+			std::vector<T> elements;
+			this->ReleaseSubtree(n.left, elements);
+			this->ReleaseSubtree(this->nodes[node_idx].right, elements);
+			this->free_list.push_back(node_idx);
+			new_root = elements.empty() ? INVALID_NODE : this->BuildSubtree(&elements[0], &elements[0] + elements.size(), level);
+			return true;
+		}
+
+		int dim = level % 2;
+		CoordT ec = this->xyfunc(element, dim);
+		CoordT nc = this->xyfunc(n.element, dim);
+		size_t sub;
+		/* Equal coordinates may end up on either side of the split while building. */
+		if (ec <= nc && this->RemoveRecursive(element, this->nodes[node_idx].left, level + 1, sub)) {
+			this->nodes[node_idx].left = sub;
+			return true;
+		}
+		if (ec >= nc && this->RemoveRecursive(element, this->nodes[node_idx].right, level + 1, sub)) {
+			this->nodes[node_idx].right = sub;
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Find the nearest element in a subtree.
+	 * @param xy        Coordinates to search around.
+	 * @param node_idx  Root of the subtree.
+	 * @param level     Depth of the subtree root.
+	 * @param[in,out] best      Best element found so far.
+	 * @param[in,out] best_dist Distance of \a best, or the exclusive limit when nothing is found yet.
+	 * @param[in,out] found     Whether \a best is valid.
+	 */
+	void FindNearestRecursive(const CoordT xy[2], size_t node_idx, int level, T &best, DistT &best_dist, bool &found) const
+	{
+		if (node_idx == INVALID_NODE) return;
+		const Node &n = this->nodes[node_idx];
+
+		CoordT ex = this->xyfunc(n.element, 0);
+		CoordT ey = this->xyfunc(n.element, 1);
+		DistT dist = (DistT)Delta(xy[0], ex) + (DistT)Delta(xy[1], ey);
+		if (dist < best_dist || (found && dist == best_dist && n.element < best)) {
+			best = n.element;
+			best_dist = dist;
+			found = true;
+		}
+
+		int dim = level % 2;
+		CoordT split = this->xyfunc(n.element, dim);
+		size_t near_side = xy[dim] < split ? n.left : n.right;
+		size_t far_side = xy[dim] < split ? n.right : n.left;
+		this->FindNearestRecursive(xy, near_side, level + 1, best, best_dist, found);
+		/* Only the distance on the split axis is known for elements on the other side. */
+		if ((DistT)Delta(xy[dim], split) <= best_dist) this->FindNearestRecursive(xy, far_side, level + 1, best, best_dist, found);
+	}
+
+	/**
+	 * Report all elements of a subtree within a rectangle.
+	 * @param p1        Smallest coordinates of the rectangle (inclusive).
+	 * @param p2        Largest coordinates of the rectangle (inclusive).
+	 * @param node_idx  Root of the subtree.
+	 * @param level     Depth of the subtree root.
+	 * @param outputter Functor called for each found element.
+	 */
+	template <typename Outputter>
+	void FindContainedRecursive(const CoordT p1[2], const CoordT p2[2], size_t node_idx, int level, Outputter &outputter) const
+	{
+		if (node_idx == INVALID_NODE) return;
+		const Node &n = this->nodes[node_idx];
+
+		CoordT ex = this->xyfunc(n.element, 0);
+		CoordT ey = this->xyfunc(n.element, 1);
+		if (p1[0] <= ex && ex <= p2[0] && p1[1] <= ey && ey <= p2[1]) outputter(n.element);
+
+		int dim = level % 2;
+		CoordT split = this->xyfunc(n.element, dim);
+		if (p1[dim] <= split) this->FindContainedRecursive(p1, p2, n.left, level + 1, outputter);
+		if (p2[dim] >= split) this->FindContainedRecursive(p1, p2, n.right, level + 1, outputter);
+	}
+
+public:
+	/** Construct an empty tree. */
+	Kdtree(TxyFunc xyfunc = TxyFunc()) : root(INVALID_NODE), count(0), unbalanced(0), xyfunc(xyfunc) {}
+
+	/**
+	 * Replace the contents of the tree by a balanced tree of the given elements.
+	 * @param begin Iterator to the first element.
+	 * @param end   Iterator to one past the last element.
+	 */
+	template <typename It>
+	void Build(It begin, It end)
+	{
+		std::vector<T> elements(begin, end);
+		this->Clear();
+		this->nodes.reserve(elements.size());
+		this->count = elements.size();
+		if (!elements.empty()) this->root = this->BuildSubtree(&elements[0], &elements[0] + elements.size(), 0);
+	}
+
+	/** Remove all elements from the tree. */
+	void Clear()
+	{
+		this->nodes.clear();
+		this->free_list.clear();
+		this->root = INVALID_NODE;
+		this->count = 0;
+		this->unbalanced = 0;
+	}
+
+	/**
+	 * Insert an element into the tree.
+	 * @param element The element to insert; it must not be in the tree yet.
+	 */
+	void Insert(const T &element)
+	{
+		size_t idx = this->AddNode(element);
+		this->count++;
+		if (this->root == INVALID_NODE) {
+			this->root = idx;
+			return;
+		}
+
+		size_t node_idx = this->root;
+		for (int level = 0;; level++) {
+			int dim = level % 2;
+			Node &n = this->nodes[node_idx];
+			size_t &next = this->xyfunc(element, dim) < this->xyfunc(n.element, dim) ? n.left : n.right;
+			if (next == INVALID_NODE) {
+				next = idx;
+				break;
+			}
+			node_idx = next;
+		}
+
+		/* Keep the tree reasonably balanced. */
+		if (++this->unbalanced > this->count / 4 + 16) this->Rebuild();
+	}
+
+	/**
+	 * Remove an element from the tree, if present.
+	 * @param element The element to remove; it must have the coordinates it was inserted with.
+	 * @return True if the element was found and removed.
+	 */
+	bool Remove(const T &element)
+	{
+		size_t new_root;
+		if (!this->RemoveRecursive(element, this->root, 0, new_root)) return false;
+		this->root = new_root;
+		this->count--;
+		return true;
+	}
+
+	/**
+	 * Get the number of elements in the tree.
+	 * @return The number of elements.
+	 */
+	size_t Count() const
+	{
+		return this->count;
+	}
+
+	/**
+	 * Find the element nearest to a point, by Manhattan distance. Of elements
+	 * at equal distance the smallest one is returned.
+	 * @param x     X coordinate of the point.
+	 * @param y     Y coordinate of the point.
+	 * @param limit Only elements closer than this are considered.
+	 * @param[out] result The nearest element, if any.
+	 * @return True if an element closer than \a limit exists.
+	 */
+	bool FindNearest(CoordT x, CoordT y, DistT limit, T *result) const
+	{
+		const CoordT xy[2] = { x, y };
+		bool found = false;
+		this->FindNearestRecursive(xy, this->root, 0, *result, limit, found);
+		return found;
+	}
+
+	/**
+	 * Find all elements within a rectangle. The order in which the elements
+	 * are reported depends on the shape of the tree.
+	 * @param x1        Smallest x coordinate of the rectangle (inclusive).
+	 * @param y1        Smallest y coordinate of the rectangle (inclusive).
+	 * @param x2        Largest x coordinate of the rectangle (inclusive).
+	 * @param y2        Largest y coordinate of the rectangle (inclusive).
+	 * @param outputter Functor called with each element within the rectangle.
+	 */
+	template <typename Outputter>
+	void FindContained(CoordT x1, CoordT y1, CoordT x2, CoordT y2, Outputter outputter) const
+	{
+		const CoordT p1[2] = { x1, y1 };
+		const CoordT p2[2] = { x2, y2 };
+		this->FindContainedRecursive(p1, p2, this->root, 0, outputter);
+	}
+};
+
+#endif /* KDTREE_HPP */
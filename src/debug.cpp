@@ -45,6 +45,7 @@ int _debug_sl_level;
 int _debug_gamelog_level;
 int _debug_desync_level;
 int _debug_console_level;
+int _debug_linkgraph_level;
 #ifdef RANDOM_DEBUG
 int _debug_random_level;
 #endif
@@ -73,6 +74,7 @@ struct DebugLevel {
 	DEBUG_LEVEL(gamelog),
 	DEBUG_LEVEL(desync),
 	DEBUG_LEVEL(console),
+	DEBUG_LEVEL(linkgraph),
 #ifdef RANDOM_DEBUG
 	DEBUG_LEVEL(random),
 #endif
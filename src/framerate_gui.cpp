@@ -174,10 +174,17 @@ namespace {
 		PerformanceData(GL_RATE),               // PFE_GAMELOOP
 		PerformanceData(1),                     // PFE_ACC_GL_ECONOMY
 		PerformanceData(1),                     // PFE_ACC_GL_TRAINS
+		PerformanceData(1),                     // PFE_ACC_GL_PF_TRAINS
 		PerformanceData(1),                     // PFE_ACC_GL_ROADVEHS
+		PerformanceData(1),                     // PFE_ACC_GL_PF_ROADVEHS
 		PerformanceData(1),                     // PFE_ACC_GL_SHIPS
+		PerformanceData(1),                     // PFE_ACC_GL_PF_SHIPS
 		PerformanceData(1),                     // PFE_ACC_GL_AIRCRAFT
 		PerformanceData(1),                     // PFE_GL_LANDSCAPE
+		PerformanceData(1),                     // PFE_GL_TILE_CLEAR
+		PerformanceData(1),                     // PFE_GL_TILE_TREES
+		PerformanceData(1),                     // PFE_GL_TILE_WATER
+		PerformanceData(1),                     // PFE_GL_TILE_HOUSES
 		PerformanceData(1),                     // PFE_GL_LINKGRAPH
 		PerformanceData(GL_RATE),               // PFE_DRAWING
 		PerformanceData(1),                     // PFE_ACC_DRAWWORLD
@@ -820,10 +827,17 @@ void ConPrintFramerate()
 		"Game loop",
 		"  GL station ticks",
 		"  GL train ticks",
+		"    GL train pathfinding",
 		"  GL road vehicle ticks",
+		"    GL road vehicle pathfinding",
 		"  GL ship ticks",
+		"    GL ship pathfinding",
 		"  GL aircraft ticks",
 		"  GL landscape ticks",
+		"    GL clear tile loop",
+		"    GL tree tile loop",
+		"    GL water tile loop",
+		"    GL house tile loop",
 		"  GL link graph delays",
 		"Drawing",
 		"  Viewport drawing",
@@ -51,10 +51,17 @@ enum PerformanceElement {
 	PFE_GAMELOOP = 0,  ///< Speed of gameloop processing.
 	PFE_GL_ECONOMY,    ///< Time spent processing cargo movement
 	PFE_GL_TRAINS,     ///< Time spent processing trains
+	PFE_GL_PF_TRAINS,  ///< Time spent in the pathfinder for trains
 	PFE_GL_ROADVEHS,   ///< Time spend processing road vehicles
+	PFE_GL_PF_ROADVEHS, ///< Time spent in the pathfinder for road vehicles
 	PFE_GL_SHIPS,      ///< Time spent processing ships
+	PFE_GL_PF_SHIPS,   ///< Time spent in the pathfinder for ships
 	PFE_GL_AIRCRAFT,   ///< Time spent processing aircraft
 	PFE_GL_LANDSCAPE,  ///< Time spent processing other world features
+	PFE_GL_TILE_CLEAR, ///< Time spent in the tile loop of clear tiles, when it is batched
+	PFE_GL_TILE_TREES, ///< Time spent in the tile loop of tree tiles, when it is batched
+	PFE_GL_TILE_WATER, ///< Time spent in the tile loop of water tiles, when it is batched
+	PFE_GL_TILE_HOUSES, ///< Time spent in the tile loop of houses, when it is batched
 	PFE_GL_LINKGRAPH,  ///< Time spent waiting for link graph background jobs
 	PFE_DRAWING,       ///< Speed of drawing world and GUI.
 	PFE_DRAWWORLD,     ///< Time spent drawing world viewports in GUI
@@ -17,7 +17,7 @@
 #include "subsidy_type.h"
 #include "industry_map.h"
 #include "industrytype.h"
-#include "tilearea_type.h"
+#include "tilearea_index.h"
 
 
 typedef Pool<Industry, IndustryID, 64, 64000> IndustryPool;
@@ -199,4 +199,7 @@ struct IndustryBuildData {
 
 extern IndustryBuildData _industry_builder;
 
+extern TileAreaIndex<IndustryID> _industry_area_index;
+void RebuildIndustryAreaIndex();
+
 #endif /* INDUSTRY_H */
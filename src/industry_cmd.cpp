@@ -62,6 +62,7 @@ uint16 Industry::counts[NUM_INDUSTRYTYPES];
 IndustrySpec _industry_specs[NUM_INDUSTRYTYPES];
 IndustryTileSpec _industry_tile_specs[NUM_INDUSTRYTILES];
 IndustryBuildData _industry_builder; ///< In-game manager of industries.
+TileAreaIndex<IndustryID> _industry_area_index; ///< Index of the locations of all industries.
 
 /**
  * This function initialize the spec arrays of both
@@ -142,6 +143,8 @@ Industry::~Industry()
 	 * Also we must not decrement industry counts in that case. */
 	if (this->location.w == 0) return;
 
+	_industry_area_index.Remove(this->index, this->location);
+
 	TILE_AREA_LOOP(tile_cur, this->location) {
 		if (IsTileType(tile_cur, MP_INDUSTRY)) {
 			if (GetIndustryIndex(tile_cur) == this->index) {
@@ -184,6 +187,17 @@ Industry::~Industry()
 	CargoPacket::InvalidateAllFrom(ST_INDUSTRY, this->index);
 }
 
+/**
+ * Rebuild the index of industry locations, e.g. after loading a game.
+ */
+void RebuildIndustryAreaIndex()
+{
+	_industry_area_index.Reset();
+
+	const Industry *i;
+	FOR_ALL_INDUSTRIES(i) _industry_area_index.Add(i->index, i->location);
+}
+
 /**
  * Invalidating some stuff after removing item from the pool.
  * @param index index of deleted item
@@ -1812,6 +1826,8 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 		}
 	} while ((++it)->ti.x != -0x80);
 
+	_industry_area_index.Add(i->index, i->location);
+
 	if (GetIndustrySpec(i->type)->behaviour & INDUSTRYBEH_PLANT_ON_BUILT) {
 		for (uint j = 0; j != 50; j++) PlantRandomFarmField(i);
 	}
@@ -2900,4 +2916,5 @@ extern const TileTypeProcs _tile_type_industry_procs = {
 	NULL,                        // vehicle_enter_tile_proc
 	GetFoundation_Industry,      // get_foundation_proc
 	TerraformTile_Industry,      // terraform_tile_proc
+	NULL,                        // tile_loop_batch_proc
 };
@@ -14,6 +14,7 @@
 
 #include "industrytype.h"
 #include "water_map.h"
+#include "animated_tile_func.h"
 
 
 /**
@@ -153,6 +154,7 @@ static inline void SetIndustryGfx(TileIndex t, IndustryGfx gfx)
 	assert(IsTileType(t, MP_INDUSTRY));
 	_m[t].m5 = GB(gfx, 0, 8);
 	SB(_me[t].m6, 2, 1, GB(gfx, 8, 1));
+	ResetAnimatedTileSpeed(t);
 }
 
 /**
@@ -797,12 +797,51 @@ CommandCost CmdClearArea(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 
 TileIndex _cur_tileloop_tile;
 
+/**
+ * Run the tile loop on the tiles gathered by RunTileLoop, one tile type after
+ * the other. The tiles of each type are visited in the order they were gathered.
+ * @param batches The tiles of this tick, by their type.
+ */
+static void RunTileLoopBatches(SmallVector<TileIndex, 256> *batches)
+{
+	/* Elements measuring the tile types with a batch proc. */
+	static const PerformanceElement elements[] = {
+		PFE_GL_TILE_CLEAR, PFE_MAX, PFE_MAX, PFE_GL_TILE_HOUSES, PFE_GL_TILE_TREES, PFE_MAX, PFE_GL_TILE_WATER, PFE_MAX, PFE_MAX, PFE_MAX, PFE_MAX,
+	};
+	assert_compile(lengthof(elements) == MP_OBJECT + 1);
+
+	for (uint type = 0; type < lengthof(elements); type++) {
+		SmallVector<TileIndex, 256> &batch = batches[type];
+		if (batch.Length() == 0) continue;
+
+		TileLoopBatchProc *proc = _tile_type_procs[type]->tile_loop_batch_proc;
+		if (proc != NULL) {
+			PerformanceAccumulator framerate(elements[type]);
+			proc(batch.Begin(), batch.Length());
+		} else {
+			for (const TileIndex *tile = batch.Begin(); tile != batch.End(); tile++) {
+				_tile_type_procs[GetTileType(*tile)]->tile_loop_proc(*tile);
+			}
+		}
+		batch.Clear();
+	}
+}
+
 /**
  * Gradually iterate over all tiles on the map, calling their TileLoopProcs once every 256 ticks.
+ * With economy.tile_loop_batching the tiles of a tick are first grouped by their type.
  */
 void RunTileLoop()
 {
 	PerformanceAccumulator framerate(PFE_GL_LANDSCAPE);
+	PerformanceAccumulator::Reset(PFE_GL_TILE_CLEAR);
+	PerformanceAccumulator::Reset(PFE_GL_TILE_TREES);
+	PerformanceAccumulator::Reset(PFE_GL_TILE_WATER);
+	PerformanceAccumulator::Reset(PFE_GL_TILE_HOUSES);
+
+	/* Tiles of this tick by type, when batching. */
+	static SmallVector<TileIndex, 256> batches[MP_OBJECT + 1];
+	bool batched = _settings_game.economy.tile_loop_batching;
 
 	/* The pseudorandom sequence of tiles is generated using a Galois linear feedback
 	 * shift register (LFSR). This allows a deterministic pseudorandom ordering, but
@@ -825,18 +864,28 @@ void RunTileLoop()
 
 	/* Manually update tile 0 every 256 ticks - the LFSR never iterates over it itself.  */
 	if (_tick_counter % 256 == 0) {
-		_tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
+		if (batched) {
+			*batches[GetTileType(0)].Append() = 0;
+		} else {
+			_tile_type_procs[GetTileType(0)]->tile_loop_proc(0);
+		}
 		count--;
 	}
 
 	while (count--) {
-		_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+		if (batched) {
+			*batches[GetTileType(tile)].Append() = tile;
+		} else {
+			_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+		}
 
 		/* Get the next tile in sequence using a Galois LFSR. */
 		tile = (tile >> 1) ^ (-(int32)(tile & 1) & feedback);
 	}
 
 	_cur_tileloop_tile = tile;
+
+	if (batched) RunTileLoopBatches(batches);
 }
 
 void InitializeLandscape()
@@ -1152,6 +1201,9 @@ static uint River_Hash(uint tile, uint dir)
 	return GB(TileHash(TileX(tile), TileY(tile)), 0, RIVER_HASH_SIZE);
 }
 
+/** The AyStar building all rivers, so its memory is reused between rivers. */
+static AyStar _river_finder;
+
 /**
  * Actually build the river between the begin and end tiles using AyStar.
  * @param begin The begin of the river.
@@ -1159,22 +1211,19 @@ static uint River_Hash(uint tile, uint dir)
  */
 static void BuildRiver(TileIndex begin, TileIndex end)
 {
-	AyStar finder = {};
-	finder.CalculateG = River_CalculateG;
-	finder.CalculateH = River_CalculateH;
-	finder.GetNeighbours = River_GetNeighbours;
-	finder.EndNodeCheck = River_EndNodeCheck;
-	finder.FoundEndNode = River_FoundEndNode;
-	finder.user_target = &end;
-
-	finder.Init(River_Hash, 1 << RIVER_HASH_SIZE);
+	_river_finder.user_target = &end;
 
 	AyStarNode start;
 	start.tile = begin;
 	start.direction = INVALID_TRACKDIR;
-	finder.AddStartNode(&start, 0);
-	finder.Main();
-	finder.Free();
+	_river_finder.AddStartNode(&start, 0);
+	_river_finder.Main();
+}
+
+/** Free the memory of the river builder, also when generating the world is aborted while building rivers. */
+static void FreeRiverFinder()
+{
+	_river_finder.Free();
 }
 
 /**
@@ -1270,6 +1319,14 @@ static void CreateRivers()
 	uint wells = ScaleByMapSize(4 << _settings_game.game_creation.amount_of_rivers);
 	SetGeneratingWorldProgress(GWP_RIVER, wells + 256 / 64); // Include the tile loop calls below.
 
+	_river_finder.CalculateG = River_CalculateG;
+	_river_finder.CalculateH = River_CalculateH;
+	_river_finder.GetNeighbours = River_GetNeighbours;
+	_river_finder.EndNodeCheck = River_EndNodeCheck;
+	_river_finder.FoundEndNode = River_FoundEndNode;
+	_river_finder.Init(River_Hash, 1 << RIVER_HASH_SIZE);
+	GenerateWorldSetAbortCallback(FreeRiverFinder);
+
 	for (; wells != 0; wells--) {
 		IncreaseGeneratingWorldProgress(GWP_RIVER);
 		for (int tries = 0; tries < 128; tries++) {
@@ -1279,6 +1336,9 @@ static void CreateRivers()
 		}
 	}
 
+	FreeRiverFinder();
+	GenerateWorldSetAbortCallback(NULL);
+
 	/* Run tile loop to update the ground density. */
 	for (uint i = 0; i != 256; i++) {
 		if (i % 64 == 0) IncreaseGeneratingWorldProgress(GWP_RIVER);
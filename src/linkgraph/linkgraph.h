@@ -458,12 +458,12 @@ public:
 	}
 
 	/** Bare constructor, only for save/load. */
-	LinkGraph() : cargo(INVALID_CARGO), last_compression(0) {}
+	LinkGraph() : cargo(INVALID_CARGO), last_compression(0), last_job_runtime(0) {}
 	/**
 	 * Real constructor.
 	 * @param cargo Cargo the link graph is about.
 	 */
-	LinkGraph(CargoID cargo) : cargo(cargo), last_compression(_date) {}
+	LinkGraph(CargoID cargo) : cargo(cargo), last_compression(_date), last_job_runtime(0) {}
 
 	void Init(uint size);
 	void ShiftDates(int interval);
@@ -504,6 +504,18 @@ public:
 	 */
 	inline Date LastCompression() const { return this->last_compression; }
 
+	/**
+	 * Get how long the handlers took for the last job of this component.
+	 * @return Runtime in milliseconds, 0 if unknown.
+	 */
+	inline uint32 LastJobRuntime() const { return this->last_job_runtime; }
+
+	/**
+	 * Record how long the handlers took for a job of this component.
+	 * @param runtime Runtime in milliseconds.
+	 */
+	inline void SetLastJobRuntime(uint32 runtime) { this->last_job_runtime = runtime; }
+
 	/**
 	 * Get the cargo ID this component's link graph refers to.
 	 * @return Cargo ID.
@@ -532,6 +544,7 @@ protected:
 
 	CargoID cargo;         ///< Cargo of this component's link graph.
 	Date last_compression; ///< Last time the capacities and supplies were compressed.
+	uint32 last_job_runtime; ///< Milliseconds the handlers took for the last job, as measured on this machine. Not saved.
 	NodeVector nodes;      ///< Nodes in the component.
 	EdgeMatrix edges;      ///< Edges in the component.
 };
@@ -14,6 +14,10 @@
 #include "../window_func.h"
 #include "linkgraphjob.h"
 #include "linkgraphschedule.h"
+#include "../thread/thread_pool.h"
+#include "../settings_type.h"
+#include "../debug.h"
+#include <chrono>
 
 #include "../safeguards.h"
 
@@ -21,6 +25,10 @@
 LinkGraphJobPool _link_graph_job_pool("LinkGraphJob");
 INSTANTIATE_POOL_METHODS(LinkGraphJob)
 
+static ThreadPool _link_graph_workers("ottd:linkgraph");           ///< Threads running the link graph jobs.
+static ThreadMutex *_link_graph_job_mutex = ThreadMutex::New();    ///< Guards #_pending_link_graph_jobs and LinkGraphJob::finished.
+static SmallVector<LinkGraphJob *, 8> _pending_link_graph_jobs;    ///< Spawned jobs no worker has started yet.
+
 /**
  * Static instance of an invalid path.
  * Note: This instance is created on task start.
@@ -33,14 +41,19 @@ INSTANTIATE_POOL_METHODS(LinkGraphJob)
  * that the calculations don't interfer with the normal operations on the
  * original. The job is immediately started.
  * @param orig Original LinkGraph to be copied.
+ * @param settings Link graph settings to run the job with.
  */
-LinkGraphJob::LinkGraphJob(const LinkGraph &orig) :
+LinkGraphJob::LinkGraphJob(const LinkGraph &orig, const LinkGraphSettings &settings) :
 		/* Copying the link graph here also copies its index member.
 		 * This is on purpose. */
 		link_graph(orig),
-		settings(_settings_game.linkgraph),
-		thread(NULL),
-		join_date(_date + _settings_game.linkgraph.recalc_time)
+		settings(settings),
+		spawned(false),
+		finished(false),
+		aborted(false),
+		progress(0),
+		runtime(0),
+		join_date(_date + settings.recalc_time)
 {
 }
 
@@ -56,34 +69,157 @@ void LinkGraphJob::EraseFlows(NodeID from)
 }
 
 /**
- * Spawn a thread if possible and run the link graph job in the thread. If
- * that's not possible run the job right now in the current thread.
+ * Hand the job to the link graph workers. The workers run the spawned jobs
+ * concurrently, largest first. If there are no threads the job is run right
+ * now in the current thread.
  */
 void LinkGraphJob::SpawnThread()
 {
-	if (!ThreadObject::New(&(LinkGraphSchedule::Run), this, &this->thread, "ottd:linkgraph")) {
-		this->thread = NULL;
-		/* Of course this will hang a bit.
-		 * On the other hand, if you want to play games which make this hang noticably
-		 * on a platform without threads then you'll probably get other problems first.
-		 * OK:
-		 * If someone comes and tells me that this hangs for him/her, I'll implement a
-		 * smaller grained "Step" method for all handlers and add some more ticks where
-		 * "Step" is called. No problem in principle. */
-		LinkGraphSchedule::Run(this);
-	}
+	/* Changing the number of workers waits for the jobs that were spawned already. */
+	uint threads = _settings_client.gui.linkgraph_threads;
+	_link_graph_workers.SetWorkerCount(threads != 0 ? threads : max(GetCPUCoreCount(), 2U) - 1);
+
+	this->spawned = true;
+	this->finished = false;
+	this->progress = 0;
+	_link_graph_job_mutex->BeginCritical();
+	*_pending_link_graph_jobs.Append() = this;
+	_link_graph_job_mutex->EndCritical();
+
+	/* Of course this will hang a bit without threads.
+	 * On the other hand, if you want to play games which make this hang noticably
+	 * on a platform without threads then you'll probably get other problems first. */
+	_link_graph_workers.Enqueue(&LinkGraphJob::RunLargestPending, NULL);
 }
 
 /**
- * Join the calling thread with this job's thread if threading is enabled.
+ * Wait until the handlers are done with the job. A job no worker has started
+ * yet is run in the calling thread instead of waiting for a free worker.
  */
 void LinkGraphJob::JoinThread()
 {
-	if (this->thread != NULL) {
-		this->thread->Join();
-		delete this->thread;
-		this->thread = NULL;
+	if (!this->spawned) return;
+	this->spawned = false;
+
+	_link_graph_job_mutex->BeginCritical();
+	LinkGraphJob **pending = _pending_link_graph_jobs.Find(this);
+	if (pending != _pending_link_graph_jobs.End()) {
+		_pending_link_graph_jobs.Erase(pending);
+		_link_graph_job_mutex->EndCritical();
+		this->Run();
+		return;
 	}
+	while (!this->finished) _link_graph_job_mutex->WaitForSignal();
+	_link_graph_job_mutex->EndCritical();
+}
+
+/**
+ * Run all handlers on the job and mark it as finished.
+ */
+void LinkGraphJob::Run()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	LinkGraphSchedule::Run(this);
+	uint32 runtime = (uint32)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	if (this->IsAborted()) {
+		/* The handlers stopped early; free the paths the flow mappers would have freed. */
+		for (NodeAnnotation *node = this->nodes.Begin(); node != this->nodes.End(); node++) {
+			for (PathList::iterator i = node->paths.begin(); i != node->paths.end(); ++i) delete *i;
+			node->paths.clear();
+		}
+		DEBUG(linkgraph, 2, "Job for link graph %u with %u nodes aborted after %u handlers", this->link_graph.index, this->Size(), this->GetProgress());
+	} else {
+		DEBUG(linkgraph, 2, "Job for link graph %u with %u nodes took %u ms", this->link_graph.index, this->Size(), runtime);
+	}
+
+	ThreadMutexLocker lock(_link_graph_job_mutex);
+	this->runtime = runtime;
+	this->finished = true;
+	_link_graph_job_mutex->SendSignal();
+}
+
+/**
+ * Tell the handlers to stop working on the job at the next safe point, as its
+ * results are not going to be used. The job still has to be joined.
+ */
+void LinkGraphJob::Abort()
+{
+	ThreadMutexLocker lock(_link_graph_job_mutex);
+	this->aborted = true;
+}
+
+/**
+ * Check whether the job has been aborted. The handlers check this between
+ * each other.
+ * @return True if the remaining handlers should be skipped.
+ */
+bool LinkGraphJob::IsAborted() const
+{
+	ThreadMutexLocker lock(_link_graph_job_mutex);
+	return this->aborted;
+}
+
+/**
+ * Record that another handler is done with the job.
+ * @param progress Number of handlers that are done.
+ */
+void LinkGraphJob::SetProgress(uint progress)
+{
+	ThreadMutexLocker lock(_link_graph_job_mutex);
+	this->progress = progress;
+}
+
+/**
+ * Get the number of handlers that are done with the job.
+ * @return Number of handlers done.
+ */
+uint LinkGraphJob::GetProgress() const
+{
+	ThreadMutexLocker lock(_link_graph_job_mutex);
+	return this->progress;
+}
+
+/**
+ * Get how long the handlers took for the job.
+ * @return Runtime in milliseconds, 0 if the job isn't done.
+ */
+uint32 LinkGraphJob::GetRuntime() const
+{
+	ThreadMutexLocker lock(_link_graph_job_mutex);
+	return this->runtime;
+}
+
+/**
+ * Check whether the handlers are done with the job, so joining it won't block.
+ * @return True if the job has been run completely.
+ */
+bool LinkGraphJob::IsDone() const
+{
+	ThreadMutexLocker lock(_link_graph_job_mutex);
+	return this->finished;
+}
+
+/**
+ * Task for the link graph workers: run the largest job no one has started yet.
+ * There is one task per spawned job, but a joined job might have been run by
+ * the joining thread already, leaving nothing to do.
+ */
+/* static */ void LinkGraphJob::RunLargestPending(void *)
+{
+	_link_graph_job_mutex->BeginCritical();
+	if (_pending_link_graph_jobs.Length() == 0) {
+		_link_graph_job_mutex->EndCritical();
+		return;
+	}
+	LinkGraphJob **largest = _pending_link_graph_jobs.Begin();
+	for (LinkGraphJob **it = largest + 1; it != _pending_link_graph_jobs.End(); it++) {
+		if ((*it)->Size() > (*largest)->Size()) largest = it;
+	}
+	LinkGraphJob *job = *largest;
+	_pending_link_graph_jobs.Erase(largest);
+	_link_graph_job_mutex->EndCritical();
+
+	job->Run();
 }
 
 /**
@@ -12,7 +12,6 @@
 #ifndef LINKGRAPHJOB_H
 #define LINKGRAPHJOB_H
 
-#include "../thread/thread.h"
 #include "linkgraph.h"
 #include <list>
 
@@ -59,7 +58,11 @@ private:
 protected:
 	const LinkGraph link_graph;       ///< Link graph to by analyzed. Is copied when job is started and mustn't be modified later.
 	const LinkGraphSettings settings; ///< Copy of _settings_game.linkgraph at spawn time.
-	ThreadObject *thread;             ///< Thread the job is running in or NULL if it's running in the main thread.
+	bool spawned;                     ///< Whether the job has been handed to the link graph workers and not been joined yet.
+	bool finished;                    ///< Whether the handlers are done with the job. Guarded by the mutex of the workers.
+	bool aborted;                     ///< Whether the results of the job aren't needed anymore. Guarded by the mutex of the workers.
+	uint8 progress;                   ///< Number of handlers that are done with the job. Guarded by the mutex of the workers.
+	uint32 runtime;                   ///< Milliseconds the handlers took for the job. Guarded by the mutex of the workers.
 	Date join_date;                   ///< Date when the job is to be joined.
 	NodeAnnotationVector nodes;       ///< Extra node data necessary for link graph calculation.
 	EdgeAnnotationMatrix edges;       ///< Extra edge data necessary for link graph calculation.
@@ -67,6 +70,11 @@ protected:
 	void EraseFlows(NodeID from);
 	void JoinThread();
 	void SpawnThread();
+	void Run();
+	void Abort();
+	void SetProgress(uint progress);
+
+	static void RunLargestPending(void *);
 
 public:
 
@@ -266,10 +274,10 @@ public:
 	 * Bare constructor, only for save/load. link_graph, join_date and actually
 	 * settings have to be brutally const-casted in order to populate them.
 	 */
-	LinkGraphJob() : settings(_settings_game.linkgraph), thread(NULL),
-			join_date(INVALID_DATE) {}
+	LinkGraphJob() : settings(_settings_game.linkgraph), spawned(false), finished(false),
+			aborted(false), progress(0), runtime(0), join_date(INVALID_DATE) {}
 
-	LinkGraphJob(const LinkGraph &orig);
+	LinkGraphJob(const LinkGraph &orig, const LinkGraphSettings &settings = _settings_game.linkgraph);
 	~LinkGraphJob();
 
 	void Init();
@@ -280,6 +288,11 @@ public:
 	 */
 	inline bool IsFinished() const { return this->join_date <= _date; }
 
+	bool IsDone() const;
+	bool IsAborted() const;
+	uint GetProgress() const;
+	uint32 GetRuntime() const;
+
 	/**
 	 * Get the date when the job should be finished.
 	 * @return Join date.
@@ -298,6 +311,12 @@ public:
 	 */
 	inline const LinkGraphSettings &Settings() const { return this->settings; }
 
+	/**
+	 * Check whether the MCF solver should use its fast backend for this job.
+	 * @return True for the heap based backend, false for the original one.
+	 */
+	inline bool UseFastMCF() const { return this->settings.fast_mcf_solver; }
+
 	/**
 	 * Get a node abstraction with the specified id.
 	 * @param num ID of the node.
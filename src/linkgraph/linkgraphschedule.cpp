@@ -16,6 +16,13 @@
 #include "mcf.h"
 #include "flowmapper.h"
 #include "../framerate_type.h"
+#include "../console_func.h"
+#include "../network/network.h"
+#include "../debug.h"
+#include "../settings_type.h"
+#include "../date_type.h"
+#include "../gfx_type.h"
+#include <chrono>
 
 #include "../safeguards.h"
 
@@ -26,6 +33,18 @@
  */
 /* static */ LinkGraphSchedule LinkGraphSchedule::instance;
 
+/**
+ * Get the number of days a job needs at normal game speed, with a margin of a
+ * quarter of its runtime.
+ * @param runtime Runtime of the job in milliseconds.
+ * @return Number of days, at most the maximum recalculation time.
+ */
+static uint16 GetJobDays(uint32 runtime)
+{
+	static const uint DAY_MILLISECONDS = DAY_TICKS * MILLISECONDS_PER_TICK;
+	return (uint16)min<uint64>(((uint64)runtime * 5 / 4 + DAY_MILLISECONDS - 1) / DAY_MILLISECONDS, 4096);
+}
+
 /**
  * Start the next job in the schedule.
  */
@@ -42,7 +61,19 @@ void LinkGraphSchedule::SpawnNext()
 	assert(next == LinkGraph::Get(next->index));
 	this->schedule.pop_front();
 	if (LinkGraphJob::CanAllocateItem()) {
-		LinkGraphJob *job = new LinkGraphJob(*next);
+		LinkGraphSettings settings = _settings_game.linkgraph;
+		/* Without other clients depending on the join date, a component whose
+		 * last job didn't fit into the recalculation time gets as much time as
+		 * that job needed. The flow mapper derives the spawn date from the join
+		 * date and the recalculation time, so the latter is changed in the
+		 * job's copy of the settings. */
+		uint16 days = GetJobDays(next->LastJobRuntime());
+		if (!_networking && days > settings.recalc_time) {
+			DEBUG(linkgraph, 1, "Giving link graph %u %u days instead of %u, its last job took %u ms",
+					next->index, days, settings.recalc_time, next->LastJobRuntime());
+			settings.recalc_time = days;
+		}
+		LinkGraphJob *job = new LinkGraphJob(*next, settings);
 		job->SpawnThread();
 		this->running.push_back(job);
 	} else {
@@ -58,11 +89,21 @@ void LinkGraphSchedule::JoinNext()
 	if (this->running.empty()) return;
 	LinkGraphJob *next = this->running.front();
 	if (!next->IsFinished()) return;
+	/* Without other clients depending on the join date we can as well give
+	 * the job some more time, instead of stalling the game until it's done. */
+	if (!_networking && !next->IsDone()) {
+		DEBUG(linkgraph, 1, "Delaying join of link graph %u, %u of %u handlers done",
+				next->LinkGraphIndex(), next->GetProgress(), (uint)lengthof(this->handlers));
+		return;
+	}
 	this->running.pop_front();
 	LinkGraphID id = next->LinkGraphIndex();
-	delete next; // implicitly joins the thread
+	next->JoinThread();
+	uint32 runtime = next->IsAborted() ? 0 : next->GetRuntime();
+	delete next;
 	if (LinkGraph::IsValidID(id)) {
 		LinkGraph *lg = LinkGraph::Get(id);
+		lg->SetLastJobRuntime(runtime);
 		this->Unqueue(lg); // Unqueue to avoid double-queueing recycled IDs.
 		this->Queue(lg);
 	}
@@ -70,15 +111,230 @@ void LinkGraphSchedule::JoinNext()
 
 /**
  * Run all handlers for the given Job. This method is tailored to
- * ThreadObject::New.
+ * ThreadObject::New. The job can be aborted between the handlers.
  * @param j Pointer to a link graph job.
  */
 /* static */ void LinkGraphSchedule::Run(void *j)
 {
 	LinkGraphJob *job = (LinkGraphJob *)j;
 	for (uint i = 0; i < lengthof(instance.handlers); ++i) {
+		if (job->IsAborted()) return;
 		instance.handlers[i]->Run(*job);
+		if (job->IsAborted()) return;
+		job->SetProgress(i + 1);
+	}
+}
+
+/**
+ * Add a value to an FNV-1a style checksum.
+ * @param hash Checksum to update.
+ * @param value Value to add.
+ */
+static inline void HashValue(uint32 &hash, uint32 value)
+{
+	hash = (hash ^ value) * 16777619U;
+}
+
+/**
+ * Calculate a checksum of the demands, flows and planned flows of a job.
+ * @param job Job to calculate the checksum for.
+ * @return The checksum.
+ */
+static uint32 ChecksumJob(LinkGraphJob &job)
+{
+	uint32 hash = 2166136261U;
+	for (NodeID from = 0; from < job.Size(); ++from) {
+		LinkGraphJob::Node node = job[from];
+		HashValue(hash, node.UndeliveredSupply());
+		for (NodeID to = 0; to < job.Size(); ++to) {
+			LinkGraphJob::Edge edge = node[to];
+			HashValue(hash, edge.Demand());
+			HashValue(hash, edge.UnsatisfiedDemand());
+			HashValue(hash, edge.Flow());
+		}
+		const FlowStatMap &flows = node.Flows();
+		for (FlowStatMap::const_iterator it = flows.begin(); it != flows.end(); ++it) {
+			HashValue(hash, it->first);
+			HashValue(hash, it->second.GetUnrestricted());
+			const FlowStat::SharesMap *shares = it->second.GetShares();
+			for (FlowStat::SharesMap::const_iterator share = shares->begin(); share != shares->end(); ++share) {
+				HashValue(hash, share->first);
+				HashValue(hash, share->second);
+			}
+		}
+	}
+	return hash;
+}
+
+/**
+ * Run the handlers on a copy of a link graph and print the time each of them
+ * took, together with a checksum of the job after it.
+ * @param lg Link graph to run the handlers on.
+ * @param settings Settings to run the job with.
+ * @param runs Number of times to run the job; the fastest time of each handler is reported.
+ * @param[in,out] total Sum of the reported times per handler, in microseconds.
+ * @return False if the checksums differed between the runs.
+ */
+/* static */ bool LinkGraphSchedule::BenchmarkJob(const LinkGraph &lg, const LinkGraphSettings &settings, uint runs, uint64 *total)
+{
+	static const char * const handler_names[] = { "init", "demands", "mcf 1st pass", "flows", "mcf 2nd pass", "scaled flows" };
+	static const uint num_handlers = lengthof(handler_names);
+
+	/* Detach the copy from the original so the job's destructor doesn't apply the results to the game. */
+	LinkGraph copy(lg);
+	copy.index = INVALID_LINK_GRAPH;
+
+	uint64 fastest[num_handlers];
+	uint32 checksums[num_handlers];
+	bool consistent = true;
+	for (uint run = 0; run < runs; run++) {
+		LinkGraphJob job(copy, settings);
+		for (uint i = 0; i < num_handlers; i++) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			instance.handlers[i]->Run(job);
+			uint64 time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+			uint32 checksum = ChecksumJob(job);
+			if (run == 0) {
+				fastest[i] = time;
+				checksums[i] = checksum;
+			} else {
+				fastest[i] = min(fastest[i], time);
+				if (checksums[i] != checksum) consistent = false;
+			}
+		}
+		/* The flow maps are not destroyed with the job. */
+		for (NodeID node = 0; node < job.Size(); ++node) job[node].Flows().clear();
+	}
+
+	IConsolePrintF(CC_DEFAULT, "Link graph %u, cargo %u, %u nodes:", lg.index, lg.Cargo(), lg.Size());
+	for (uint i = 0; i < num_handlers; i++) {
+		IConsolePrintF(CC_DEFAULT, "  %-13s %10u us, checksum %08X", handler_names[i], (uint)fastest[i], checksums[i]);
+		total[i] += fastest[i];
+	}
+	if (!consistent) IConsolePrintF(CC_ERROR, "  checksums differ between runs");
+	return consistent;
+}
+
+/**
+ * Run the handlers on copies of all link graphs and of the link graphs of all
+ * running jobs, and print timings and checksums of the results per handler to
+ * the console. This doesn't change the game state.
+ * @param runs Number of times to run each job.
+ */
+/* static */ void LinkGraphSchedule::Benchmark(uint runs)
+{
+	assert(lengthof(instance.handlers) == 6);
+	uint64 total[lengthof(instance.handlers)] = {};
+	uint graphs = 0;
+	bool consistent = true;
+
+	const LinkGraph *lg;
+	FOR_ALL_LINK_GRAPHS(lg) {
+		if (lg->Size() < 2) continue;
+		consistent &= BenchmarkJob(*lg, _settings_game.linkgraph, runs, total);
+		graphs++;
+	}
+	const LinkGraphJob *lgj;
+	FOR_ALL_LINK_GRAPH_JOBS(lgj) {
+		if (lgj->Size() < 2) continue;
+		IConsolePrintF(CC_DEFAULT, "Running job %u:", lgj->index);
+		consistent &= BenchmarkJob(lgj->Graph(), lgj->Settings(), runs, total);
+		graphs++;
+	}
+
+	uint64 sum = 0;
+	for (uint i = 0; i < lengthof(total); i++) sum += total[i];
+	IConsolePrintF(CC_INFO, "%u link graphs, %u runs each, %s solver: init %u us, demands %u us, mcf %u us, flows %u us, total %u us%s",
+			graphs, runs, _settings_game.linkgraph.fast_mcf_solver ? "fast" : "original",
+			(uint)total[0], (uint)total[1], (uint)(total[2] + total[4]), (uint)(total[3] + total[5]), (uint)sum,
+			consistent ? "" : ", results not deterministic");
+}
+
+/**
+ * Check whether two flow stat maps describe the same flows.
+ * @param a First map.
+ * @param b Second map.
+ * @return True if both maps have the same flows with the same shares.
+ */
+static bool FlowsEqual(const FlowStatMap &a, const FlowStatMap &b)
+{
+	if (a.size() != b.size()) return false;
+	for (FlowStatMap::const_iterator it_a = a.begin(), it_b = b.begin(); it_a != a.end(); ++it_a, ++it_b) {
+		if (it_a->first != it_b->first) return false;
+		if (it_a->second.GetUnrestricted() != it_b->second.GetUnrestricted()) return false;
+		if (*it_a->second.GetShares() != *it_b->second.GetShares()) return false;
 	}
+	return true;
+}
+
+/**
+ * Run the handlers on a copy of a link graph once with each backend of the
+ * MCF solver and compare the flows they produce.
+ * @param lg Link graph to run the handlers on.
+ * @param settings Settings to run the job with; the choice of the solver is overridden.
+ * @return True if both backends produced the same flows at all nodes.
+ */
+/* static */ bool LinkGraphSchedule::CompareSolversOnJob(const LinkGraph &lg, const LinkGraphSettings &settings)
+{
+	/* Detach the copy from the original so the jobs' destructors don't apply the results to the game. */
+	LinkGraph copy(lg);
+	copy.index = INVALID_LINK_GRAPH;
+
+	LinkGraphSettings job_settings = settings;
+	job_settings.fast_mcf_solver = false;
+	LinkGraphJob original(copy, job_settings);
+	job_settings.fast_mcf_solver = true;
+	LinkGraphJob fast(copy, job_settings);
+
+	for (uint i = 0; i < lengthof(instance.handlers); i++) {
+		instance.handlers[i]->Run(original);
+		instance.handlers[i]->Run(fast);
+	}
+
+	uint differing = 0;
+	for (NodeID node = 0; node < original.Size(); ++node) {
+		if (!FlowsEqual(original[node].Flows(), fast[node].Flows())) {
+			if (differing == 0) IConsolePrintF(CC_ERROR, "Link graph %u, cargo %u: flows differ at station %u", lg.index, lg.Cargo(), original[node].Station());
+			differing++;
+		}
+		/* The flow maps are not destroyed with the jobs. */
+		original[node].Flows().clear();
+		fast[node].Flows().clear();
+	}
+
+	if (differing == 0) {
+		IConsolePrintF(CC_DEFAULT, "Link graph %u, cargo %u, %u nodes: flows are equal", lg.index, lg.Cargo(), lg.Size());
+	} else {
+		IConsolePrintF(CC_ERROR, "Link graph %u, cargo %u: flows differ at %u of %u nodes", lg.index, lg.Cargo(), differing, lg.Size());
+	}
+	return differing == 0;
+}
+
+/**
+ * Run the handlers with both backends of the MCF solver on copies of all
+ * link graphs and of the link graphs of all running jobs, and print to the
+ * console whether their flows are the same. This doesn't change the game state.
+ */
+/* static */ void LinkGraphSchedule::CompareSolvers()
+{
+	uint graphs = 0;
+	uint differing = 0;
+
+	const LinkGraph *lg;
+	FOR_ALL_LINK_GRAPHS(lg) {
+		if (lg->Size() < 2) continue;
+		if (!CompareSolversOnJob(*lg, _settings_game.linkgraph)) differing++;
+		graphs++;
+	}
+	const LinkGraphJob *lgj;
+	FOR_ALL_LINK_GRAPH_JOBS(lgj) {
+		if (lgj->Size() < 2) continue;
+		IConsolePrintF(CC_DEFAULT, "Running job %u:", lgj->index);
+		if (!CompareSolversOnJob(lgj->Graph(), lgj->Settings())) differing++;
+		graphs++;
+	}
+
+	IConsolePrintF(differing == 0 ? CC_INFO : CC_ERROR, "%u link graphs compared, flows differ in %u", graphs, differing);
 }
 
 /**
@@ -97,6 +353,10 @@ void LinkGraphSchedule::SpawnAll()
  */
 /* static */ void LinkGraphSchedule::Clear()
 {
+	/* The jobs are thrown away, so don't wait for them to finish. */
+	for (JobList::iterator i(instance.running.begin()); i != instance.running.end(); ++i) {
+		(*i)->Abort();
+	}
 	for (JobList::iterator i(instance.running.begin()); i != instance.running.end(); ++i) {
 		(*i)->JoinThread();
 	}
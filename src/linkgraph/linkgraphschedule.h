@@ -43,6 +43,9 @@ private:
 	typedef std::list<LinkGraphJob *> JobList;
 	friend const SaveLoad *GetLinkGraphScheduleDesc();
 
+	static bool BenchmarkJob(const LinkGraph &lg, const LinkGraphSettings &settings, uint runs, uint64 *total);
+	static bool CompareSolversOnJob(const LinkGraph &lg, const LinkGraphSettings &settings);
+
 protected:
 	ComponentHandler *handlers[6]; ///< Handlers to be run for each job.
 	GraphList schedule;            ///< Queue for new jobs.
@@ -55,6 +58,8 @@ public:
 
 	static void Run(void *j);
 	static void Clear();
+	static void Benchmark(uint runs);
+	static void CompareSolvers();
 
 	void SpawnNext();
 	void JoinNext();
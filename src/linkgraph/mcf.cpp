@@ -3,6 +3,7 @@
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
 #include "mcf.h"
+#include "../debug.h"
 #include <set>
 
 #include "../safeguards.h"
@@ -87,13 +88,58 @@ public:
 	};
 };
 
+/**
+ * Base class of the edge iterators. Determines how the edges are rated by the
+ * Dijkstra algorithm.
+ */
+class EdgeIteratorBase {
+protected:
+	LinkGraphJob &job;   ///< Job being executed.
+	uint max_saturation; ///< Maximum saturation for edges.
+
+	/**
+	 * Construct an edge iterator.
+	 * @param job Job to iterate on.
+	 * @param max_saturation Maximum saturation for edges.
+	 */
+	EdgeIteratorBase(LinkGraphJob &job, uint max_saturation) : job(job), max_saturation(max_saturation) {}
+
+public:
+	/**
+	 * Get the capacity of an edge, artificially decreased by the max_saturation setting.
+	 * @param edge The edge.
+	 * @return Usable capacity of the edge.
+	 */
+	inline uint GetCapacity(const Edge &edge) const
+	{
+		uint capacity = edge.Capacity();
+		if (this->max_saturation != UINT_MAX) {
+			capacity *= this->max_saturation;
+			capacity /= 100;
+			if (capacity == 0) capacity = 1;
+		}
+		return capacity;
+	}
+
+	/**
+	 * Get the distance of an edge.
+	 * @param from Node the edge starts at.
+	 * @param to Node the edge ends at.
+	 * @return Distance of the edge.
+	 */
+	inline uint GetDistance(NodeID from, NodeID to) const
+	{
+		/* punish in-between stops a little */
+		return DistanceMaxPlusManhattan(this->job[from].XY(), this->job[to].XY()) + 1;
+	}
+};
+
 /**
  * Iterator class for getting the edges in the order of their next_edge
  * members.
  */
-class GraphEdgeIterator {
+class GraphEdgeIterator : public EdgeIteratorBase {
 private:
-	LinkGraphJob &job; ///< Job being executed
 	EdgeIterator i;    ///< Iterator pointing to current edge.
 	EdgeIterator end;  ///< Iterator pointing beyond last edge.
 
@@ -102,8 +148,9 @@ public:
 	/**
 	 * Construct a GraphEdgeIterator.
 	 * @param job Job to iterate on.
+	 * @param max_saturation Maximum saturation for edges.
 	 */
-	GraphEdgeIterator(LinkGraphJob &job) : job(job),
+	GraphEdgeIterator(LinkGraphJob &job, uint max_saturation) : EdgeIteratorBase(job, max_saturation),
 		i(NULL, NULL, INVALID_NODE), end(NULL, NULL, INVALID_NODE)
 	{}
 
@@ -129,12 +176,89 @@ public:
 };
 
 /**
- * Iterator class for getting edges from a FlowStatMap.
+ * Iterator class for getting the edges in the order of their next_edge
+ * members, like GraphEdgeIterator, but from a compact copy of the edges.
+ * Their capacities and distances are calculated only once.
  */
-class FlowEdgeIterator {
+class AdjacencyEdgeIterator : public EdgeIteratorBase {
 private:
-	LinkGraphJob &job; ///< Link graph job we're working with.
+	/** An edge as seen by the Dijkstra algorithm. */
+	struct AdjacentEdge {
+		NodeID to;     ///< Node the edge ends at.
+		uint capacity; ///< Usable capacity of the edge.
+		uint distance; ///< Distance of the edge.
+	};
+
+	std::vector<AdjacentEdge> edges; ///< Edges of all nodes, node by node.
+	std::vector<uint> first;         ///< Index of the first edge of each node in #edges, and the end of the edges.
+	uint current;                    ///< Index of the edge returned last by Next.
+	uint next;                       ///< Index of the edge to be returned next by Next.
+	uint end;                        ///< Index beyond the edges of the current node.
+
+public:
+
+	/**
+	 * Construct an AdjacencyEdgeIterator and copy the edges of the job.
+	 * @param job Job to iterate on.
+	 * @param max_saturation Maximum saturation for edges.
+	 */
+	AdjacencyEdgeIterator(LinkGraphJob &job, uint max_saturation) : EdgeIteratorBase(job, max_saturation),
+		current(0), next(0), end(0)
+	{
+		uint size = job.Size();
+		this->first.resize(size + 1);
+		for (NodeID from = 0; from < size; ++from) {
+			this->first[from] = (uint)this->edges.size();
+			for (EdgeIterator i = job[from].Begin(); i != job[from].End(); ++i) {
+				NodeID to = i->first;
+				if (to == from) continue; // Not a real edge but a consumption sign.
+				AdjacentEdge edge = { to, EdgeIteratorBase::GetCapacity(job[from][to]), EdgeIteratorBase::GetDistance(from, to) };
+				this->edges.push_back(edge);
+			}
+		}
+		this->first[size] = (uint)this->edges.size();
+	}
 
+	/**
+	 * Setup the node to start iterating at.
+	 * @param source Unused.
+	 * @param node Node to start iterating at.
+	 */
+	void SetNode(NodeID source, NodeID node)
+	{
+		this->next = this->first[node];
+		this->end = this->first[node + 1];
+	}
+
+	/**
+	 * Retrieve the ID of the node the next edge points to.
+	 * @return Next edge's target node ID or INVALID_NODE.
+	 */
+	NodeID Next()
+	{
+		if (this->next == this->end) return INVALID_NODE;
+		this->current = this->next++;
+		return this->edges[this->current].to;
+	}
+
+	/**
+	 * Get the usable capacity of the edge returned last by Next.
+	 * @return Capacity.
+	 */
+	inline uint GetCapacity(const Edge &) const { return this->edges[this->current].capacity; }
+
+	/**
+	 * Get the distance of the edge returned last by Next.
+	 * @return Distance.
+	 */
+	inline uint GetDistance(NodeID, NodeID) const { return this->edges[this->current].distance; }
+};
+
+/**
+ * Iterator class for getting edges from a FlowStatMap.
+ */
+class FlowEdgeIterator : public EdgeIteratorBase {
+private:
 	/** Lookup table for getting NodeIDs from StationIDs. */
 	std::vector<NodeID> station_to_node;
 
@@ -148,8 +272,9 @@ public:
 	/**
 	 * Constructor.
 	 * @param job Link graph job to work with.
+	 * @param max_saturation Maximum saturation for edges.
 	 */
-	FlowEdgeIterator(LinkGraphJob &job) : job(job)
+	FlowEdgeIterator(LinkGraphJob &job, uint max_saturation) : EdgeIteratorBase(job, max_saturation)
 	{
 		for (NodeID i = 0; i < job.Size(); ++i) {
 			StationID st = job[i].Station();
@@ -189,6 +314,174 @@ public:
 	}
 };
 
+/**
+ * Queue of the annotations still to be visited by the Dijkstra algorithm,
+ * as a set ordered by the annotations' comparator.
+ * @tparam Tannotation Annotation to be used.
+ */
+template <class Tannotation>
+class AnnotationSet {
+private:
+	std::set<Tannotation *, typename Tannotation::Comparator> annos; ///< The queued annotations.
+
+public:
+	/**
+	 * Create an empty queue.
+	 * @param size Number of nodes in the link graph.
+	 */
+	AnnotationSet(uint size) {}
+
+	/**
+	 * Check if there are no annotations in the queue.
+	 * @return True if the queue is empty.
+	 */
+	inline bool IsEmpty() const { return this->annos.empty(); }
+
+	/**
+	 * Remove the best annotation from the queue.
+	 * @return The best annotation.
+	 */
+	inline Tannotation *Pop()
+	{
+		typename std::set<Tannotation *, typename Tannotation::Comparator>::iterator i = this->annos.begin();
+		Tannotation *anno = *i;
+		this->annos.erase(i);
+		return anno;
+	}
+
+	/**
+	 * Add an annotation to the queue.
+	 * @param anno Annotation to add.
+	 */
+	inline void Insert(Tannotation *anno) { this->annos.insert(anno); }
+
+	/**
+	 * Remove an annotation from the queue, if it is queued.
+	 * @param anno Annotation to remove.
+	 */
+	inline void Remove(Tannotation *anno) { this->annos.erase(anno); }
+};
+
+/**
+ * Queue of the annotations still to be visited by the Dijkstra algorithm,
+ * as a binary heap indexed by node. The annotations' comparator is a strict
+ * total order, so the annotations are popped in exactly the same order as
+ * from an AnnotationSet, but without allocating memory for every insertion.
+ * @tparam Tannotation Annotation to be used.
+ */
+template <class Tannotation>
+class AnnotationHeap {
+private:
+	std::vector<Tannotation *> heap;                ///< The queued annotations, as a binary heap.
+	std::vector<uint> position;                     ///< Position of the annotation of each node in #heap, or UINT_MAX.
+	typename Tannotation::Comparator before;        ///< Comparator telling which annotation has to be visited first.
+
+	/**
+	 * Put an annotation at a position of the heap.
+	 * @param pos  Position in #heap.
+	 * @param anno Annotation to put there.
+	 */
+	inline void Place(uint pos, Tannotation *anno)
+	{
+		this->heap[pos] = anno;
+		this->position[anno->GetNode()] = pos;
+	}
+
+	/**
+	 * Move the annotation at a position towards the top of the heap, until the heap is ordered again.
+	 * @param pos Position of the annotation.
+	 */
+	void SiftUp(uint pos)
+	{
+		Tannotation *anno = this->heap[pos];
+		while (pos > 0) {
+			uint parent = (pos - 1) / 2;
+			if (!this->before(anno, this->heap[parent])) break;
+			this->Place(pos, this->heap[parent]);
+			pos = parent;
+		}
+		this->Place(pos, anno);
+	}
+
+	/**
+	 * Move the annotation at a position towards the bottom of the heap, until the heap is ordered again.
+	 * @param pos Position of the annotation.
+	 */
+	void SiftDown(uint pos)
+	{
+		Tannotation *anno = this->heap[pos];
+		uint size = (uint)this->heap.size();
+		for (;;) {
+			uint child = pos * 2 + 1;
+			if (child >= size) break;
+			if (child + 1 < size && this->before(this->heap[child + 1], this->heap[child])) child++;
+			if (!this->before(this->heap[child], anno)) break;
+			this->Place(pos, this->heap[child]);
+			pos = child;
+		}
+		this->Place(pos, anno);
+	}
+
+public:
+	/**
+	 * Create an empty queue.
+	 * @param size Number of nodes in the link graph.
+	 */
+	AnnotationHeap(uint size) : position(size, UINT_MAX)
+	{
+		this->heap.reserve(size);
+	}
+
+	/**
+	 * Check if there are no annotations in the queue.
+	 * @return True if the queue is empty.
+	 */
+	inline bool IsEmpty() const { return this->heap.empty(); }
+
+	/**
+	 * Remove the best annotation from the queue.
+	 * @return The best annotation.
+	 */
+	inline Tannotation *Pop()
+	{
+		Tannotation *anno = this->heap.front();
+		this->Remove(anno);
+		return anno;
+	}
+
+	/**
+	 * Add an annotation to the queue.
+	 * @param anno Annotation to add.
+	 */
+	inline void Insert(Tannotation *anno)
+	{
+		this->heap.push_back(anno);
+		this->SiftUp((uint)this->heap.size() - 1);
+	}
+
+	/**
+	 * Remove an annotation from the queue, if it is queued.
+	 * @param anno Annotation to remove.
+	 */
+	void Remove(Tannotation *anno)
+	{
+		uint pos = this->position[anno->GetNode()];
+		if (pos == UINT_MAX) return;
+		this->position[anno->GetNode()] = UINT_MAX;
+
+		Tannotation *last = this->heap.back();
+		this->heap.pop_back();
+		if (last == anno) return;
+
+		this->Place(pos, last);
+		if (pos > 0 && this->before(last, this->heap[(pos - 1) / 2])) {
+			this->SiftUp(pos);
+		} else {
+			this->SiftDown(pos);
+		}
+	}
+};
+
 /**
  * Determines if an extension to the given Path with the given parameters is
  * better than this path.
@@ -246,57 +539,115 @@ bool CapacityAnnotation::IsBetter(const CapacityAnnotation *base, uint cap,
 	}
 }
 
+/**
+ * Create an annotation, reusing the memory of a cleaned up path if possible.
+ * @tparam Tannotation Annotation to be created.
+ * @param node ID of node to be annotated.
+ * @param source If the node is the source of its path.
+ * @return The new annotation.
+ */
+template<class Tannotation>
+Tannotation *MultiCommodityFlow::NewAnnotation(NodeID node, bool source)
+{
+	if (this->free_paths.empty()) return new Tannotation(node, source);
+
+	/* A pass only ever creates one type of annotation, so the memory fits. */
+	Path *path = this->free_paths.back();
+	this->free_paths.pop_back();
+	return new (path) Tannotation(node, source);
+}
+
 /**
  * A slightly modified Dijkstra algorithm. Grades the paths not necessarily by
  * distance, but by the value Tannotation computes. It uses the max_saturation
  * setting to artificially decrease capacities.
  * @tparam Tannotation Annotation to be used.
+ * @tparam Tqueue Queue for the annotations still to be visited.
  * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
  * @param source_node Node where the algorithm starts.
  * @param paths Container for the paths to be calculated.
+ * @param iter Iterator for getting the outgoing edges.
  */
-template<class Tannotation, class Tedge_iterator>
-void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
+template<class Tannotation, class Tqueue, class Tedge_iterator>
+void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths, Tedge_iterator &iter)
 {
-	typedef std::set<Tannotation *, typename Tannotation::Comparator> AnnoSet;
-	Tedge_iterator iter(this->job);
 	uint size = this->job.Size();
-	AnnoSet annos;
+	Tqueue annos(size);
 	paths.resize(size, NULL);
 	for (NodeID node = 0; node < size; ++node) {
-		Tannotation *anno = new Tannotation(node, node == source_node);
+		Tannotation *anno = this->NewAnnotation<Tannotation>(node, node == source_node);
 		anno->UpdateAnnotation();
-		annos.insert(anno);
+		annos.Insert(anno);
 		paths[node] = anno;
 	}
-	while (!annos.empty()) {
-		typename AnnoSet::iterator i = annos.begin();
-		Tannotation *source = *i;
-		annos.erase(i);
+	while (!annos.IsEmpty()) {
+		Tannotation *source = annos.Pop();
 		NodeID from = source->GetNode();
 		iter.SetNode(source_node, from);
 		for (NodeID to = iter.Next(); to != INVALID_NODE; to = iter.Next()) {
 			if (to == from) continue; // Not a real edge but a consumption sign.
 			Edge edge = this->job[from][to];
-			uint capacity = edge.Capacity();
-			if (this->max_saturation != UINT_MAX) {
-				capacity *= this->max_saturation;
-				capacity /= 100;
-				if (capacity == 0) capacity = 1;
-			}
-			/* punish in-between stops a little */
-			uint distance = DistanceMaxPlusManhattan(this->job[from].XY(), this->job[to].XY()) + 1;
+			uint capacity = iter.GetCapacity(edge);
+			uint distance = iter.GetDistance(from, to);
 			Tannotation *dest = static_cast<Tannotation *>(paths[to]);
 			if (dest->IsBetter(source, capacity, capacity - edge.Flow(), distance)) {
-				annos.erase(dest);
+				annos.Remove(dest);
 				dest->Fork(source, capacity, capacity - edge.Flow(), distance);
 				dest->UpdateAnnotation();
-				annos.insert(dest);
+				annos.Insert(dest);
 			}
 		}
 	}
 }
 
+/**
+ * Check paths found by the fast backend against the ones the original
+ * backend finds. Mismatches are reported on the linkgraph debug category.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tedge_iterator Iterator of the original backend.
+ * @param source_node Node where the paths start.
+ * @param paths Paths found by the fast backend.
+ * @param iter Iterator of the original backend.
+ */
+template<class Tannotation, class Tedge_iterator>
+void MultiCommodityFlow::CheckPaths(NodeID source_node, const PathVector &paths, Tedge_iterator &iter)
+{
+	PathVector check;
+	this->Dijkstra<Tannotation, AnnotationSet<Tannotation> >(source_node, check, iter);
+	for (NodeID node = 0; node < check.size(); ++node) {
+		Path *a = paths[node];
+		Path *b = check[node];
+		NodeID parent_a = a->GetParent() == NULL ? INVALID_NODE : a->GetParent()->GetNode();
+		NodeID parent_b = b->GetParent() == NULL ? INVALID_NODE : b->GetParent()->GetNode();
+		if (parent_a != parent_b || a->GetDistance() != b->GetDistance() || a->GetCapacity() != b->GetCapacity() || a->GetFreeCapacity() != b->GetFreeCapacity()) {
+			DEBUG(linkgraph, 0, "MCF backends disagree on the path from node %u to node %u of link graph %u", source_node, node, this->job.LinkGraphIndex());
+		}
+	}
+	for (PathVector::iterator i = check.begin(); i != check.end(); ++i) this->FreePath(*i);
+}
+
+/**
+ * Get rid of a path that is not needed anymore. The fast backend keeps it
+ * for reuse by the next search.
+ * @param path Path to free.
+ */
+void MultiCommodityFlow::FreePath(Path *path)
+{
+	if (this->job.UseFastMCF()) {
+		this->free_paths.push_back(path);
+	} else {
+		delete path;
+	}
+}
+
+/**
+ * Free the paths kept for reuse.
+ */
+MultiCommodityFlow::~MultiCommodityFlow()
+{
+	for (PathVector::iterator i = this->free_paths.begin(); i != this->free_paths.end(); ++i) delete *i;
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
@@ -315,12 +666,12 @@ void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths)
 			path->Detach();
 			if (path->GetNumChildren() == 0) {
 				paths[path->GetNode()] = NULL;
-				delete path;
+				this->FreePath(path);
 			}
 			path = parent;
 		}
 	}
-	delete source;
+	this->FreePath(source);
 	paths.clear();
 }
 
@@ -485,7 +836,7 @@ bool MCF1stPass::EliminateCycles()
 }
 
 /**
- * Run the first pass of the MCF calculation.
+ * Run the first pass of the MCF calculation. Stops early if the job is aborted.
  * @param job Link graph job to calculate.
  */
 MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
@@ -494,12 +845,20 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool more_loops;
+	GraphEdgeIterator graph_iter(job, this->max_saturation);
+	AdjacencyEdgeIterator *adjacency_iter = job.UseFastMCF() ? new AdjacencyEdgeIterator(job, this->max_saturation) : NULL;
 
 	do {
 		more_loops = false;
 		for (NodeID source = 0; source < size; ++source) {
+			if (job.IsAborted()) break;
 			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
+			if (adjacency_iter != NULL) {
+				this->Dijkstra<DistanceAnnotation, AnnotationHeap<DistanceAnnotation> >(source, paths, *adjacency_iter);
+				if (_debug_linkgraph_level >= 5) this->CheckPaths<DistanceAnnotation>(source, paths, graph_iter);
+			} else {
+				this->Dijkstra<DistanceAnnotation, AnnotationSet<DistanceAnnotation> >(source, paths, graph_iter);
+			}
 
 			for (NodeID dest = 0; dest < size; ++dest) {
 				Edge edge = job[source][dest];
@@ -522,12 +881,14 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 			}
 			this->CleanupPaths(source, paths);
 		}
-	} while (more_loops || this->EliminateCycles());
+	} while (!job.IsAborted() && (more_loops || this->EliminateCycles()));
+
+	delete adjacency_iter;
 }
 
 /**
  * Run the second pass of the MCF calculation which assigns all remaining
- * demands to existing paths.
+ * demands to existing paths. Stops early if the job is aborted.
  * @param job Link graph job to calculate.
  */
 MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
@@ -537,10 +898,17 @@ MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
 	bool demand_left = true;
-	while (demand_left) {
+	FlowEdgeIterator iter(job, this->max_saturation);
+	while (demand_left && !job.IsAborted()) {
 		demand_left = false;
 		for (NodeID source = 0; source < size; ++source) {
-			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
+			if (job.IsAborted()) break;
+			if (job.UseFastMCF()) {
+				this->Dijkstra<CapacityAnnotation, AnnotationHeap<CapacityAnnotation> >(source, paths, iter);
+				if (_debug_linkgraph_level >= 5) this->CheckPaths<CapacityAnnotation>(source, paths, iter);
+			} else {
+				this->Dijkstra<CapacityAnnotation, AnnotationSet<CapacityAnnotation> >(source, paths, iter);
+			}
 			for (NodeID dest = 0; dest < size; ++dest) {
 				Edge edge = this->job[source][dest];
 				Path *path = paths[dest];
@@ -21,15 +21,25 @@ protected:
 			max_saturation(job.Settings().short_path_saturation)
 	{}
 
+	~MultiCommodityFlow();
+
+	template<class Tannotation, class Tqueue, class Tedge_iterator>
+	void Dijkstra(NodeID from, PathVector &paths, Tedge_iterator &iter);
+
 	template<class Tannotation, class Tedge_iterator>
-	void Dijkstra(NodeID from, PathVector &paths);
+	void CheckPaths(NodeID from, const PathVector &paths, Tedge_iterator &iter);
+
+	template<class Tannotation>
+	Tannotation *NewAnnotation(NodeID node, bool source);
 
 	uint PushFlow(Edge &edge, Path *path, uint accuracy, uint max_saturation);
 
 	void CleanupPaths(NodeID source, PathVector &paths);
+	void FreePath(Path *path);
 
 	LinkGraphJob &job;   ///< Job we're working with.
 	uint max_saturation; ///< Maximum saturation for edges.
+	PathVector free_paths; ///< Paths cleaned up by the fast solver, to be reused by its next search.
 };
 
 /**
@@ -14,6 +14,10 @@
 #include "core/alloc_func.hpp"
 #include "water_map.h"
 #include "string_func.h"
+#include "pathfinder/water_regions.h"
+#include "vehicle_func.h"
+#include "console_func.h"
+#include <chrono>
 
 #include "safeguards.h"
 
@@ -31,6 +35,8 @@ uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 
 Tile *_m = NULL;          ///< Tiles of the map
 TileExtended *_me = NULL; ///< Extended Tiles of the map
+byte *_m_type = NULL;     ///< Types of the tiles of the map
+byte *_m_height = NULL;   ///< Heights of the tiles of the map
 
 
 /**
@@ -60,9 +66,16 @@ void AllocateMap(uint size_x, uint size_y)
 
 	free(_m);
 	free(_me);
+	free(_m_type);
+	free(_m_height);
 
 	_m = CallocT<Tile>(_map_size);
 	_me = CallocT<TileExtended>(_map_size);
+	_m_type = CallocT<byte>(_map_size);
+	_m_height = CallocT<byte>(_map_size);
+
+	InitializeWaterRegions();
+	AllocateTrainTileCounts();
 }
 
 
@@ -387,3 +400,117 @@ uint GetClosestWaterDistance(TileIndex tile, bool water)
 
 	return max_dist;
 }
+
+/** Layout of the tiles before the type and height moved into arrays of their own. */
+struct InterleavedTile {
+	byte   type;   ///< Copy of #_m_type.
+	byte   height; ///< Copy of #_m_height.
+	uint16 m2;     ///< Copy of Tile::m2.
+	byte   m1;     ///< Copy of Tile::m1.
+	byte   m3;     ///< Copy of Tile::m3.
+	byte   m4;     ///< Copy of Tile::m4.
+	byte   m5;     ///< Copy of Tile::m5.
+};
+
+/**
+ * Run a sweep over the map a number of times.
+ * @param runs Number of times to run the sweep.
+ * @param sweep The sweep, returning a checksum of the data it read.
+ * @param[out] checksum Checksum returned by the sweep.
+ * @return Time of the fastest run in microseconds.
+ */
+template <typename Tsweep>
+static uint64 TimeMapSweep(uint runs, Tsweep sweep, uint32 *checksum)
+{
+	uint64 fastest = UINT64_MAX;
+	for (uint run = 0; run < runs; run++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		*checksum = sweep();
+		uint64 time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		fastest = min(fastest, time);
+	}
+	return fastest;
+}
+
+/**
+ * Time sweeps over the map with the type and height of the tiles in arrays of
+ * their own, and over a copy of the map with them interleaved with the other
+ * tile data as they used to be. Print the times to the console. This doesn't
+ * change the game state.
+ * @param runs Number of times to run each sweep; the fastest time is shown.
+ */
+void BenchmarkMapLayout(uint runs)
+{
+	const uint size = MapSize();
+	InterleavedTile *interleaved = MallocT<InterleavedTile>(size);
+	for (TileIndex t = 0; t < size; t++) {
+		InterleavedTile &it = interleaved[t];
+		it.type = _m_type[t];
+		it.height = _m_height[t];
+		it.m2 = _m[t].m2;
+		it.m1 = _m[t].m1;
+		it.m3 = _m[t].m3;
+		it.m4 = _m[t].m4;
+		it.m5 = _m[t].m5;
+	}
+	byte *buf = MallocT<byte>(size);
+
+	static const char * const names[] = { "scattered type and m5", "sequential type and height", "copy of the types" };
+	uint64 split_time[lengthof(names)];
+	uint64 interleaved_time[lengthof(names)];
+	uint32 split_checksum[lengthof(names)];
+	uint32 interleaved_checksum[lengthof(names)];
+
+	/* Visit all tiles in a scattered order like the tile loop, reading the type and the m5 of houses. */
+	split_time[0] = TimeMapSweep(runs, [&]() {
+		uint32 sum = 0;
+		TileIndex t = 0;
+		for (uint i = 0; i < size; i++) {
+			t = (t * 5 + 1) & (size - 1);
+			sum += _m_type[t];
+			if (GB(_m_type[t], 4, 4) == MP_HOUSE) sum += _m[t].m5;
+		}
+		return sum;
+	}, &split_checksum[0]);
+	interleaved_time[0] = TimeMapSweep(runs, [&]() {
+		uint32 sum = 0;
+		TileIndex t = 0;
+		for (uint i = 0; i < size; i++) {
+			t = (t * 5 + 1) & (size - 1);
+			sum += interleaved[t].type;
+			if (GB(interleaved[t].type, 4, 4) == MP_HOUSE) sum += interleaved[t].m5;
+		}
+		return sum;
+	}, &interleaved_checksum[0]);
+
+	/* Go over all tiles in order reading the type and height, like the smallmap. */
+	split_time[1] = TimeMapSweep(runs, [&]() {
+		uint32 sum = 0;
+		for (TileIndex t = 0; t < size; t++) sum += _m_type[t] ^ _m_height[t];
+		return sum;
+	}, &split_checksum[1]);
+	interleaved_time[1] = TimeMapSweep(runs, [&]() {
+		uint32 sum = 0;
+		for (TileIndex t = 0; t < size; t++) sum += interleaved[t].type ^ interleaved[t].height;
+		return sum;
+	}, &interleaved_checksum[1]);
+
+	/* Gather the types for saving the MAPT chunk. */
+	split_time[2] = TimeMapSweep(runs, [&]() {
+		MemCpyT(buf, _m_type, size);
+		return (uint32)buf[size - 1];
+	}, &split_checksum[2]);
+	interleaved_time[2] = TimeMapSweep(runs, [&]() {
+		for (TileIndex t = 0; t < size; t++) buf[t] = interleaved[t].type;
+		return (uint32)buf[size - 1];
+	}, &interleaved_checksum[2]);
+
+	free(buf);
+	free(interleaved);
+
+	IConsolePrintF(CC_INFO, "%ux%u map, %u runs each; arrays of their own vs interleaved:", MapSizeX(), MapSizeY(), runs);
+	for (uint i = 0; i < lengthof(names); i++) {
+		IConsolePrintF(CC_DEFAULT, "  %-27s %8u us vs %8u us", names[i], (uint)split_time[i], (uint)interleaved_time[i]);
+		if (split_checksum[i] != interleaved_checksum[i]) IConsolePrintF(CC_ERROR, "  checksums differ");
+	}
+}
@@ -43,7 +43,19 @@ extern Tile *_m;
  */
 extern TileExtended *_me;
 
+/**
+ * Pointer to the array with the type of each tile: the tile type (bits 4..7),
+ * bridges above the tile (2..3) and rainforest/desert (0..1).
+ */
+extern byte *_m_type;
+
+/**
+ * Pointer to the array with the height of the northern corner of each tile.
+ */
+extern byte *_m_height;
+
 void AllocateMap(uint size_x, uint size_y);
+void BenchmarkMapLayout(uint runs);
 
 /**
  * Logarithm of the map size along the X side.
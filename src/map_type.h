@@ -14,11 +14,11 @@
 
 /**
  * Data that is stored per tile. Also used TileExtended for this.
+ * The type and height of the tiles are kept in their own arrays, see
+ * #_m_type and #_m_height, so going over all tiles only touches those.
  * Look at docs/landscape.html for the exact meaning of the members.
  */
 struct Tile {
-	byte   type;        ///< The type (bits 4..7), bridges (2..3), rainforest/desert (0..1)
-	byte   height;      ///< The height of the northern corner.
 	uint16 m2;          ///< Primarily used for indices to towns, industries and stations
 	byte   m1;          ///< Primarily used for ownership information
 	byte   m3;          ///< General purpose
@@ -26,7 +26,7 @@ struct Tile {
 	byte   m5;          ///< General purpose
 };
 
-assert_compile(sizeof(Tile) == 8);
+assert_compile(sizeof(Tile) == 6);
 
 /**
  * Data that is stored per tile. Also used Tile for this.
@@ -28,6 +28,8 @@
 #include "core/pool_type.hpp"
 #include "game/game.hpp"
 #include "linkgraph/linkgraphschedule.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "train.h"
 
 #include "safeguards.h"
 
@@ -51,6 +53,9 @@ void InitializeCompanies();
 void InitializeCheats();
 void InitializeNPF();
 void InitializeOldNames();
+void RebuildTownKdtree();
+void RebuildIndustryAreaIndex();
+void RebuildViewportKdtree();
 
 void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settings)
 {
@@ -58,6 +63,9 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	 * related to the new game we're about to start/load. */
 	UnInitWindowSystem();
 
+	/* Nothing may be looking at the old game anymore. */
+	CancelTrainPathLookahead();
+
 	AllocateMap(size_x, size_y);
 
 	_pause_mode = PM_UNPAUSED;
@@ -75,6 +83,15 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	LinkGraphSchedule::Clear();
 	PoolBase::Clean(PT_NORMAL);
 
+	RebuildTownKdtree();
+	RebuildStationAreaIndex();
+	RebuildIndustryAreaIndex();
+	RebuildViewportKdtree();
+	/* The cached segments, road fields and signal blocks belong to the old map. */
+	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	YapfNotifyRoadLayoutChange();
+	ClearSignalBlockCache();
+
 	ResetPersistentNewGRFData();
 
 	InitializeSound();
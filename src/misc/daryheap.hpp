@@ -0,0 +1,247 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file daryheap.hpp D-ary heap implementation. */
+
+#ifndef DARYHEAP_HPP
+#define DARYHEAP_HPP
+
+#include "../core/alloc_func.hpp"
+#include "../core/math_func.hpp"
+
+/**
+ * D-ary Heap as C++ template.
+ *  Same interface as CBinaryHeapT, but every item has up to Tarity_ children
+ *  instead of two, and the heap stores the sort key of every item next to
+ *  the pointer to it. The tree is therefore less deep, and choosing between
+ *  the children of an item only reads one or two cache lines instead of
+ *  dereferencing every child.
+ *
+ * @par Usage information:
+ * Items provide their sort key with GetCostEstimate(). The key of an item
+ * must not change while the item is in the heap. Items with the same key
+ * may come out in a different order than from CBinaryHeapT.
+ *
+ * @par Implementation notes:
+ * Internally the first item is never used, so indices match CBinaryHeapT.
+ * The children of the item at index i are at Tarity_ * (i - 1) + 2 and the
+ * following Tarity_ - 1 positions.
+ *
+ * @tparam T       Type of the items stored in the heap
+ * @tparam Tarity_ Maximum number of children of an item
+ */
+template <class T, uint Tarity_ = 4>
+class CDaryHeapT {
+private:
+	/** An item in the heap together with its sort key. */
+	struct Entry {
+		int key; ///< Sort key of the item.
+		T *item; ///< The item.
+	};
+
+	uint items;    ///< Number of items in the heap
+	uint capacity; ///< Maximum number of items the heap can hold
+	Entry *data;   ///< The heap entries
+
+	assert_compile(Tarity_ >= 2);
+
+public:
+	/**
+	 * Create a heap.
+	 * @param max_items The initial limit of the heap
+	 */
+	explicit CDaryHeapT(uint max_items)
+		: items(0)
+		, capacity(max_items)
+	{
+		this->data = MallocT<Entry>(max_items + 1);
+	}
+
+	~CDaryHeapT()
+	{
+		this->Clear();
+		free(this->data);
+		this->data = NULL;
+	}
+
+protected:
+	/**
+	 * Get position for fixing a gap (downwards).
+	 * @param gap The position of the gap
+	 * @param key The key of the proposed item for filling the gap
+	 * @return The (gap)position where the item fits
+	 */
+	inline uint HeapifyDown(uint gap, int key)
+	{
+		assert(gap != 0);
+
+		for (;;) {
+			uint child = Tarity_ * (gap - 1) + 2;
+			if (child > this->items) break;
+
+			/* choose the smallest child */
+			uint last = min(child + Tarity_ - 1, this->items);
+			uint best = child;
+			int best_key = this->data[child].key;
+			for (child++; child <= last; child++) {
+				int child_key = this->data[child].key;
+				bool smaller = child_key < best_key;
+				best = smaller ? child : best;
+				best_key = smaller ? child_key : best_key;
+			}
+			/* the smallest child is still bigger or same as parent => we are done */
+			if (!(best_key < key)) break;
+
+			this->data[gap] = this->data[best];
+			gap = best;
+		}
+		return gap;
+	}
+
+	/**
+	 * Get position for fixing a gap (upwards).
+	 * @param gap The position of the gap
+	 * @param key The key of the proposed item for filling the gap
+	 * @return The (gap)position where the item fits
+	 */
+	inline uint HeapifyUp(uint gap, int key)
+	{
+		assert(gap != 0);
+
+		while (gap > 1) {
+			uint parent = (gap - 2) / Tarity_ + 1;
+			if (!(key < this->data[parent].key)) break;
+			this->data[gap] = this->data[parent];
+			gap = parent;
+		}
+		return gap;
+	}
+
+public:
+	/** @return The number of items stored in the heap. */
+	inline uint Length() const
+	{
+		return this->items;
+	}
+
+	/** @return True if the heap is empty. */
+	inline bool IsEmpty() const
+	{
+		return this->items == 0;
+	}
+
+	/** @return True if the heap has to grow before including another item. */
+	inline bool IsFull() const
+	{
+		return this->items >= this->capacity;
+	}
+
+	/** @return The smallest item; the heap must not be empty. */
+	inline T *Begin()
+	{
+		assert(!this->IsEmpty());
+		return this->data[1].item;
+	}
+
+	/**
+	 * Get the LAST item in the tree.
+	 * @note The last item is not necessary the biggest!
+	 * @return The last item
+	 */
+	inline T *End()
+	{
+		return this->data[1 + this->items].item;
+	}
+
+	/**
+	 * Insert new item into the heap, maintaining heap order.
+	 * @param new_item The pointer to the new item
+	 */
+	inline void Include(T *new_item)
+	{
+		if (this->IsFull()) {
+			assert(this->capacity < UINT_MAX / 2);
+
+			this->capacity *= 2;
+			this->data = ReallocT<Entry>(this->data, this->capacity + 1);
+		}
+
+		Entry entry = { new_item->GetCostEstimate(), new_item };
+		uint gap = this->HeapifyUp(++items, entry.key);
+		this->data[gap] = entry;
+	}
+
+	/**
+	 * Remove and return the smallest (and also first) item from the heap.
+	 * @return The pointer to the removed item
+	 */
+	inline T *Shift()
+	{
+		assert(!this->IsEmpty());
+
+		T *first = this->Begin();
+
+		this->items--;
+		/* at index 1 we have a gap now */
+		Entry last = this->data[1 + this->items];
+		uint gap = this->HeapifyDown(1, last.key);
+		/* move last item to the proper place */
+		if (!this->IsEmpty()) this->data[gap] = last;
+
+		return first;
+	}
+
+	/**
+	 * Remove item at given index from the heap.
+	 * @param index The position of the item in the heap
+	 */
+	inline void Remove(uint index)
+	{
+		if (index < this->items) {
+			assert(index != 0);
+			this->items--;
+			/* at position index we have a gap now */
+
+			Entry last = this->data[1 + this->items];
+			/* Fix the tree up and downwards */
+			uint gap = this->HeapifyUp(index, last.key);
+			gap = this->HeapifyDown(gap, last.key);
+			/* move last item to the proper place */
+			if (!this->IsEmpty()) this->data[gap] = last;
+		} else {
+			assert(index == this->items);
+			this->items--;
+		}
+	}
+
+	/**
+	 * Search for an item in the heap by its address.
+	 * @param item The reference to the item
+	 * @return The index of the item or zero if not found
+	 */
+	inline uint FindIndex(const T &item) const
+	{
+		if (this->IsEmpty()) return 0;
+		for (uint i = 1; i <= this->items; i++) {
+			if (this->data[i].item == &item) return i;
+		}
+		return 0;
+	}
+
+	/**
+	 * Make the heap empty.
+	 * All remaining items will remain untouched.
+	 */
+	inline void Clear()
+	{
+		this->items = 0;
+	}
+};
+
+#endif /* DARYHEAP_HPP */
@@ -124,8 +124,8 @@ public:
 #	define LANDINFOD_LEVEL 1
 #endif
 		DEBUG(misc, LANDINFOD_LEVEL, "TILE: %#x (%i,%i)", tile, TileX(tile), TileY(tile));
-		DEBUG(misc, LANDINFOD_LEVEL, "type   = %#x", _m[tile].type);
-		DEBUG(misc, LANDINFOD_LEVEL, "height = %#x", _m[tile].height);
+		DEBUG(misc, LANDINFOD_LEVEL, "type   = %#x", _m_type[tile]);
+		DEBUG(misc, LANDINFOD_LEVEL, "height = %#x", _m_height[tile]);
 		DEBUG(misc, LANDINFOD_LEVEL, "m1     = %#x", _m[tile].m1);
 		DEBUG(misc, LANDINFOD_LEVEL, "m2     = %#x", _m[tile].m2);
 		DEBUG(misc, LANDINFOD_LEVEL, "m3     = %#x", _m[tile].m3);
@@ -64,6 +64,8 @@
 #include "gfx_layout.h"
 #include "viewport_sprite_sorter.h"
 #include "framerate_type.h"
+#include "pathfinder/water_regions.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "linkgraph/linkgraphschedule.h"
 
@@ -304,6 +306,7 @@ static void ShutdownGame()
 	free(_config_file);
 #endif
 
+	CancelTrainPathLookahead();
 	LinkGraphSchedule::Clear();
 	PoolBase::Clean(PT_ALL);
 
@@ -1325,6 +1328,18 @@ static void CheckCaches()
 		free(tra_cache);
 	}
 
+	/* Check the water regions used by the ship pathfinder. */
+	CheckWaterRegionCaches();
+
+	/* Check the cost fields of road vehicle destinations. */
+	YapfCheckRoadFields();
+
+	/* Check the explored signal blocks. */
+	CheckSignalBlockCache();
+
+	/* Check the number of trains per tile. */
+	CheckTrainTileCounts();
+
 	/* Check whether the caches are still valid */
 	FOR_ALL_VEHICLES(v) {
 		byte buff[sizeof(VehicleCargoList)];
@@ -1356,10 +1371,17 @@ void StateGameLoop()
 		PerformanceMeasurer::Paused(PFE_GAMELOOP);
 		PerformanceMeasurer::Paused(PFE_GL_ECONOMY);
 		PerformanceMeasurer::Paused(PFE_GL_TRAINS);
+		PerformanceMeasurer::Paused(PFE_GL_PF_TRAINS);
 		PerformanceMeasurer::Paused(PFE_GL_ROADVEHS);
+		PerformanceMeasurer::Paused(PFE_GL_PF_ROADVEHS);
 		PerformanceMeasurer::Paused(PFE_GL_SHIPS);
+		PerformanceMeasurer::Paused(PFE_GL_PF_SHIPS);
 		PerformanceMeasurer::Paused(PFE_GL_AIRCRAFT);
 		PerformanceMeasurer::Paused(PFE_GL_LANDSCAPE);
+		PerformanceMeasurer::Paused(PFE_GL_TILE_CLEAR);
+		PerformanceMeasurer::Paused(PFE_GL_TILE_TREES);
+		PerformanceMeasurer::Paused(PFE_GL_TILE_WATER);
+		PerformanceMeasurer::Paused(PFE_GL_TILE_HOUSES);
 
 		UpdateLandscapingLimits();
 #ifndef DEBUG_DUMP_COMMANDS
@@ -1393,6 +1415,7 @@ void StateGameLoop()
 		}
 
 		CheckCaches();
+		FinishTrainPathLookahead();
 
 		/* All these actions has to be done from OWNER_NONE
 		 *  for multiplayer compatibility */
@@ -1415,6 +1438,8 @@ void StateGameLoop()
 		CallWindowGameTickEvent();
 		NewsLoop();
 		cur_company.Restore();
+
+		StartTrainPathLookahead();
 	}
 
 	assert(IsLocalCompany());
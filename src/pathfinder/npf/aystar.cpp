@@ -21,6 +21,8 @@
  *  And when not free'd, it can cause system-crashes.
  * Also remember that when you stop an algorithm before it is finished, your
  * should call clear() yourself!
+ * Clearing keeps the memory of the lists, so reuse one AyStar for many
+ * searches instead of initialising a new one each time.
  */
 
 #include "../../stdafx.h"
@@ -47,7 +49,7 @@ PathNode *AyStar::ClosedListIsInList(const AyStarNode *node)
 void AyStar::ClosedListAdd(const PathNode *node)
 {
 	/* Add a node to the ClosedList */
-	PathNode *new_node = MallocT<PathNode>(1);
+	PathNode *new_node = (PathNode*)this->closedlist_arena.Alloc();
 	*new_node = *node;
 	this->closedlist_hash.Set(node->node.tile, node->node.direction, new_node);
 }
@@ -85,7 +87,7 @@ OpenListNode *AyStar::OpenListPop()
 void AyStar::OpenListAdd(PathNode *parent, const AyStarNode *node, int f, int g)
 {
 	/* Add a new Node to the OpenList */
-	OpenListNode *new_node = MallocT<OpenListNode>(1);
+	OpenListNode *new_node = (OpenListNode*)this->openlist_arena.Alloc();
 	new_node->g = g;
 	new_node->path.parent = parent;
 	new_node->path.node = *node;
@@ -174,7 +176,7 @@ int AyStar::Loop()
 		if (this->FoundEndNode != NULL) {
 			this->FoundEndNode(this, current);
 		}
-		free(current);
+		this->openlist_arena.Free(current);
 		return AYSTAR_FOUND_END_NODE;
 	}
 
@@ -191,7 +193,7 @@ int AyStar::Loop()
 	}
 
 	/* Free the node */
-	free(current);
+	this->openlist_arena.Free(current);
 
 	if (this->max_search_nodes != 0 && this->closedlist_hash.GetSize() >= this->max_search_nodes) {
 		/* We've expanded enough nodes */
@@ -207,11 +209,12 @@ int AyStar::Loop()
  */
 void AyStar::Free()
 {
+	/* The values of the queue and the hashes live in the arenas. */
 	this->openlist_queue.Free(false);
-	/* 2nd argument above is false, below is true, to free the values only
-	 * once */
-	this->openlist_hash.Delete(true);
-	this->closedlist_hash.Delete(true);
+	this->openlist_hash.Delete(false);
+	this->closedlist_hash.Delete(false);
+	this->openlist_arena.Release();
+	this->closedlist_arena.Release();
 #ifdef AYSTAR_DEBUG
 	printf("[AyStar] Memory free'd\n");
 #endif
@@ -223,12 +226,13 @@ void AyStar::Free()
  */
 void AyStar::Clear()
 {
-	/* Clean the Queue, but not the elements within. That will be done by
-	 * the hash. */
+	/* Clean the Queue and the hashes, but not the elements within. Those
+	 * live in the arenas, which keep their memory for the next search. */
 	this->openlist_queue.Clear(false);
-	/* Clean the hashes */
-	this->openlist_hash.Clear(true);
-	this->closedlist_hash.Clear(true);
+	this->openlist_hash.Clear(false);
+	this->closedlist_hash.Clear(false);
+	this->openlist_arena.Reset();
+	this->closedlist_arena.Reset();
 
 #ifdef AYSTAR_DEBUG
 	printf("[AyStar] Cleared AyStar\n");
@@ -260,6 +264,8 @@ int AyStar::Main()
 #endif
 	if (r != AYSTAR_STILL_BUSY) {
 		/* We're done, clean up */
+		this->last_expanded_nodes = this->closedlist_hash.GetSize();
+		this->last_limit_reached = r == AYSTAR_LIMIT_REACHED;
 		this->Clear();
 	}
 
@@ -291,12 +297,22 @@ void AyStar::AddStartNode(AyStarNode *start_node, uint g)
 /**
  * Initialize an #AyStar. You should fill all appropriate fields before
  * calling #Init (see the declaration of #AyStar for which fields are internal).
+ * @param hash Hash function for the open list, and for the closed list unless it uses open addressing.
+ * @param num_buckets Number of buckets of the hashes; a power of two when the closed list uses open addressing.
+ * @param open_closedlist Whether the closed list uses open addressing. It only grows
+ *        during a search, which suits open addressing better than chaining.
  */
-void AyStar::Init(Hash_HashProc hash, uint num_buckets)
+void AyStar::Init(Hash_HashProc hash, uint num_buckets, bool open_closedlist)
 {
 	/* Allocated the Hash for the OpenList and ClosedList */
 	this->openlist_hash.Init(hash, num_buckets);
-	this->closedlist_hash.Init(hash, num_buckets);
+	if (open_closedlist) {
+		this->closedlist_hash.InitOpenAddressing(num_buckets);
+	} else {
+		this->closedlist_hash.Init(hash, num_buckets);
+	}
+	this->openlist_arena.Init(sizeof(OpenListNode));
+	this->closedlist_arena.Init(sizeof(PathNode));
 
 	/* Set up our sorting queue
 	 *  BinaryHeap allocates a block of 1024 nodes
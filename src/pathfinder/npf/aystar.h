@@ -141,12 +141,15 @@ struct AyStar {
 	uint max_path_cost;    ///< If the g-value goes over this number, it stops searching, 0 = infinite.
 	uint max_search_nodes; ///< The maximum number of nodes that will be expanded, 0 = infinite.
 
+	uint last_expanded_nodes; ///< Number of nodes expanded by the last finished search.
+	bool last_limit_reached;  ///< Whether the last finished search stopped at #max_search_nodes.
+
 	/* These should be filled with the neighbours of a tile by
 	 * GetNeighbours */
 	AyStarNode neighbours[12];
 	byte num_neighbours;
 
-	void Init(Hash_HashProc hash, uint num_buckets);
+	void Init(Hash_HashProc hash, uint num_buckets, bool open_closedlist = true);
 
 	/* These will contain the methods for manipulating the AyStar. Only
 	 * Main() should be called externally */
@@ -158,9 +161,11 @@ struct AyStar {
 	void CheckTile(AyStarNode *current, OpenListNode *parent);
 
 protected:
-	Hash       closedlist_hash; ///< The actual closed list.
-	BinaryHeap openlist_queue;  ///< The open queue.
-	Hash       openlist_hash;   ///< An extra hash to speed up the process of looking up an element in the open list.
+	Hash       closedlist_hash;  ///< The actual closed list.
+	BinaryHeap openlist_queue;   ///< The open queue.
+	Hash       openlist_hash;    ///< An extra hash to speed up the process of looking up an element in the open list.
+	ItemArena  openlist_arena;   ///< The memory of the #OpenListNode items.
+	ItemArena  closedlist_arena; ///< The memory of the #PathNode items in the closed list.
 
 	void OpenListAdd(PathNode *parent, const AyStarNode *node, int f, int g);
 	OpenListNode *OpenListIsInList(const AyStarNode *node);
@@ -16,6 +16,7 @@
 #include "../../roadstop_base.h"
 #include "../pathfinder_func.h"
 #include "../pathfinder_type.h"
+#include "../pathfinder_stats.h"
 #include "../follow_track.hpp"
 #include "aystar.h"
 
@@ -1010,9 +1011,13 @@ static NPFFoundTargetData NPFRouteInternal(AyStarNode *start1, bool ignore_start
 	_npf_aystar.user_data = user;
 
 	/* GO! */
+	uint64 start_time = GetPathfinderTimer();
 	r = _npf_aystar.Main();
 	assert(r != AYSTAR_STILL_BUSY);
 
+	static const VehicleType transport_vehicle_types[] = { VEH_TRAIN, VEH_ROAD, VEH_SHIP };
+	RecordPathfinderSearch(transport_vehicle_types[user->type], _npf_aystar.last_expanded_nodes, 0, 0, _npf_aystar.last_limit_reached, start_time);
+
 	if (result.best_bird_dist != 0) {
 		if (target != NULL) {
 			DEBUG(npf, 1, "Could not find route to tile 0x%X from 0x%X.", target->dest_coords, start1->tile);
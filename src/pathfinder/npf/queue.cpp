@@ -7,15 +7,98 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file queue.cpp Implementation of the #BinaryHeap/#Hash. */
+/** @file queue.cpp Implementation of the #BinaryHeap/#Hash/#ItemArena. */
 
 #include "../../stdafx.h"
 #include "../../core/alloc_func.hpp"
+#include "../../core/bitmath_func.hpp"
+#include "../../core/math_func.hpp"
+#include "../../core/mem_func.hpp"
 #include "queue.h"
 
 #include "../../safeguards.h"
 
 
+/*
+ * Item arena
+ */
+
+/**
+ * Initializes an arena for items of the given size. No memory is allocated
+ * until the first item is.
+ * @param item_size The size of the items.
+ */
+void ItemArena::Init(size_t item_size)
+{
+	this->item_size = Align(max(item_size, sizeof(void *)), sizeof(void *));
+	this->first_block = NULL;
+	this->block = NULL;
+	this->used = ARENA_BLOCKSIZE;
+	this->free_list = NULL;
+}
+
+/**
+ * Allocates an item; freed items are handed out first.
+ * @return The uninitialised item.
+ */
+void *ItemArena::Alloc()
+{
+	if (this->free_list != NULL) {
+		void *item = this->free_list;
+		this->free_list = *(void **)item;
+		return item;
+	}
+
+	if (this->used == ARENA_BLOCKSIZE) {
+		/* Move on to the next block, allocating it when we have never come this far. */
+		byte **next = (this->block == NULL) ? &this->first_block : (byte **)this->block;
+		if (*next == NULL) {
+			*next = MallocT<byte>(sizeof(void *) + ARENA_BLOCKSIZE * this->item_size);
+			*(byte **)*next = NULL;
+		}
+		this->block = *next;
+		this->used = 0;
+	}
+
+	return this->block + sizeof(void *) + this->item_size * this->used++;
+}
+
+/**
+ * Returns an item to the arena, so a next #Alloc can use it again.
+ * @param item The item to free.
+ */
+void ItemArena::Free(void *item)
+{
+	*(void **)item = this->free_list;
+	this->free_list = item;
+}
+
+/**
+ * Makes all items available again, but keeps the memory for them.
+ */
+void ItemArena::Reset()
+{
+	this->block = NULL;
+	this->used = ARENA_BLOCKSIZE;
+	this->free_list = NULL;
+}
+
+/**
+ * Gives all memory of the arena back. Items must not be used anymore.
+ */
+void ItemArena::Release()
+{
+	byte *block = this->first_block;
+	while (block != NULL) {
+		byte *next = *(byte **)block;
+		free(block);
+		block = next;
+	}
+	this->first_block = NULL;
+	this->Reset();
+}
+
+
 /*
  * Binary Heap
  * For information, see: http://www.policyalmanac.org/games/binaryHeaps.htm
@@ -27,39 +110,16 @@ const int BinaryHeap::BINARY_HEAP_BLOCKSIZE_MASK = BinaryHeap::BINARY_HEAP_BLOCK
 
 /**
  * Clears the queue, by removing all values from it. Its state is
- * effectively reset. If free_items is true, each of the items cleared
- * in this way are free()'d.
+ * effectively reset, but the memory for the elements is kept for the
+ * next use. If free_items is true, each of the items cleared in this
+ * way are free()'d.
  */
 void BinaryHeap::Clear(bool free_values)
 {
-	/* Free all items if needed and free all but the first blocks of memory */
-	uint i;
-	uint j;
-
-	for (i = 0; i < this->blocks; i++) {
-		if (this->elements[i] == NULL) {
-			/* No more allocated blocks */
-			break;
-		}
-		/* For every allocated block */
-		if (free_values) {
-			for (j = 0; j < (1 << BINARY_HEAP_BLOCKSIZE_BITS); j++) {
-				/* For every element in the block */
-				if ((this->size >> BINARY_HEAP_BLOCKSIZE_BITS) == i &&
-						(this->size & BINARY_HEAP_BLOCKSIZE_MASK) == j) {
-					break; // We're past the last element
-				}
-				free(this->elements[i][j].item);
-			}
-		}
-		if (i != 0) {
-			/* Leave the first block of memory alone */
-			free(this->elements[i]);
-			this->elements[i] = NULL;
-		}
+	if (free_values) {
+		for (uint i = 1; i <= this->size; i++) free(this->GetElement(i).item);
 	}
 	this->size = 0;
-	this->blocks = 1;
 }
 
 /**
@@ -73,7 +133,6 @@ void BinaryHeap::Free(bool free_values)
 
 	this->Clear(free_values);
 	for (i = 0; i < this->blocks; i++) {
-		if (this->elements[i] == NULL) break;
 		free(this->elements[i]);
 	}
 	free(this->elements);
@@ -228,23 +287,46 @@ void BinaryHeap::Init(uint max_size)
  */
 
 /**
- * Builds a new hash in an existing struct. Make sure that hash() always
- * returns a hash less than num_buckets! Call delete_hash after use
+ * Allocates the buckets and the bucket flags, with all buckets unused.
+ * @param num_buckets The number of buckets.
  */
-void Hash::Init(Hash_HashProc *hash, uint num_buckets)
+void Hash::AllocateBuckets(uint num_buckets)
 {
-	/* Allocate space for the Hash, the buckets and the bucket flags */
-	uint i;
-
 	/* Ensure the size won't overflow. */
 	CheckAllocationConstraints(sizeof(*this->buckets) + sizeof(*this->buckets_in_use), num_buckets);
 
-	this->hash = hash;
-	this->size = 0;
 	this->num_buckets = num_buckets;
 	this->buckets = (HashNode*)MallocT<byte>(num_buckets * (sizeof(*this->buckets) + sizeof(*this->buckets_in_use)));
 	this->buckets_in_use = (bool*)(this->buckets + num_buckets);
-	for (i = 0; i < num_buckets; i++) this->buckets_in_use[i] = false;
+	MemSetT(this->buckets_in_use, false, num_buckets);
+}
+
+/**
+ * Builds a new hash in an existing struct. Make sure that hash() always
+ * returns a hash less than num_buckets! Call delete_hash after use
+ */
+void Hash::Init(Hash_HashProc *hash, uint num_buckets)
+{
+	this->hash = hash;
+	this->size = 0;
+	this->AllocateBuckets(num_buckets);
+	this->node_arena.Init(sizeof(HashNode));
+}
+
+/**
+ * Builds a new hash that uses open addressing in an existing struct. The
+ * hash picks the buckets itself and doubles the number of buckets when
+ * more than three quarters of them are in use. Call delete_hash after use.
+ * @param num_buckets The initial number of buckets; a power of two.
+ */
+void Hash::InitOpenAddressing(uint num_buckets)
+{
+	assert(HasExactlyOneBit(num_buckets));
+
+	this->hash = NULL;
+	this->size = 0;
+	this->AllocateBuckets(num_buckets);
+	this->node_arena.Init(sizeof(HashNode));
 }
 
 /**
@@ -254,35 +336,18 @@ void Hash::Init(Hash_HashProc *hash, uint num_buckets)
  */
 void Hash::Delete(bool free_values)
 {
-	uint i;
-
-	/* Iterate all buckets */
-	for (i = 0; i < this->num_buckets; i++) {
-		if (this->buckets_in_use[i]) {
-			HashNode *node;
-
-			/* Free the first value */
-			if (free_values) free(this->buckets[i].value);
-			node = this->buckets[i].next;
-			while (node != NULL) {
-				HashNode *prev = node;
-
-				node = node->next;
-				/* Free the value */
-				if (free_values) free(prev->value);
-				/* Free the node */
-				free(prev);
-			}
-		}
-	}
+	this->Clear(free_values);
 	free(this->buckets);
 	/* No need to free buckets_in_use, it is always allocated in one
 	 * malloc with buckets */
+	this->node_arena.Release();
 }
 
 #ifdef HASH_STATS
 void Hash::PrintStatistics() const
 {
+	if (this->IsOpenAddressing()) return;
+
 	uint used_buckets = 0;
 	uint max_collision = 0;
 	uint max_usage = 0;
@@ -336,30 +401,26 @@ void Hash::PrintStatistics() const
  */
 void Hash::Clear(bool free_values)
 {
-	uint i;
-
 #ifdef HASH_STATS
 	if (this->size > 2000) this->PrintStatistics();
 #endif
 
-	/* Iterate all buckets */
-	for (i = 0; i < this->num_buckets; i++) {
-		if (this->buckets_in_use[i]) {
-			HashNode *node;
-
-			this->buckets_in_use[i] = false;
-			/* Free the first value */
-			if (free_values) free(this->buckets[i].value);
-			node = this->buckets[i].next;
-			while (node != NULL) {
-				HashNode *prev = node;
-
-				node = node->next;
-				if (free_values) free(prev->value);
-				free(prev);
+	if (free_values) {
+		/* Iterate all buckets */
+		for (uint i = 0; i < this->num_buckets; i++) {
+			if (!this->buckets_in_use[i]) continue;
+
+			free(this->buckets[i].value);
+			if (this->IsOpenAddressing()) continue;
+			for (const HashNode *node = this->buckets[i].next; node != NULL; node = node->next) {
+				free(node->value);
 			}
 		}
 	}
+
+	/* The chained nodes all go back to the arena at once. */
+	MemSetT(this->buckets_in_use, false, this->num_buckets);
+	this->node_arena.Reset();
 	this->size = 0;
 }
 
@@ -410,6 +471,8 @@ HashNode *Hash::FindNode(uint key1, uint key2, HashNode** prev_out) const
  */
 void *Hash::DeleteValue(uint key1, uint key2)
 {
+	if (this->IsOpenAddressing()) return this->OpenDeleteValue(key1, key2);
+
 	void *result;
 	HashNode *prev; // Used as output var for below function call
 	HashNode *node = this->FindNode(key1, key2, &prev);
@@ -427,7 +490,7 @@ void *Hash::DeleteValue(uint key1, uint key2)
 			/* Copy the second to the first */
 			*node = *next;
 			/* Free the second */
-			free(next);
+			this->node_arena.Free(next);
 		} else {
 			/* This was the last in this bucket
 			 * Mark it as empty */
@@ -441,7 +504,7 @@ void *Hash::DeleteValue(uint key1, uint key2)
 		/* Link previous and next nodes */
 		prev->next = node->next;
 		/* Free the node */
-		free(node);
+		this->node_arena.Free(node);
 	}
 	if (result != NULL) this->size--;
 	return result;
@@ -453,6 +516,8 @@ void *Hash::DeleteValue(uint key1, uint key2)
  */
 void *Hash::Set(uint key1, uint key2, void *value)
 {
+	if (this->IsOpenAddressing()) return this->OpenSet(key1, key2, value);
+
 	HashNode *prev;
 	HashNode *node = this->FindNode(key1, key2, &prev);
 
@@ -471,7 +536,7 @@ void *Hash::Set(uint key1, uint key2, void *value)
 		node = this->buckets + hash;
 	} else {
 		/* Add it after prev */
-		node = MallocT<HashNode>(1);
+		node = (HashNode*)this->node_arena.Alloc();
 		prev->next = node;
 	}
 	node->next = NULL;
@@ -488,7 +553,106 @@ void *Hash::Set(uint key1, uint key2, void *value)
  */
 void *Hash::Get(uint key1, uint key2) const
 {
+	if (this->IsOpenAddressing()) {
+		uint i = this->OpenFind(key1, key2);
+		return (i != this->num_buckets) ? this->buckets[i].value : NULL;
+	}
+
 	HashNode *node = this->FindNode(key1, key2, NULL);
 
 	return (node != NULL) ? node->value : NULL;
 }
+
+/**
+ * Gets the bucket where the probing for the given key pair starts, when
+ * using open addressing.
+ */
+uint Hash::OpenBucket(uint key1, uint key2) const
+{
+	uint32 h = key1 * 0x9E3779B1U + key2 * 0x85EBCA77U;
+	return (h ^ (h >> 16)) & (this->num_buckets - 1);
+}
+
+/**
+ * Finds the bucket holding the given key pair, when using open addressing.
+ * @return The bucket, or num_buckets when the key pair is not present.
+ */
+uint Hash::OpenFind(uint key1, uint key2) const
+{
+	for (uint i = this->OpenBucket(key1, key2);; i = (i + 1) & (this->num_buckets - 1)) {
+		if (!this->buckets_in_use[i]) return this->num_buckets;
+		if (this->buckets[i].key1 == key1 && this->buckets[i].key2 == key2) return i;
+	}
+}
+
+/**
+ * Doubles the number of buckets when using open addressing, and moves all
+ * nodes to their bucket in the new array.
+ */
+void Hash::OpenGrow()
+{
+	HashNode *old_buckets = this->buckets;
+	const bool *old_in_use = this->buckets_in_use;
+	uint old_num_buckets = this->num_buckets;
+
+	this->AllocateBuckets(old_num_buckets * 2);
+	for (uint i = 0; i < old_num_buckets; i++) {
+		if (!old_in_use[i]) continue;
+
+		uint j = this->OpenBucket(old_buckets[i].key1, old_buckets[i].key2);
+		while (this->buckets_in_use[j]) j = (j + 1) & (this->num_buckets - 1);
+		this->buckets[j] = old_buckets[i];
+		this->buckets_in_use[j] = true;
+	}
+	free(old_buckets);
+}
+
+/**
+ * #DeleteValue for open addressing. The nodes following the deleted one
+ * are shifted back, so no probe sequence gets broken.
+ */
+void *Hash::OpenDeleteValue(uint key1, uint key2)
+{
+	uint i = this->OpenFind(key1, key2);
+	if (i == this->num_buckets) return NULL;
+
+	void *result = this->buckets[i].value;
+	uint mask = this->num_buckets - 1;
+	for (uint j = (i + 1) & mask; this->buckets_in_use[j]; j = (j + 1) & mask) {
+		/* The node may stay when its probing starts after the hole, cyclically. */
+		uint k = this->OpenBucket(this->buckets[j].key1, this->buckets[j].key2);
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+
+		this->buckets[i] = this->buckets[j];
+		i = j;
+	}
+	this->buckets_in_use[i] = false;
+	this->size--;
+	return result;
+}
+
+/**
+ * #Set for open addressing.
+ */
+void *Hash::OpenSet(uint key1, uint key2, void *value)
+{
+	uint i = this->OpenFind(key1, key2);
+	if (i != this->num_buckets) {
+		void *result = this->buckets[i].value;
+		this->buckets[i].value = value;
+		return result;
+	}
+
+	/* Keep at least a quarter of the buckets free, so probing stays short. */
+	if ((this->size + 1) * 4 > this->num_buckets * 3) this->OpenGrow();
+
+	i = this->OpenBucket(key1, key2);
+	while (this->buckets_in_use[i]) i = (i + 1) & (this->num_buckets - 1);
+	this->buckets_in_use[i] = true;
+	this->buckets[i].key1 = key1;
+	this->buckets[i].key2 = key2;
+	this->buckets[i].value = value;
+	this->buckets[i].next = NULL;
+	this->size++;
+	return NULL;
+}
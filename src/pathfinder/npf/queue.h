@@ -7,7 +7,7 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file queue.h Binary heap implementation, hash implementation. */
+/** @file queue.h Binary heap implementation, hash implementation and the arena they allocate from. */
 
 #ifndef QUEUE_H
 #define QUEUE_H
@@ -15,6 +15,30 @@
 //#define HASH_STATS
 
 
+/**
+ * Allocator for items of a fixed size that keeps its memory between uses.
+ * Items are carved out of blocks of #ARENA_BLOCKSIZE items. Freed items go
+ * to a free list, and #Reset makes all items available again without giving
+ * any memory back, so a search that is repeated does not allocate anymore.
+ */
+struct ItemArena {
+	static const uint ARENA_BLOCKSIZE = 1024; ///< The number of items in a block.
+
+	void Init(size_t item_size);
+
+	void *Alloc();
+	void Free(void *item);
+	void Reset();
+	void Release();
+
+	size_t item_size; ///< The size of an item, rounded up to the alignment of a pointer.
+	byte *first_block; ///< The first block; every block starts with a pointer to the next one.
+	byte *block;       ///< The block new items are carved out of.
+	uint used;         ///< The number of items carved out of #block.
+	void *free_list;   ///< The freed items; each starts with a pointer to the next one.
+};
+
+
 struct BinaryHeapNode {
 	void *item;
 	int priority;
@@ -51,7 +75,7 @@ struct BinaryHeap {
 
 	uint max_size;
 	uint size;
-	uint blocks; ///< The amount of blocks for which space is reserved in elements
+	uint blocks; ///< The amount of blocks for which space is reserved in elements; they are kept until #Free
 	BinaryHeapNode **elements;
 };
 
@@ -70,8 +94,15 @@ struct HashNode {
  * the resulting range is clearly defined.
  */
 typedef uint Hash_HashProc(uint key1, uint key2);
+
+/**
+ * Hash of key pairs to values.
+ * By default collisions are chained, with the chained nodes coming from an
+ * #ItemArena. With open addressing the buckets themselves hold all nodes;
+ * the hash then picks the buckets itself and grows when it gets too full.
+ */
 struct Hash {
-	/* The hash function used */
+	/* The hash function used; NULL with open addressing */
 	Hash_HashProc *hash;
 	/* The amount of items in the hash */
 	uint size;
@@ -82,8 +113,11 @@ struct Hash {
 	/* A pointer to an array of numbuckets booleans, which will be true if
 	 * there are any Nodes in the bucket */
 	bool *buckets_in_use;
+	/* The chained nodes */
+	ItemArena node_arena;
 
 	void Init(Hash_HashProc *hash, uint num_buckets);
+	void InitOpenAddressing(uint num_buckets);
 
 	void *Get(uint key1, uint key2) const;
 	void *Set(uint key1, uint key2, void *value);
@@ -101,11 +135,26 @@ struct Hash {
 		return this->size;
 	}
 
+	/**
+	 * Whether the hash uses open addressing instead of chaining.
+	 */
+	inline bool IsOpenAddressing() const
+	{
+		return this->hash == NULL;
+	}
+
 protected:
 #ifdef HASH_STATS
 	void PrintStatistics() const;
 #endif
+	void AllocateBuckets(uint num_buckets);
 	HashNode *FindNode(uint key1, uint key2, HashNode** prev_out) const;
+
+	uint OpenBucket(uint key1, uint key2) const;
+	uint OpenFind(uint key1, uint key2) const;
+	void OpenGrow();
+	void *OpenDeleteValue(uint key1, uint key2);
+	void *OpenSet(uint key1, uint key2, void *value);
 };
 
 #endif /* QUEUE_H */
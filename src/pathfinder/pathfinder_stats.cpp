@@ -0,0 +1,155 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pathfinder_stats.cpp Statistics about the path searches of all pathfinders. */
+
+#include "../stdafx.h"
+#include "pathfinder_stats.h"
+#include "../core/bitmath_func.hpp"
+#include "../core/math_func.hpp"
+#include <atomic>
+#include <chrono>
+
+#include "../safeguards.h"
+
+/**
+ * The counters of #PathfinderStats that are updated by the searches.
+ * Searches may also run outside of the game loop, see YapfTrainStartPathSearches(),
+ * so they are atomic instead of being guarded by a lock for every search.
+ */
+struct PathfinderCounters {
+	std::atomic<uint> searches;
+	std::atomic<uint> exhausted;
+	std::atomic<uint64> nodes;
+	std::atomic<uint64> cache_hits;
+	std::atomic<uint64> cost_calcs;
+	std::atomic<uint64> total_us;
+	std::atomic<uint64> max_us;
+	std::atomic<uint> latency[PF_LATENCY_BUCKETS];
+};
+
+/** The statistics per vehicle type; only trains, road vehicles and ships have pathfinders. */
+static PathfinderCounters _pathfinder_stats[VEH_COMPANY_END];
+
+/**
+ * Get the bucket of the search time histogram for a search time.
+ * @param us Search time in microseconds.
+ * @return Index in #PathfinderStats::latency.
+ */
+static uint GetLatencyBucket(uint64 us)
+{
+	if (us < 4) return (uint)us;
+
+	uint log = FindLastBit(us);
+	return min<uint>((log - 1) * 4 + (uint)((us >> (log - 2)) & 3), PF_LATENCY_BUCKETS - 1);
+}
+
+/**
+ * Get the shortest search time of a bucket of the search time histogram.
+ * @param bucket Index in #PathfinderStats::latency.
+ * @return Search time in microseconds.
+ */
+static uint64 GetLatencyBucketStart(uint bucket)
+{
+	if (bucket < 4) return bucket;
+
+	uint log = bucket / 4 + 1;
+	return ((uint64)1 << log) + ((uint64)(bucket % 4) << (log - 2));
+}
+
+/**
+ * Get the time that the given percentage of the searches did not exceed.
+ * @param percent The percentile.
+ * @return Upper bound of the search times in microseconds, rounded up to the range of the histogram.
+ */
+uint64 PathfinderStats::GetLatencyPercentile(uint percent) const
+{
+	if (this->searches == 0) return 0;
+
+	uint64 needed = ((uint64)this->searches * percent + 99) / 100;
+	uint64 seen = 0;
+	for (uint i = 0; i < PF_LATENCY_BUCKETS - 1; i++) {
+		seen += this->latency[i];
+		if (seen >= needed) return min(GetLatencyBucketStart(i + 1) - 1, this->max_us);
+	}
+	return this->max_us;
+}
+
+/**
+ * Get the current time for measuring a search.
+ * @return Time in microseconds.
+ */
+uint64 GetPathfinderTimer()
+{
+	using namespace std::chrono;
+	return (uint64)time_point_cast<microseconds>(steady_clock::now()).time_since_epoch().count();
+}
+
+/**
+ * Add a finished path search to the statistics.
+ * @param type Type of the vehicle the search was for.
+ * @param nodes Number of nodes expanded.
+ * @param cache_hits Number of segment costs taken from a cache.
+ * @param cost_calcs Number of segment costs calculated.
+ * @param exhausted Whether the search stopped after visiting the maximum number of nodes.
+ * @param start_time GetPathfinderTimer() at the start of the search.
+ */
+void RecordPathfinderSearch(VehicleType type, uint nodes, uint cache_hits, uint cost_calcs, bool exhausted, uint64 start_time)
+{
+	assert(type < VEH_COMPANY_END);
+
+	uint64 us = GetPathfinderTimer() - start_time;
+
+	PathfinderCounters &stats = _pathfinder_stats[type];
+	stats.searches.fetch_add(1, std::memory_order_relaxed);
+	if (exhausted) stats.exhausted.fetch_add(1, std::memory_order_relaxed);
+	stats.nodes.fetch_add(nodes, std::memory_order_relaxed);
+	stats.cache_hits.fetch_add(cache_hits, std::memory_order_relaxed);
+	stats.cost_calcs.fetch_add(cost_calcs, std::memory_order_relaxed);
+	stats.total_us.fetch_add(us, std::memory_order_relaxed);
+	uint64 max_us = stats.max_us.load(std::memory_order_relaxed);
+	while (us > max_us && !stats.max_us.compare_exchange_weak(max_us, us, std::memory_order_relaxed)) {}
+	stats.latency[GetLatencyBucket(us)].fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Get the statistics of the path searches for a vehicle type. Searches that
+ * finish while taking the snapshot may be counted only partially.
+ * @param type The vehicle type.
+ * @param[out] stats The statistics since the last ResetPathfinderStats().
+ */
+void GetPathfinderStats(VehicleType type, PathfinderStats *stats)
+{
+	assert(type < VEH_COMPANY_END);
+
+	const PathfinderCounters &counters = _pathfinder_stats[type];
+	stats->searches = counters.searches.load(std::memory_order_relaxed);
+	stats->exhausted = counters.exhausted.load(std::memory_order_relaxed);
+	stats->nodes = counters.nodes.load(std::memory_order_relaxed);
+	stats->cache_hits = counters.cache_hits.load(std::memory_order_relaxed);
+	stats->cost_calcs = counters.cost_calcs.load(std::memory_order_relaxed);
+	stats->total_us = counters.total_us.load(std::memory_order_relaxed);
+	stats->max_us = counters.max_us.load(std::memory_order_relaxed);
+	for (uint i = 0; i < PF_LATENCY_BUCKETS; i++) stats->latency[i] = counters.latency[i].load(std::memory_order_relaxed);
+}
+
+/** Forget the statistics of all path searches. */
+void ResetPathfinderStats()
+{
+	for (PathfinderCounters *counters = _pathfinder_stats; counters != endof(_pathfinder_stats); counters++) {
+		counters->searches.store(0, std::memory_order_relaxed);
+		counters->exhausted.store(0, std::memory_order_relaxed);
+		counters->nodes.store(0, std::memory_order_relaxed);
+		counters->cache_hits.store(0, std::memory_order_relaxed);
+		counters->cost_calcs.store(0, std::memory_order_relaxed);
+		counters->total_us.store(0, std::memory_order_relaxed);
+		counters->max_us.store(0, std::memory_order_relaxed);
+		for (uint i = 0; i < PF_LATENCY_BUCKETS; i++) counters->latency[i].store(0, std::memory_order_relaxed);
+	}
+}
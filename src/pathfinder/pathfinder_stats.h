@@ -0,0 +1,38 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pathfinder_stats.h Statistics about the path searches of all pathfinders. */
+
+#ifndef PATHFINDER_STATS_H
+#define PATHFINDER_STATS_H
+
+#include "../vehicle_type.h"
+
+static const uint PF_LATENCY_BUCKETS = 80; ///< Number of buckets of the search time histogram, see #PathfinderStats::latency.
+
+/** Statistics about the path searches for one vehicle type. */
+struct PathfinderStats {
+	uint searches;     ///< Number of path searches.
+	uint exhausted;    ///< Number of searches that were stopped after visiting the maximum number of nodes.
+	uint64 nodes;      ///< Number of nodes expanded by the searches.
+	uint64 cache_hits; ///< Number of segment costs that were taken from a cache.
+	uint64 cost_calcs; ///< Number of segment costs that had to be calculated.
+	uint64 total_us;   ///< Total time of the searches, in microseconds.
+	uint64 max_us;     ///< Time of the slowest search, in microseconds.
+	uint latency[PF_LATENCY_BUCKETS]; ///< Number of searches per range of search times, four ranges per power of two microseconds.
+
+	uint64 GetLatencyPercentile(uint percent) const;
+};
+
+uint64 GetPathfinderTimer();
+void RecordPathfinderSearch(VehicleType type, uint nodes, uint cache_hits, uint cost_calcs, bool exhausted, uint64 start_time);
+void GetPathfinderStats(VehicleType type, PathfinderStats *stats);
+void ResetPathfinderStats();
+
+#endif /* PATHFINDER_STATS_H */
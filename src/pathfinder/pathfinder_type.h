@@ -43,6 +43,21 @@ static const int YAPF_INFINITE_PENALTY = 1000 * YAPF_TILE_LENGTH;
 /** Maximum length of ship path cache */
 static const int YAPF_SHIP_PATH_CACHE_LENGTH = 32;
 
+/** Maximum number of water region patches a ship searches a path through at once */
+static const int YAPF_SHIP_REGION_LOOKAHEAD = 5;
+
+/** Maximum segments of road vehicle path cache */
+static const int YAPF_ROADVEH_PATH_CACHE_SEGMENTS = 8;
+
+/** Distance from destination road stops to not cache any further */
+static const int YAPF_ROADVEH_PATH_CACHE_DESTINATION_LIMIT = 8;
+
+/** Maximum number of destinations road vehicles keep a cost field of */
+static const int YAPF_ROADVEH_DESTINATION_FIELDS = 16;
+
+/** Maximum number of tile/trackdir pairs in the cost field of a destination */
+static const int YAPF_ROADVEH_DESTINATION_FIELD_NODES = 1 << 16;
+
 /**
  * Helper container to find a depot
  */
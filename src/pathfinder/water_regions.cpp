@@ -0,0 +1,365 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.cpp Division of the water on the map into regions, to speed up ship pathfinding. */
+
+#include "../stdafx.h"
+#include "../debug.h"
+#include "../landscape.h"
+#include "../track_func.h"
+#include "../tunnelbridge_map.h"
+#include "water_regions.h"
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <vector>
+
+#include "../safeguards.h"
+
+/** Maximum number of patches the search over the region graph may visit before giving up. */
+static const uint WATER_REGION_MAX_SEARCH_NODES = 10000;
+
+/** Connection from a patch to a tile in another water region. */
+struct WaterRegionExit {
+	WaterRegionPatchLabel label; ///< Patch the connection starts in.
+	DiagDirection dir;           ///< Direction the ship moves in when leaving the region.
+	TileIndex tile;              ///< Tile in the other region.
+
+	bool operator ==(const WaterRegionExit &other) const
+	{
+		return this->label == other.label && this->dir == other.dir && this->tile == other.tile;
+	}
+};
+
+/**
+ * Connectivity of the water tiles of one region. Both the labels and the
+ * exits only depend on the tiles of the region itself, so changing a tile
+ * only invalidates its own region.
+ */
+struct WaterRegion {
+	bool valid;                                ///< The labels and exits match the map.
+	uint8 number_of_patches;                   ///< Number of patches in the region.
+	std::vector<WaterRegionPatchLabel> labels; ///< Patch of each tile of the region, empty if the region has no water.
+	std::vector<WaterRegionExit> exits;        ///< Connections to other regions.
+
+	WaterRegion() : valid(false), number_of_patches(0) {}
+};
+
+static std::vector<WaterRegion> _water_regions; ///< All water regions, row by row.
+static uint _water_regions_x;                   ///< Number of water regions in x direction.
+
+/**
+ * Get the trackdirs a ship may use on a tile.
+ * @param tile The tile.
+ * @return The trackdirs.
+ */
+static inline TrackdirBits GetWaterTrackdirs(TileIndex tile)
+{
+	return TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_WATER, 0));
+}
+
+/**
+ * Get the tile a ship ends up on when leaving a tile in a direction.
+ * @param tile The tile to leave.
+ * @param dir  The direction to leave the tile in.
+ * @return The next tile, or #INVALID_TILE when leaving the map.
+ */
+static TileIndex GetWaterExitTile(TileIndex tile, DiagDirection dir)
+{
+	if (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(tile) == dir) return GetOtherTunnelBridgeEnd(tile);
+	TileIndexDiffC diff = TileIndexDiffCByDiagDir(dir);
+	return TileAddWrap(tile, diff.x, diff.y);
+}
+
+/**
+ * Get the index of the water region of a tile.
+ * @param tile The tile.
+ * @return The index in #_water_regions.
+ */
+static inline uint GetWaterRegionIndex(TileIndex tile)
+{
+	return (TileY(tile) / WATER_REGION_EDGE_LENGTH) * _water_regions_x + TileX(tile) / WATER_REGION_EDGE_LENGTH;
+}
+
+/**
+ * Get the index of a tile within its water region.
+ * @param tile The tile.
+ * @return The index in WaterRegion::labels.
+ */
+static inline uint GetLocalTileIndex(TileIndex tile)
+{
+	return (TileY(tile) % WATER_REGION_EDGE_LENGTH) * WATER_REGION_EDGE_LENGTH + TileX(tile) % WATER_REGION_EDGE_LENGTH;
+}
+
+/**
+ * Split the water tiles of a region into patches of connected tiles and
+ * find the connections of these patches to the neighbouring regions.
+ * @param region The region to fill.
+ * @param index  Index of the region.
+ */
+static void ComputeWaterRegion(WaterRegion &region, uint index)
+{
+	const TileIndex base = TileXY((index % _water_regions_x) * WATER_REGION_EDGE_LENGTH, (index / _water_regions_x) * WATER_REGION_EDGE_LENGTH);
+
+	region.labels.assign(WATER_REGION_NUMBER_OF_TILES, INVALID_WATER_REGION_PATCH);
+	region.exits.clear();
+	region.number_of_patches = 0;
+
+	SmallVector<TileIndex, 64> todo;
+	for (uint i = 0; i < WATER_REGION_NUMBER_OF_TILES; i++) {
+		TileIndex start = base + TileXY(i % WATER_REGION_EDGE_LENGTH, i / WATER_REGION_EDGE_LENGTH);
+		if (region.labels[i] != INVALID_WATER_REGION_PATCH || GetWaterTrackdirs(start) == TRACKDIR_BIT_NONE) continue;
+
+		/* A region has at most WATER_REGION_NUMBER_OF_TILES / 2 patches, so the label never overflows. */
+		WaterRegionPatchLabel label = ++region.number_of_patches;
+		region.labels[i] = label;
+		*todo.Append() = start;
+
+		while (todo.Length() > 0) {
+			TileIndex tile = todo[todo.Length() - 1];
+			todo.Erase(todo.End() - 1);
+
+			uint exitdirs = 0;
+			for (TrackdirBits tds = GetWaterTrackdirs(tile); tds != TRACKDIR_BIT_NONE; tds = KillFirstBit(tds)) {
+				SetBit(exitdirs, TrackdirToExitdir((Trackdir)FindFirstBit2x64(tds)));
+			}
+
+			uint dir;
+			FOR_EACH_SET_BIT(dir, exitdirs) {
+				TileIndex next = GetWaterExitTile(tile, (DiagDirection)dir);
+				if (next == INVALID_TILE) continue;
+
+				if (GetWaterRegionIndex(next) != index) {
+					WaterRegionExit exit = { label, (DiagDirection)dir, next };
+					if (std::find(region.exits.begin(), region.exits.end(), exit) == region.exits.end()) region.exits.push_back(exit);
+					continue;
+				}
+
+				WaterRegionPatchLabel &next_label = region.labels[GetLocalTileIndex(next)];
+				if (next_label != INVALID_WATER_REGION_PATCH) continue;
+				if ((GetWaterTrackdirs(next) & DiagdirReachesTrackdirs((DiagDirection)dir)) == TRACKDIR_BIT_NONE) continue;
+
+				next_label = label;
+				*todo.Append() = next;
+			}
+		}
+	}
+
+	/* Don't keep the labels of regions without water around. */
+	if (region.number_of_patches == 0) std::vector<WaterRegionPatchLabel>().swap(region.labels);
+}
+
+/**
+ * Get a water region, updating it first when the map changed.
+ * @param index Index of the region.
+ * @return The up to date region.
+ */
+static const WaterRegion &GetUpdatedWaterRegion(uint index)
+{
+	WaterRegion &region = _water_regions[index];
+	if (!region.valid) {
+		ComputeWaterRegion(region, index);
+		region.valid = true;
+	}
+	return region;
+}
+
+/**
+ * Reset the water regions for the current map size.
+ * All regions are computed again once they are needed.
+ */
+void InitializeWaterRegions()
+{
+	_water_regions_x = MapSizeX() / WATER_REGION_EDGE_LENGTH;
+	_water_regions.clear();
+	_water_regions.resize(_water_regions_x * (MapSizeY() / WATER_REGION_EDGE_LENGTH));
+}
+
+/**
+ * Mark the water region of a tile as changed.
+ * @param tile The changed tile.
+ */
+void InvalidateWaterRegion(TileIndex tile)
+{
+	uint index = GetWaterRegionIndex(tile);
+	if (index < _water_regions.size()) _water_regions[index].valid = false;
+}
+
+/**
+ * Get the water region patch a tile belongs to.
+ * @param tile The tile.
+ * @return The patch; its label is #INVALID_WATER_REGION_PATCH when ships can't use the tile.
+ */
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile)
+{
+	uint index = GetWaterRegionIndex(tile);
+	const WaterRegion &region = GetUpdatedWaterRegion(index);
+
+	WaterRegionPatchDesc desc;
+	desc.x = index % _water_regions_x;
+	desc.y = index / _water_regions_x;
+	desc.label = region.labels.empty() ? INVALID_WATER_REGION_PATCH : region.labels[GetLocalTileIndex(tile)];
+	return desc;
+}
+
+/** Key of a water region patch in the search over the region graph. */
+static inline uint32 GetPatchKey(const WaterRegionPatchDesc &patch)
+{
+	return ((uint32)patch.y * _water_regions_x + patch.x) << 8 | patch.label;
+}
+
+/** Get the water region patch for a key made by #GetPatchKey. */
+static inline WaterRegionPatchDesc GetPatchFromKey(uint32 key)
+{
+	WaterRegionPatchDesc patch;
+	patch.x = (key >> 8) % _water_regions_x;
+	patch.y = (key >> 8) / _water_regions_x;
+	patch.label = GB(key, 0, 8);
+	return patch;
+}
+
+/** Distance between two water regions, in regions. */
+static inline uint GetRegionDistance(const WaterRegionPatchDesc &a, const WaterRegionPatchDesc &b)
+{
+	return Delta(a.x, b.x) + Delta(a.y, b.y);
+}
+
+/** Entry of the open list of the search over the region graph. */
+struct WaterRegionOpenNode {
+	uint estimate; ///< Cost so far plus the estimated remaining cost.
+	uint32 key;    ///< The patch.
+
+	bool operator <(const WaterRegionOpenNode &other) const
+	{
+		/* std::priority_queue returns the largest element first. */
+		if (this->estimate != other.estimate) return this->estimate > other.estimate;
+		return this->key > other.key;
+	}
+};
+
+/** Visited patch in the search over the region graph. */
+struct WaterRegionVisitedNode {
+	uint cost;     ///< Cost to reach the patch.
+	uint32 parent; ///< Key of the patch it was reached from.
+};
+
+/**
+ * Find the water region patches a ship passes when going to its destination.
+ * This searches the connections between the patches instead of the tiles,
+ * so it is cheap even for long routes.
+ * @param origin       Tile the ship is on.
+ * @param dest         Destination of the ship; when ships can't use it, the patches next to it are searched.
+ * @param max_patches  Maximum number of patches to return.
+ * @param[out] corridor The patches on the route, starting with the one of \a origin.
+ * @param[out] intermediate Whether the route was cut off after \a max_patches.
+ * @return False if no route through at least two patches was found.
+ */
+bool FindWaterRegionCorridor(TileIndex origin, TileIndex dest, uint max_patches, WaterRegionCorridor *corridor, bool *intermediate)
+{
+	corridor->Clear();
+	*intermediate = false;
+
+	WaterRegionPatchDesc start = GetWaterRegionPatchInfo(origin);
+	if (!start.IsValid()) return false;
+
+	SmallVector<uint32, 4> goals;
+	WaterRegionPatchDesc dest_patch = GetWaterRegionPatchInfo(dest);
+	if (dest_patch.IsValid()) {
+		*goals.Append() = GetPatchKey(dest_patch);
+	} else {
+		for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+			TileIndexDiffC diff = TileIndexDiffCByDiagDir(dir);
+			TileIndex tile = TileAddWrap(dest, diff.x, diff.y);
+			if (tile == INVALID_TILE) continue;
+			WaterRegionPatchDesc patch = GetWaterRegionPatchInfo(tile);
+			if (patch.IsValid()) goals.Include(GetPatchKey(patch));
+		}
+	}
+	if (goals.Length() == 0 || goals.Contains(GetPatchKey(start))) return false;
+
+	std::map<uint32, WaterRegionVisitedNode> visited;
+	std::priority_queue<WaterRegionOpenNode> open;
+
+	WaterRegionVisitedNode first = { 0, GetPatchKey(start) };
+	visited[first.parent] = first;
+	WaterRegionOpenNode first_open = { 0, first.parent };
+	open.push(first_open);
+
+	uint32 found = 0;
+	bool success = false;
+	while (!open.empty() && visited.size() < WATER_REGION_MAX_SEARCH_NODES) {
+		WaterRegionOpenNode node = open.top();
+		open.pop();
+
+		if (goals.Contains(node.key)) {
+			found = node.key;
+			success = true;
+			break;
+		}
+
+		uint cost = visited[node.key].cost;
+		WaterRegionPatchDesc patch = GetPatchFromKey(node.key);
+		const WaterRegion &region = GetUpdatedWaterRegion(patch.y * _water_regions_x + patch.x);
+
+		for (std::vector<WaterRegionExit>::const_iterator it = region.exits.begin(); it != region.exits.end(); ++it) {
+			if (it->label != patch.label) continue;
+			if ((GetWaterTrackdirs(it->tile) & DiagdirReachesTrackdirs(it->dir)) == TRACKDIR_BIT_NONE) continue;
+
+			WaterRegionPatchDesc next = GetWaterRegionPatchInfo(it->tile);
+			assert(next.IsValid());
+			uint32 next_key = GetPatchKey(next);
+			uint next_cost = cost + GetRegionDistance(patch, next);
+
+			std::map<uint32, WaterRegionVisitedNode>::iterator prev = visited.find(next_key);
+			if (prev != visited.end() && prev->second.cost <= next_cost) continue;
+			WaterRegionVisitedNode &v = visited[next_key];
+			v.cost = next_cost;
+			v.parent = node.key;
+
+			uint estimate = UINT_MAX;
+			for (const uint32 *goal = goals.Begin(); goal != goals.End(); goal++) {
+				estimate = min(estimate, GetRegionDistance(next, GetPatchFromKey(*goal)));
+			}
+			WaterRegionOpenNode next_open = { next_cost + estimate, next_key };
+			open.push(next_open);
+		}
+	}
+	if (!success) return false;
+
+	/* Walk back from the goal; the start is its own parent. */
+	SmallVector<uint32, 32> route;
+	for (uint32 key = found;; key = visited[key].parent) {
+		*route.Append() = key;
+		if (visited[key].parent == key) break;
+	}
+
+	uint count = min<uint>(route.Length(), max(max_patches, 2U));
+	for (uint i = 0; i < count; i++) {
+		*corridor->Append() = GetPatchFromKey(route[route.Length() - 1 - i]);
+	}
+	*intermediate = count < route.Length();
+	return true;
+}
+
+/**
+ * Check whether the valid water regions still match the map.
+ * Used to find changes to the map that forgot to invalidate their region.
+ */
+void CheckWaterRegionCaches()
+{
+	for (uint i = 0; i < _water_regions.size(); i++) {
+		if (!_water_regions[i].valid) continue;
+
+		WaterRegion check;
+		ComputeWaterRegion(check, i);
+		if (check.labels != _water_regions[i].labels || !(check.exits == _water_regions[i].exits)) {
+			DEBUG(desync, 2, "water region cache mismatch: region %u", i);
+		}
+	}
+}
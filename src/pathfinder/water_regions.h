@@ -0,0 +1,52 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.h Division of the water on the map into regions, to speed up ship pathfinding. */
+
+#ifndef WATER_REGIONS_H
+#define WATER_REGIONS_H
+
+#include "../tile_type.h"
+#include "../core/smallvec_type.hpp"
+
+static const uint WATER_REGION_EDGE_LENGTH = 16; ///< Size of a water region in both directions, in tiles.
+static const uint WATER_REGION_NUMBER_OF_TILES = WATER_REGION_EDGE_LENGTH * WATER_REGION_EDGE_LENGTH; ///< Number of tiles in a water region.
+
+typedef byte WaterRegionPatchLabel; ///< Number of a patch within its water region.
+static const WaterRegionPatchLabel INVALID_WATER_REGION_PATCH = 0; ///< Label of tiles without water.
+
+/** A patch of water tiles that are connected within their water region. */
+struct WaterRegionPatchDesc {
+	uint16 x;                    ///< X coordinate of the region, in regions.
+	uint16 y;                    ///< Y coordinate of the region, in regions.
+	WaterRegionPatchLabel label; ///< Patch within the region, or #INVALID_WATER_REGION_PATCH.
+
+	inline bool IsValid() const { return this->label != INVALID_WATER_REGION_PATCH; }
+
+	inline bool operator ==(const WaterRegionPatchDesc &other) const
+	{
+		return this->x == other.x && this->y == other.y && this->label == other.label;
+	}
+
+	inline bool operator !=(const WaterRegionPatchDesc &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+/** Water region patches a ship passes on its way, starting at its current patch. */
+typedef SmallVector<WaterRegionPatchDesc, 8> WaterRegionCorridor;
+
+void InitializeWaterRegions();
+void InvalidateWaterRegion(TileIndex tile);
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile);
+bool FindWaterRegionCorridor(TileIndex origin, TileIndex dest, uint max_patches, WaterRegionCorridor *corridor, bool *intermediate);
+void CheckWaterRegionCaches();
+
+#endif /* WATER_REGIONS_H */
@@ -12,42 +12,149 @@
 #ifndef NODELIST_HPP
 #define NODELIST_HPP
 
-#include "../../misc/array.hpp"
+#include "../../core/smallvec_type.hpp"
+#include "../../misc/str.hpp"
 #include "../../misc/hashtable.hpp"
 #include "../../misc/binaryheap.hpp"
+#include "../../misc/daryheap.hpp"
+
+/**
+ * Storage for the nodes of one search. Nodes are allocated in blocks that
+ *  are kept when the nodes are cleared, so the next search can reuse them
+ *  without allocating memory. Nodes never move, so pointers to them stay
+ *  valid until the arena is cleared.
+ */
+template <class Titem_, uint Tblock_size_ = 256>
+class CNodeArenaT {
+protected:
+	SmallVector<Titem_ *, 16> m_blocks; ///< Allocated blocks of Tblock_size_ items each.
+	uint m_items;                       ///< Number of constructed items, filling the blocks in order.
+
+public:
+	bool m_in_use;                      ///< Whether a node list currently stores its nodes here.
+
+	CNodeArenaT() : m_items(0), m_in_use(false) {}
+
+	~CNodeArenaT()
+	{
+		this->Clear();
+		this->Trim(0);
+	}
+
+	/** Destroy all items, but keep their memory. */
+	inline void Clear()
+	{
+		for (uint i = m_items; i-- > 0;) (*this)[i].~Titem_();
+		m_items = 0;
+	}
+
+	/**
+	 * Free the memory of unused blocks.
+	 * @param max_blocks Number of blocks to keep at most.
+	 */
+	inline void Trim(uint max_blocks)
+	{
+		max_blocks = max(max_blocks, (m_items + Tblock_size_ - 1) / Tblock_size_);
+		while (m_blocks.Length() > max_blocks) {
+			free(m_blocks[m_blocks.Length() - 1]);
+			m_blocks.Erase(m_blocks.End() - 1);
+		}
+	}
+
+	/** Return actual number of items */
+	inline uint Length() const
+	{
+		return m_items;
+	}
+
+	/** allocate and construct new item */
+	inline Titem_ *AppendC()
+	{
+		if (m_items == m_blocks.Length() * Tblock_size_) *m_blocks.Append() = MallocT<Titem_>(Tblock_size_);
+		Titem_ *item = m_blocks[m_items / Tblock_size_] + m_items % Tblock_size_;
+		m_items++;
+		new (item) Titem_;
+		return item;
+	}
+
+	/** indexed access (non-const) */
+	inline Titem_& operator[](uint index)
+	{
+		assert(index < m_items);
+		return m_blocks[index / Tblock_size_][index % Tblock_size_];
+	}
+
+	/** indexed access (const) */
+	inline const Titem_& operator[](uint index) const
+	{
+		assert(index < m_items);
+		return m_blocks[index / Tblock_size_][index % Tblock_size_];
+	}
+
+	/**
+	 * Helper for creating a human readable output of this data.
+	 * @param dmp The location to dump to.
+	 */
+	template <typename D> void Dump(D &dmp) const
+	{
+		dmp.WriteLine("num_items = %d", m_items);
+		CStrA name;
+		for (uint i = 0; i < m_items; i++) {
+			name.Format("item[%d]", i);
+			dmp.WriteStructT(name.Data(), &(*this)[i]);
+		}
+	}
+};
 
 /**
  * Hash table based node list multi-container class.
  *  Implements open list, closed list and priority queue for A-star
- *  path finder.
+ *  path finder. The nodes are stored in an arena shared by all lists of
+ *  the same type, so consecutive searches reuse its memory.
+ * @tparam Tqueue_ Priority queue policy, CBinaryHeapT or CDaryHeapT of Titem_.
  */
-template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_>
+template <class Titem_, int Thash_bits_open_, int Thash_bits_closed_, class Tqueue_ = CBinaryHeapT<Titem_> >
 class CNodeList_HashTableT {
 public:
 	typedef Titem_ Titem;                                        ///< Make #Titem_ visible from outside of class.
 	typedef typename Titem_::Key Key;                            ///< Make Titem_::Key a property of this class.
-	typedef SmallArray<Titem_, 65536, 256> CItemArray;           ///< Type that we will use as item container.
+	typedef CNodeArenaT<Titem_> CItemArray;                      ///< Type that we will use as item container.
 	typedef CHashTableT<Titem_, Thash_bits_open_  > COpenList;   ///< How pointers to open nodes will be stored.
 	typedef CHashTableT<Titem_, Thash_bits_closed_> CClosedList; ///< How pointers to closed nodes will be stored.
-	typedef CBinaryHeapT<Titem_> CPriorityQueue;                 ///< How the priority queue will be managed.
+	typedef Tqueue_ CPriorityQueue;                              ///< How the priority queue will be managed.
+
+	/** Number of node blocks the shared arena keeps after a search. */
+	static const uint MAX_KEPT_BLOCKS = 64;
 
 protected:
-	CItemArray      m_arr;        ///< Here we store full item data (Titem_).
+	CItemArray      m_own_arr;    ///< Item storage, only used when the shared one is in use by another list.
+	CItemArray     &m_arr;        ///< Here we store full item data (Titem_).
 	COpenList       m_open;       ///< Hash table of pointers to open item data.
 	CClosedList     m_closed;     ///< Hash table of pointers to closed item data.
 	CPriorityQueue  m_open_queue; ///< Priority queue of pointers to open item data.
 	Titem          *m_new_node;   ///< New open node under construction.
 
+	/** Get the item storage shared by all node lists of this type. */
+	static CItemArray &SharedArena()
+	{
+		static CItemArray s_arena;
+		return s_arena;
+	}
+
 public:
 	/** default constructor */
-	CNodeList_HashTableT() : m_open_queue(2048)
+	CNodeList_HashTableT() : m_arr(SharedArena().m_in_use ? m_own_arr : SharedArena()), m_open_queue(2048)
 	{
 		m_new_node = NULL;
+		m_arr.m_in_use = true;
 	}
 
 	/** destructor */
 	~CNodeList_HashTableT()
 	{
+		m_arr.Clear();
+		m_arr.Trim(MAX_KEPT_BLOCKS);
+		m_arr.m_in_use = false;
 	}
 
 	/** return number of open nodes */
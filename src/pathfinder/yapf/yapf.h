@@ -16,6 +16,7 @@
 #include "../../track_type.h"
 #include "../../vehicle_type.h"
 #include "../../ship.h"
+#include "../../roadveh.h"
 #include "../pathfinder_type.h"
 
 /**
@@ -43,9 +44,10 @@ bool YapfShipCheckReverse(const Ship *v);
  * @param enterdir  diagonal direction which the RV will enter this new tile from
  * @param trackdirs available trackdirs on the new tile (to choose from)
  * @param path_found [out] Whether a path has been found (true) or has been guessed (false)
+ * @param path_cache [out] Trackdirs to take at the following junctions
  * @return          the best trackdir for next turn or INVALID_TRACKDIR if the path could not be found
  */
-Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, bool &path_found);
+Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, bool &path_found, RoadVehPathCache &path_cache);
 
 /**
  * Finds the best path for given train using YAPF.
@@ -98,4 +100,31 @@ bool YapfTrainCheckReverse(const Train *v);
  */
 bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, bool override_railtype);
 
+/**
+ * Queue a path search for a train that will choose its track in the next tick, see #YapfTrainStartPathSearches.
+ * @param v      the train
+ * @param origin the tile and trackdir the reservation of the train will end at when it chooses
+ */
+void YapfTrainQueuePathSearch(const Train *v, const struct PBSTileInfo &origin);
+
+/**
+ * Run the queued train path searches. The results are used by #YapfTrainChooseTrack when
+ * the train and its reservation did not change, until the next call to #YapfTrainDiscardPathSearches.
+ * Nothing in the game may change until #YapfTrainWaitForPathSearches returned.
+ * @param threaded whether the searches may run in a separate thread
+ */
+void YapfTrainStartPathSearches(bool threaded);
+
+/** Wait until the train path searches started by #YapfTrainStartPathSearches are done. */
+void YapfTrainWaitForPathSearches();
+
+/** Wait for the running train path searches and forget all their results. */
+void YapfTrainDiscardPathSearches();
+
+/**
+ * Check whether the results of the train path searches are still valid.
+ * @return true if #YapfTrainStartPathSearches was called after the last #YapfTrainDiscardPathSearches.
+ */
+bool YapfTrainHasPathSearches();
+
 #endif /* YAPF_H */
@@ -14,6 +14,7 @@
 
 #include "../../debug.h"
 #include "../../settings_type.h"
+#include "../pathfinder_stats.h"
 
 extern int _total_pf_time_us;
 
@@ -124,6 +125,11 @@ public:
 
 		CPerformanceTimer perf;
 		perf.Start();
+		uint64 start_time = GetPathfinderTimer();
+		int num_steps = m_num_steps;
+		int cache_hits = m_stats_cache_hits;
+		int cost_calcs = m_stats_cost_calcs;
+		bool exhausted = false;
 
 		Yapf().PfSetStartupNodes();
 		bool bDestFound = true;
@@ -146,12 +152,15 @@ public:
 				m_nodes.InsertClosedNode(*n);
 			} else {
 				bDestFound = false;
+				exhausted = true;
 				break;
 			}
 		}
 
 		bDestFound &= (m_pBestDestNode != NULL);
 
+		RecordPathfinderSearch(VehicleType::EXPECTED_TYPE, m_num_steps - num_steps, m_stats_cache_hits - cache_hits, m_stats_cost_calcs - cost_calcs, exhausted, start_time);
+
 		perf.Stop();
 		if (_debug_yapf_level >= 2) {
 			int t = perf.Get(1000000);
@@ -250,9 +259,7 @@ public:
 
 		bool bValid = Yapf().PfCalcCost(n, &tf);
 
-		if (bCached) {
-			Yapf().PfNodeCacheFlush(n);
-		}
+		Yapf().PfNodeCacheFlush(n);
 
 		if (bValid) bValid = Yapf().PfCalcEstimate(n);
 
@@ -21,4 +21,36 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+/**
+ * Use this function to notify YAPF that the road layout may have changed.
+ * This drops the cost fields of all road vehicle destinations.
+ */
+void YapfNotifyRoadLayoutChange();
+
+/** Statistics of the rail segment cost cache. */
+struct YapfSegmentCacheStats {
+	uint segments;    ///< Number of segments with a cached cost.
+	uint hits;        ///< Number of segment costs taken from the cache.
+	uint misses;      ///< Number of segment costs that had to be calculated.
+	uint invalidated; ///< Number of segments dropped because their tiles changed.
+	uint flushes;     ///< Number of times the whole cache was dropped.
+};
+
+void YapfGetSegmentCacheStats(YapfSegmentCacheStats *stats);
+void YapfResetSegmentCacheStats();
+
+/** Statistics of the cost fields of road vehicle destinations. */
+struct YapfRoadFieldStats {
+	uint fields;  ///< Number of destinations with a cost field.
+	uint nodes;   ///< Number of tile/trackdir pairs in all cost fields.
+	uint builds;  ///< Number of cost fields that were built.
+	uint hits;    ///< Number of choices taken from a cost field.
+	uint misses;  ///< Number of choices that needed a normal search.
+	uint flushes; ///< Number of times all cost fields were dropped.
+};
+
+void YapfGetRoadFieldStats(YapfRoadFieldStats *stats);
+void YapfResetRoadFieldStats();
+void YapfCheckRoadFields();
+
 #endif /* YAPF_CACHE_H */
@@ -13,6 +13,7 @@
 #define YAPF_COSTCACHE_HPP
 
 #include "../../date_func.h"
+#include "../../tilearea_index.h"
 
 /**
  * CYapfSegmentCostCacheNoneT - the formal only yapf cost cache provider that implements
@@ -36,7 +37,7 @@ public:
 	}
 
 	/**
-	 * Called by YAPF to flush the cached segment cost data back into cache storage.
+	 * Called by YAPF after the cost of the given node was calculated.
 	 *  Current cache implementation doesn't use that.
 	 */
 	inline void PfNodeCacheFlush(Node &n)
@@ -83,7 +84,7 @@ public:
 	}
 
 	/**
-	 * Called by YAPF to flush the cached segment cost data back into cache storage.
+	 * Called by YAPF after the cost of the given node was calculated.
 	 *  Current cache implementation doesn't use that.
 	 */
 	inline void PfNodeCacheFlush(Node &n)
@@ -93,19 +94,53 @@ public:
 
 
 /**
- * Base class for segment cost cache providers. Contains global counter
- *  of track layout changes and static notification function called whenever
- *  the track layout changes. It is implemented as base class because it needs
- *  to be shared between all rail YAPF types (one shared counter, one notification
- *  function.
+ * Base class for segment cost cache providers. Contains the list of tiles
+ *  whose track layout changed, the cache statistics and the static
+ *  notification function called whenever the track layout changes. Every
+ *  rail YAPF type has its own cache, so each cache keeps its own list of
+ *  changed tiles; the notification function adds the tile to all of them.
  */
 struct CSegmentCostCacheBase
 {
-	static int   s_rail_change_counter;
+	/** Above this number of changed tiles the whole cache is flushed instead. */
+	static const uint MAX_CHANGED_TILES = 1024;
+
+	static SmallVector<CSegmentCostCacheBase *, 8> s_caches; ///< All segment cost caches that were created.
+
+	static uint  s_segments;    ///< Number of segments with a cached cost, in all caches.
+	static uint  s_hits;        ///< Number of segment costs taken from the cache.
+	static uint  s_misses;      ///< Number of segment costs that had to be calculated.
+	static uint  s_invalidated; ///< Number of segments dropped because their tiles changed.
+	static uint  s_flushes;     ///< Number of times a whole cache was dropped.
+
+	SmallVector<TileIndex, 16> m_changed_tiles; ///< Tiles changed since this cache was last used.
+	bool         m_flush_all;   ///< Flush this whole cache before it is used again.
+	uint         m_segments;    ///< Number of segments with a cached cost in this cache.
+
+	inline CSegmentCostCacheBase() : m_flush_all(false), m_segments(0)
+	{
+		*s_caches.Append() = this;
+	}
+
+	/**
+	 * Remember a changed tile until the cache is used again.
+	 * @param tile The changed tile, or INVALID_TILE to flush the whole cache.
+	 */
+	inline void AddChangedTile(TileIndex tile)
+	{
+		if (tile == INVALID_TILE || m_changed_tiles.Length() >= MAX_CHANGED_TILES) {
+			m_flush_all = true;
+			m_changed_tiles.Clear();
+		} else if (!m_flush_all) {
+			*m_changed_tiles.Append() = tile;
+		}
+	}
 
 	static void NotifyTrackLayoutChange(TileIndex tile, Track track)
 	{
-		s_rail_change_counter++;
+		for (CSegmentCostCacheBase **it = s_caches.Begin(); it != s_caches.End(); it++) {
+			(*it)->AddChangedTile(tile);
+		}
 	}
 };
 
@@ -130,14 +165,60 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 
 	HashTable    m_map;
 	Heap         m_heap;
+	TileAreaIndex<Tsegment *> m_index; ///< Segments with a cached cost by the tiles they depend on.
+	uint         m_dropped;            ///< Number of segments in m_heap that are no longer in m_map.
 
-	inline CSegmentCostCacheT() {}
+	inline CSegmentCostCacheT() : m_dropped(0)
+	{
+		m_index.Reset();
+	}
 
 	/** flush (clear) the cache */
 	inline void Flush()
 	{
 		m_map.Clear();
 		m_heap.Clear();
+		m_index.Reset();
+		m_dropped = 0;
+		s_segments -= m_segments;
+		m_segments = 0;
+	}
+
+	/**
+	 * Make a segment whose cost was just calculated findable by its tiles.
+	 * @param segment The segment, its area covers the tiles it passes.
+	 */
+	inline void Register(Tsegment &segment)
+	{
+		/* The cost also depends on the tiles next to the ones passed. */
+		TileArea &area = segment.m_area;
+		uint x = TileX(area.tile);
+		uint y = TileY(area.tile);
+		area = TileArea(TileXY(max(x, 1U) - 1, max(y, 1U) - 1), TileXY(min(x + area.w, MapMaxX()), min(y + area.h, MapMaxY())));
+		m_index.Add(&segment, area);
+		m_segments++;
+		s_segments++;
+	}
+
+	/**
+	 * Drop the cached segments that depend on a tile.
+	 * @param tile The changed tile.
+	 */
+	inline void Invalidate(TileIndex tile)
+	{
+		SmallVector<Tsegment *, 16> found;
+		m_index.Find(TileX(tile), TileY(tile), TileX(tile), TileY(tile), &found);
+		for (Tsegment **it = found.Begin(); it != found.End(); it++) {
+			Tsegment &segment = **it;
+			if (!segment.m_area.Contains(tile)) continue;
+
+			m_index.Remove(&segment, segment.m_area);
+			m_map.Pop(segment);
+			m_dropped++;
+			m_segments--;
+			s_segments--;
+			s_invalidated++;
+		}
 	}
 
 	inline Tsegment& Get(Key &key, bool *found)
@@ -172,8 +253,9 @@ public:
 
 protected:
 	Cache &m_global_cache;
+	CachedData *m_new_segment; ///< Global segment of the node being evaluated whose cost is not cached yet.
 
-	inline CYapfSegmentCostCacheGlobalT() : m_global_cache(stGetGlobalCache()) {};
+	inline CYapfSegmentCostCacheGlobalT() : m_global_cache(stGetGlobalCache()), m_new_segment(NULL) {};
 
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
@@ -183,7 +265,6 @@ protected:
 
 	inline static Cache& stGetGlobalCache()
 	{
-		static int last_rail_change_counter = 0;
 		static Date last_date = 0;
 		static Cache C;
 
@@ -194,9 +275,19 @@ protected:
 			_total_pf_time_us = 0;
 		}
 
-		/* delete the cache sometimes... */
-		if (last_rail_change_counter != Cache::s_rail_change_counter) {
-			last_rail_change_counter = Cache::s_rail_change_counter;
+		/* forget the segments passing the changed tiles */
+		if (!C.m_flush_all) {
+			for (const TileIndex *tile = C.m_changed_tiles.Begin(); tile != C.m_changed_tiles.End(); tile++) {
+				C.Invalidate(*tile);
+			}
+			/* Dropped segments keep their storage, so start over once most are dropped. */
+			if (C.m_dropped > Cache::MAX_CHANGED_TILES && C.m_dropped > C.m_heap.Length() / 2) C.m_flush_all = true;
+		}
+		C.m_changed_tiles.Clear();
+
+		if (C.m_flush_all) {
+			C.m_flush_all = false;
+			Cache::s_flushes++;
 			C.Flush();
 		}
 		return C;
@@ -216,15 +307,24 @@ public:
 		bool found;
 		CachedData &item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
+		if (item.m_cost >= 0) {
+			Cache::s_hits++;
+		} else {
+			Cache::s_misses++;
+			m_new_segment = &item;
+		}
 		return found;
 	}
 
 	/**
-	 * Called by YAPF to flush the cached segment cost data back into cache storage.
-	 *  Current cache implementation doesn't use that.
+	 * Called by YAPF after the cost of the given node was calculated.
+	 *  Registers newly calculated global segments, so they can be invalidated.
 	 */
 	inline void PfNodeCacheFlush(Node &n)
 	{
+		if (m_new_segment == NULL) return;
+		if (m_new_segment == n.m_segment && m_new_segment->m_cost >= 0) m_global_cache.Register(*m_new_segment);
+		m_new_segment = NULL;
 	}
 };
 
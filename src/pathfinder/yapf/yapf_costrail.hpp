@@ -333,6 +333,9 @@ public:
 
 		EndSegmentReasonBits end_segment_reason = ESRB_NONE;
 
+		/* the tiles the segment cost depends on */
+		TileArea area(n.m_key.m_tile, 1, 1);
+
 		TrackFollower tf_local(v, Yapf().GetCompatibleRailTypes(), &Yapf().m_perf_ts_cost);
 
 		if (!has_parent) {
@@ -381,6 +384,8 @@ public:
 
 no_entry_cost: // jump here at the beginning if the node has no parent (it is the first node)
 
+			area.Add(cur.tile);
+
 			/* All other tile costs will be calculated here. */
 			segment_cost += Yapf().OneTileCost(cur.tile, cur.td);
 
@@ -508,6 +513,9 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 				break;
 			}
 
+			/* Skipped tunnel/bridge/station tiles lie between the current and the next tile. */
+			area.Add(tf_local.m_new_tile);
+
 			/* Check if the next tile is not a choice. */
 			if (KillFirstBit(tf_local.m_new_td_bits) != TRACKDIR_BIT_NONE) {
 				/* More than one segment will follow. Close this one. */
@@ -579,6 +587,7 @@ no_entry_cost: // jump here at the beginning if the node has no parent (it is th
 			/* Write back the segment information so it can be reused the next time. */
 			segment.m_cost = segment_cost;
 			segment.m_end_segment_reason = end_segment_reason & ESRB_CACHED_MASK;
+			segment.m_area = area;
 			/* Save end of segment back to the node. */
 			n.SetLastTileTrackdir(cur.tile, cur.td);
 		}
@@ -73,6 +73,7 @@ struct CYapfRailSegment
 	TileIndex              m_last_signal_tile;
 	Trackdir               m_last_signal_td;
 	EndSegmentReasonBits   m_end_segment_reason;
+	TileArea               m_area;               ///< Tiles the cost depends on.
 	CYapfRailSegment      *m_hash_next;
 
 	inline CYapfRailSegment(const CYapfRailSegmentKey &key)
@@ -83,6 +84,7 @@ struct CYapfRailSegment
 		, m_last_signal_tile(INVALID_TILE)
 		, m_last_signal_td(INVALID_TRACKDIR)
 		, m_end_segment_reason(ESRB_NONE)
+		, m_area(INVALID_TILE, 0, 0)
 		, m_hash_next(NULL)
 	{}
 
@@ -222,7 +224,7 @@ typedef CYapfRailNodeT<CYapfNodeKeyExitDir>  CYapfRailNodeExitDir;
 typedef CYapfRailNodeT<CYapfNodeKeyTrackDir> CYapfRailNodeTrackDir;
 
 /* Default NodeList types */
-typedef CNodeList_HashTableT<CYapfRailNodeExitDir , 8, 10> CRailNodeListExitDir;
-typedef CNodeList_HashTableT<CYapfRailNodeTrackDir, 8, 10> CRailNodeListTrackDir;
+typedef CNodeList_HashTableT<CYapfRailNodeExitDir , 8, 10, CDaryHeapT<CYapfRailNodeExitDir > > CRailNodeListExitDir;
+typedef CNodeList_HashTableT<CYapfRailNodeTrackDir, 8, 10, CDaryHeapT<CYapfRailNodeTrackDir> > CRailNodeListTrackDir;
 
 #endif /* YAPF_NODE_RAIL_HPP */
@@ -19,12 +19,19 @@ struct CYapfRoadNodeT : CYapfNodeT<Tkey_, CYapfRoadNodeT<Tkey_> > {
 
 	TileIndex m_segment_last_tile;
 	Trackdir  m_segment_last_td;
+	bool      m_is_choice; ///< The node starts at a junction.
 
 	void Set(CYapfRoadNodeT *parent, TileIndex tile, Trackdir td, bool is_choice)
 	{
 		base::Set(parent, tile, td, is_choice);
 		m_segment_last_tile = tile;
 		m_segment_last_td = td;
+		m_is_choice = is_choice;
+	}
+
+	inline bool GetIsChoice() const
+	{
+		return m_is_choice;
 	}
 };
 
@@ -33,7 +40,7 @@ typedef CYapfRoadNodeT<CYapfNodeKeyExitDir>  CYapfRoadNodeExitDir;
 typedef CYapfRoadNodeT<CYapfNodeKeyTrackDir> CYapfRoadNodeTrackDir;
 
 /* Default NodeList types */
-typedef CNodeList_HashTableT<CYapfRoadNodeExitDir , 8, 10> CRoadNodeListExitDir;
-typedef CNodeList_HashTableT<CYapfRoadNodeTrackDir, 8, 10> CRoadNodeListTrackDir;
+typedef CNodeList_HashTableT<CYapfRoadNodeExitDir , 8, 10, CDaryHeapT<CYapfRoadNodeExitDir > > CRoadNodeListExitDir;
+typedef CNodeList_HashTableT<CYapfRoadNodeTrackDir, 8, 10, CDaryHeapT<CYapfRoadNodeTrackDir> > CRoadNodeListTrackDir;
 
 #endif /* YAPF_NODE_ROAD_HPP */
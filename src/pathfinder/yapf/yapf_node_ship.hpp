@@ -21,7 +21,7 @@ typedef CYapfShipNodeT<CYapfNodeKeyExitDir>  CYapfShipNodeExitDir;
 typedef CYapfShipNodeT<CYapfNodeKeyTrackDir> CYapfShipNodeTrackDir;
 
 /* Default NodeList types */
-typedef CNodeList_HashTableT<CYapfShipNodeExitDir , 10, 12> CShipNodeListExitDir;
-typedef CNodeList_HashTableT<CYapfShipNodeTrackDir, 10, 12> CShipNodeListTrackDir;
+typedef CNodeList_HashTableT<CYapfShipNodeExitDir , 10, 12, CDaryHeapT<CYapfShipNodeExitDir > > CShipNodeListExitDir;
+typedef CNodeList_HashTableT<CYapfShipNodeTrackDir, 10, 12, CDaryHeapT<CYapfShipNodeTrackDir> > CShipNodeListTrackDir;
 
 #endif /* YAPF_NODE_SHIP_HPP */
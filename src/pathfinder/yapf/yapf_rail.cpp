@@ -18,6 +18,7 @@
 #include "yapf_destrail.hpp"
 #include "../../viewport_func.h"
 #include "../../newgrf_station.h"
+#include "../../thread/thread.h"
 
 #include "../../safeguards.h"
 
@@ -181,10 +182,6 @@ public:
 
 		if (target != NULL) target->okay = true;
 
-		if (Yapf().CanUseGlobalCache(*m_res_node)) {
-			YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
-		}
-
 		return true;
 	}
 };
@@ -342,6 +339,9 @@ public:
 		/* Set origin and destination. */
 		Yapf().SetOrigin(t1, td);
 		Yapf().SetDestination(v, override_railtype);
+		/* The segments of this search end at reserved track, so they can't be
+		 * cached: reservations change without notifying the cache. */
+		Yapf().DisableCache(true);
 
 		bool bFound = Yapf().FindPath(v);
 		if (!bFound) return false;
@@ -425,14 +425,37 @@ public:
 	{
 		if (target != NULL) target->tile = INVALID_TILE;
 
-		/* set origin and destination nodes */
 		PBSTileInfo origin = FollowTrainReservation(v);
+		path_found = this->SearchRailTrack(v, origin);
+		return this->FinishRailTrack(path_found, reserve_track, target);
+	}
+
+	/**
+	 * First half of ChooseRailTrack(): find the path. This doesn't change anything
+	 * in the game, so it may run while the game is not looking.
+	 * @param v The train.
+	 * @param origin End of the reservation of the train.
+	 * @return Whether a path has been found (true) or has been guessed (false).
+	 */
+	inline bool SearchRailTrack(const Train *v, const PBSTileInfo &origin)
+	{
+		/* set origin and destination nodes */
 		Yapf().SetOrigin(origin.tile, origin.trackdir, INVALID_TILE, INVALID_TRACKDIR, 1, true);
 		Yapf().SetDestination(v);
 
 		/* find the best path */
-		path_found = Yapf().FindPath(v);
+		return Yapf().FindPath(v);
+	}
 
+	/**
+	 * Second half of ChooseRailTrack(): choose the track and reserve the path found by SearchRailTrack().
+	 * @param path_found [in,out] Result of SearchRailTrack(), whether a path has been found.
+	 * @param reserve_track Whether to reserve the found path.
+	 * @param target [out] The target tile of the reservation.
+	 * @return The trackdir to take, or INVALID_TRACKDIR.
+	 */
+	inline Trackdir FinishRailTrack(bool &path_found, bool reserve_track, PBSTileInfo *target)
+	{
 		/* if path not found - return INVALID_TRACKDIR */
 		Trackdir next_trackdir = INVALID_TRACKDIR;
 		Node *pNode = Yapf().GetBestNode();
@@ -532,8 +555,163 @@ struct CYapfAnySafeTileRail1 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail1, CF
 struct CYapfAnySafeTileRail2 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail2, CFollowTrackFreeRailNo90, CRailNodeListTrackDir, CYapfDestinationAnySafeTileRailT , CYapfFollowAnySafeTileRailT> > {};
 
 
+/** Path search for a train that is done ahead of time, see YapfTrainStartPathSearches(). */
+struct RailPathSearch {
+	const Train *v;            ///< The train.
+	TileIndex tile;            ///< Tile of the train when searching.
+	PBSTileInfo origin;        ///< End of the reservation the search started from.
+	OrderType order_type;      ///< Type of the current order of the train when searching.
+	DestinationID order_dest;  ///< Destination of the current order of the train when searching.
+	TileIndex dest_tile;       ///< Destination tile of the train when searching.
+	RailTypes railtypes;       ///< Compatible rail types of the train when searching.
+	bool path_found;           ///< Whether a path has been found.
+
+	RailPathSearch(const Train *v, const PBSTileInfo &origin) :
+		v(v), tile(v->tile), origin(origin), order_type(v->current_order.GetType()), order_dest(v->current_order.GetDestination()),
+		dest_tile(v->dest_tile), railtypes(v->compatible_railtypes), path_found(false)
+	{
+	}
+
+	virtual ~RailPathSearch() {}
+
+	/** Find the path; this doesn't change anything in the game. */
+	virtual void Search() = 0;
+
+	/** Choose the track and reserve the found path, see CYapfFollowRailT::FinishRailTrack(). */
+	virtual Trackdir Finish(bool &path_found, bool reserve_track, PBSTileInfo *target) = 0;
+
+	/**
+	 * Check whether the search used the same input as a search for the train now would.
+	 * @param origin End of the reservation of the train now.
+	 * @return True if the result of the search can be used.
+	 */
+	bool Matches(const PBSTileInfo &origin) const
+	{
+		return this->origin.tile == origin.tile && this->origin.trackdir == origin.trackdir &&
+				this->tile == this->v->tile && this->order_type == this->v->current_order.GetType() &&
+				this->order_dest == this->v->current_order.GetDestination() &&
+				this->dest_tile == this->v->dest_tile && this->railtypes == this->v->compatible_railtypes;
+	}
+};
+
+/** Path search ahead of time with a specific pathfinder class. */
+template <class Tpf>
+struct RailPathSearchT : RailPathSearch {
+	Tpf pf; ///< The pathfinder, keeping the found path until it is used.
+
+	RailPathSearchT(const Train *v, const PBSTileInfo &origin) : RailPathSearch(v, origin)
+	{
+		/* The segment cost cache may change before the search runs. */
+		this->pf.DisableCache(true);
+	}
+
+	virtual void Search()
+	{
+		this->path_found = this->pf.SearchRailTrack(this->v, this->origin);
+	}
+
+	virtual Trackdir Finish(bool &path_found, bool reserve_track, PBSTileInfo *target)
+	{
+		path_found = this->path_found;
+		return this->pf.FinishRailTrack(path_found, reserve_track, target);
+	}
+};
+
+static AutoDeleteSmallVector<RailPathSearch *, 16> _rail_path_searches; ///< Train path searches done ahead of time.
+static ThreadObject *_rail_path_search_thread = NULL;                  ///< Thread running the path searches, if any.
+static bool _rail_path_searches_valid = false;                          ///< Whether nothing changed since the path searches were started.
+
+void YapfTrainQueuePathSearch(const Train *v, const PBSTileInfo &origin)
+{
+	assert(_rail_path_search_thread == NULL);
+
+	/* Occupy the node storage shared by the rail pathfinders while creating
+	 * the search, so the search doesn't keep it away from the pathfinders
+	 * that run before its result is used. */
+	CYapfRail1 shared;
+	if (_settings_game.pf.forbid_90_deg) {
+		*_rail_path_searches.Append() = new RailPathSearchT<CYapfRail2>(v, origin);
+	} else {
+		*_rail_path_searches.Append() = new RailPathSearchT<CYapfRail1>(v, origin);
+	}
+}
+
+/** Run all queued train path searches. */
+static void RunRailPathSearches(void *)
+{
+	for (RailPathSearch **it = _rail_path_searches.Begin(); it != _rail_path_searches.End(); it++) {
+		(*it)->Search();
+	}
+}
+
+void YapfTrainStartPathSearches(bool threaded)
+{
+	assert(_rail_path_search_thread == NULL);
+
+	_rail_path_searches_valid = true;
+	if (_rail_path_searches.Length() == 0) return;
+
+	if (!threaded || !ThreadObject::New(&RunRailPathSearches, NULL, &_rail_path_search_thread, "ottd:pathfind")) {
+		RunRailPathSearches(NULL);
+	}
+}
+
+void YapfTrainWaitForPathSearches()
+{
+	if (_rail_path_search_thread == NULL) return;
+
+	_rail_path_search_thread->Join();
+	delete _rail_path_search_thread;
+	_rail_path_search_thread = NULL;
+}
+
+void YapfTrainDiscardPathSearches()
+{
+	YapfTrainWaitForPathSearches();
+	_rail_path_searches.Clear();
+	_rail_path_searches_valid = false;
+}
+
+bool YapfTrainHasPathSearches()
+{
+	return _rail_path_searches_valid;
+}
+
+/**
+ * Choose the track with the path searched ahead of time, if there is one for the train.
+ * @return The chosen trackdir, or INVALID_TRACKDIR when the search has to be done now.
+ */
+static Trackdir ChooseRailTrackFromSearch(const Train *v, bool &path_found, bool reserve_track, PBSTileInfo *target)
+{
+	YapfTrainWaitForPathSearches();
+
+	for (RailPathSearch **it = _rail_path_searches.Begin(); it != _rail_path_searches.End(); it++) {
+		RailPathSearch *search = *it;
+		if (search->v != v) continue;
+
+		/* Each search is only good for a single track choice. */
+		_rail_path_searches.Erase(it);
+
+		Trackdir td = INVALID_TRACKDIR;
+		if (search->Matches(FollowTrainReservation(v))) {
+			if (target != NULL) target->tile = INVALID_TILE;
+			td = search->Finish(path_found, reserve_track, target);
+			/* The found path was reserved by someone else in the meantime; search again. */
+			if (target != NULL && target->tile != INVALID_TILE && !target->okay) td = INVALID_TRACKDIR;
+		}
+		delete search;
+		return td;
+	}
+	return INVALID_TRACKDIR;
+}
+
 Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
 {
+	if (_rail_path_searches.Length() != 0) {
+		Trackdir td = ChooseRailTrackFromSearch(v, path_found, reserve_track, target);
+		if (td != INVALID_TRACKDIR) return TrackdirToTrack(td);
+	}
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseRailTrack)(const Train*, TileIndex, DiagDirection, TrackBits, bool&, bool, PBSTileInfo*);
 	PfnChooseRailTrack pfnChooseRailTrack = &CYapfRail1::stChooseRailTrack;
@@ -638,10 +816,36 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 	return pfnFindNearestSafeTile(v, tile, td, override_railtype);
 }
 
-/** if any track changes, this counter is incremented - that will invalidate segment cost cache */
-int CSegmentCostCacheBase::s_rail_change_counter = 0;
+SmallVector<CSegmentCostCacheBase *, 8> CSegmentCostCacheBase::s_caches;
+uint CSegmentCostCacheBase::s_segments    = 0;
+uint CSegmentCostCacheBase::s_hits        = 0;
+uint CSegmentCostCacheBase::s_misses      = 0;
+uint CSegmentCostCacheBase::s_invalidated = 0;
+uint CSegmentCostCacheBase::s_flushes     = 0;
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
 }
+
+/**
+ * Get the statistics of the rail segment cost cache.
+ * @param[out] stats The statistics since they were last reset.
+ */
+void YapfGetSegmentCacheStats(YapfSegmentCacheStats *stats)
+{
+	stats->segments    = CSegmentCostCacheBase::s_segments;
+	stats->hits        = CSegmentCostCacheBase::s_hits;
+	stats->misses      = CSegmentCostCacheBase::s_misses;
+	stats->invalidated = CSegmentCostCacheBase::s_invalidated;
+	stats->flushes     = CSegmentCostCacheBase::s_flushes;
+}
+
+/** Reset the counters of the rail segment cost cache; the number of segments stays. */
+void YapfResetSegmentCacheStats()
+{
+	CSegmentCostCacheBase::s_hits        = 0;
+	CSegmentCostCacheBase::s_misses      = 0;
+	CSegmentCostCacheBase::s_invalidated = 0;
+	CSegmentCostCacheBase::s_flushes     = 0;
+}
@@ -13,10 +13,64 @@
 #include "yapf.hpp"
 #include "yapf_node_road.hpp"
 #include "../../roadstop_base.h"
+#include "../../debug.h"
+#include "yapf_cache.h"
+#include <algorithm>
+#include <list>
+#include <map>
+#include <queue>
+#include <vector>
 
 #include "../../safeguards.h"
 
 
+/**
+ * Penalty for going up hill from one tile to the next.
+ * @param tile The tile the road vehicle leaves.
+ * @param next_tile The tile the road vehicle enters.
+ * @param settings The YAPF settings.
+ * @return The penalty.
+ */
+static int RoadSlopeCost(TileIndex tile, TileIndex next_tile, const YAPFSettings &settings)
+{
+	/* height of the center of the current tile */
+	int x1 = TileX(tile) * TILE_SIZE;
+	int y1 = TileY(tile) * TILE_SIZE;
+	int z1 = GetSlopePixelZ(x1 + TILE_SIZE / 2, y1 + TILE_SIZE / 2);
+
+	/* height of the center of the next tile */
+	int x2 = TileX(next_tile) * TILE_SIZE;
+	int y2 = TileY(next_tile) * TILE_SIZE;
+	int z2 = GetSlopePixelZ(x2 + TILE_SIZE / 2, y2 + TILE_SIZE / 2);
+
+	if (z2 - z1 > 1) {
+		/* Slope up */
+		return settings.road_slope_penalty;
+	}
+	return 0;
+}
+
+/**
+ * Cost of driving over one tile, without the penalties for the vehicles in road stops.
+ * @param tile The tile.
+ * @param trackdir The trackdir the road vehicle takes on the tile.
+ * @param settings The YAPF settings.
+ * @return The cost.
+ */
+static int RoadTileBaseCost(TileIndex tile, Trackdir trackdir, const YAPFSettings &settings)
+{
+	/* non-diagonal trackdir */
+	if (!IsDiagonalTrackdir(trackdir)) return YAPF_TILE_CORNER_LENGTH + settings.road_curve_penalty;
+
+	int cost = YAPF_TILE_LENGTH;
+	/* Increase the cost for level crossings */
+	if (IsLevelCrossingTile(tile)) cost += settings.road_crossing_penalty;
+	/* Increase the cost for drive-through road stops */
+	if (IsDriveThroughStopTile(tile)) cost += settings.road_stop_penalty;
+	return cost;
+}
+
+
 template <class Types>
 class CYapfCostRoadT
 {
@@ -39,63 +93,28 @@ protected:
 
 	int SlopeCost(TileIndex tile, TileIndex next_tile, Trackdir trackdir)
 	{
-		/* height of the center of the current tile */
-		int x1 = TileX(tile) * TILE_SIZE;
-		int y1 = TileY(tile) * TILE_SIZE;
-		int z1 = GetSlopePixelZ(x1 + TILE_SIZE / 2, y1 + TILE_SIZE / 2);
-
-		/* height of the center of the next tile */
-		int x2 = TileX(next_tile) * TILE_SIZE;
-		int y2 = TileY(next_tile) * TILE_SIZE;
-		int z2 = GetSlopePixelZ(x2 + TILE_SIZE / 2, y2 + TILE_SIZE / 2);
-
-		if (z2 - z1 > 1) {
-			/* Slope up */
-			return Yapf().PfGetSettings().road_slope_penalty;
-		}
-		return 0;
+		return RoadSlopeCost(tile, next_tile, Yapf().PfGetSettings());
 	}
 
 	/** return one tile cost */
 	inline int OneTileCost(TileIndex tile, Trackdir trackdir)
 	{
-		int cost = 0;
 		/* set base cost */
-		if (IsDiagonalTrackdir(trackdir)) {
-			cost += YAPF_TILE_LENGTH;
-			switch (GetTileType(tile)) {
-				case MP_ROAD:
-					/* Increase the cost for level crossings */
-					if (IsLevelCrossing(tile)) {
-						cost += Yapf().PfGetSettings().road_crossing_penalty;
-					}
-					break;
-
-				case MP_STATION: {
-					const RoadStop *rs = RoadStop::GetByTile(tile, GetRoadStopType(tile));
-					if (IsDriveThroughStopTile(tile)) {
-						/* Increase the cost for drive-through road stops */
-						cost += Yapf().PfGetSettings().road_stop_penalty;
-						DiagDirection dir = TrackdirToExitdir(trackdir);
-						if (!RoadStop::IsDriveThroughRoadStopContinuation(tile, tile - TileOffsByDiagDir(dir))) {
-							/* When we're the first road stop in a 'queue' of them we increase
-							 * cost based on the fill percentage of the whole queue. */
-							const RoadStop::Entry *entry = rs->GetEntry(dir);
-							cost += entry->GetOccupied() * Yapf().PfGetSettings().road_stop_occupied_penalty / entry->GetLength();
-						}
-					} else {
-						/* Increase cost for filled road stops */
-						cost += Yapf().PfGetSettings().road_stop_bay_occupied_penalty * (!rs->IsFreeBay(0) + !rs->IsFreeBay(1)) / 2;
-					}
-					break;
+		int cost = RoadTileBaseCost(tile, trackdir, Yapf().PfGetSettings());
+		if (IsDiagonalTrackdir(trackdir) && IsTileType(tile, MP_STATION)) {
+			const RoadStop *rs = RoadStop::GetByTile(tile, GetRoadStopType(tile));
+			if (IsDriveThroughStopTile(tile)) {
+				DiagDirection dir = TrackdirToExitdir(trackdir);
+				if (!RoadStop::IsDriveThroughRoadStopContinuation(tile, tile - TileOffsByDiagDir(dir))) {
+					/* When we're the first road stop in a 'queue' of them we increase
+					 * cost based on the fill percentage of the whole queue. */
+					const RoadStop::Entry *entry = rs->GetEntry(dir);
+					cost += entry->GetOccupied() * Yapf().PfGetSettings().road_stop_occupied_penalty / entry->GetLength();
 				}
-
-				default:
-					break;
+			} else {
+				/* Increase cost for filled road stops */
+				cost += Yapf().PfGetSettings().road_stop_bay_occupied_penalty * (!rs->IsFreeBay(0) + !rs->IsFreeBay(1)) / 2;
 			}
-		} else {
-			/* non-diagonal trackdir */
-			cost = YAPF_TILE_CORNER_LENGTH + Yapf().PfGetSettings().road_curve_penalty;
 		}
 		return cost;
 	}
@@ -238,6 +257,12 @@ protected:
 	bool         m_non_artic;
 
 public:
+	/** Station the vehicle is going to, or #INVALID_STATION. */
+	inline StationID GetDestinationStation() const
+	{
+		return m_dest_station;
+	}
+
 	void SetDestination(const RoadVehicle *v)
 	{
 		if (v->current_order.IsType(OT_GOTO_STATION)) {
@@ -310,6 +335,22 @@ public:
 };
 
 
+/**
+ * Check whether a tile is within some distance of a tile area.
+ * @param tile The tile to check.
+ * @param area The area.
+ * @param dist Maximum distance in tiles, in both directions.
+ * @return True if the tile is at most \a dist tiles away from the area.
+ */
+static inline bool IsNearArea(TileIndex tile, const TileArea &area, uint dist)
+{
+	if (area.tile == INVALID_TILE) return false;
+	uint x = TileX(tile);
+	uint y = TileY(tile);
+	uint left = TileX(area.tile);
+	uint top = TileY(area.tile);
+	return x + dist >= left && x <= left + area.w - 1 + dist && y + dist >= top && y <= top + area.h - 1 + dist;
+}
 
 template <class Types>
 class CYapfFollowRoadT
@@ -348,13 +389,13 @@ public:
 		return 'r';
 	}
 
-	static Trackdir stChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found)
+	static Trackdir stChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, RoadVehPathCache &path_cache)
 	{
 		Tpf pf;
-		return pf.ChooseRoadTrack(v, tile, enterdir, path_found);
+		return pf.ChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
 	}
 
-	inline Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found)
+	inline Trackdir ChooseRoadTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found, RoadVehPathCache &path_cache)
 	{
 		/* Handle special case - when next tile is destination tile.
 		 * However, when going to a station the (initial) destination
@@ -382,15 +423,48 @@ public:
 		Trackdir next_trackdir = INVALID_TRACKDIR;
 		Node *pNode = Yapf().GetBestNode();
 		if (pNode != NULL) {
+			uint steps = 0;
+			for (Node *n = pNode; n->m_parent != NULL; n = n->m_parent) steps++;
+
 			/* path was found or at least suggested
-			 * walk through the path back to its origin */
+			 * walk through the path back to its origin,
+			 * remembering the choices at the first junctions */
+			path_cache.clear();
 			while (pNode->m_parent != NULL) {
+				steps--;
+				if (pNode->GetIsChoice() && steps < YAPF_ROADVEH_PATH_CACHE_SEGMENTS) {
+					TrackdirByte td;
+					td = pNode->GetTrackdir();
+					path_cache.td.push_front(td);
+					path_cache.tile.push_front(pNode->GetTile());
+				}
 				pNode = pNode->m_parent;
 			}
 			/* return trackdir from the best origin node (one of start nodes) */
 			Node &best_next_node = *pNode;
 			assert(best_next_node.GetTile() == tile);
 			next_trackdir = best_next_node.GetTrackdir();
+
+			/* The destination tile is handled specially above, do not cache it. */
+			while (!path_cache.empty() && path_cache.tile.back() == v->dest_tile) {
+				path_cache.td.pop_back();
+				path_cache.tile.pop_back();
+			}
+
+			/* Do not cache the last junctions before a station with several
+			 * usable stops, so the vehicle picks the stop it is going to
+			 * use when it gets there. */
+			if (Yapf().GetDestinationStation() != INVALID_STATION) {
+				const Station *st = Station::Get(Yapf().GetDestinationStation());
+				const RoadStop *stop = st->GetPrimaryRoadStop(v);
+				if (stop != NULL && (IsDriveThroughStopTile(stop->xy) || stop->GetNextRoadStop(v) != NULL)) {
+					const TileArea &area = v->IsBus() ? st->bus_station : st->truck_station;
+					while (!path_cache.empty() && IsNearArea(path_cache.tile.back(), area, YAPF_ROADVEH_PATH_CACHE_DESTINATION_LIMIT)) {
+						path_cache.td.pop_back();
+						path_cache.tile.pop_back();
+					}
+				}
+			}
 		}
 		return next_trackdir;
 	}
@@ -497,10 +571,402 @@ struct CYapfRoadAnyDepot1 : CYapfT<CYapfRoad_TypesT<CYapfRoadAnyDepot1, CRoadNod
 struct CYapfRoadAnyDepot2 : CYapfT<CYapfRoad_TypesT<CYapfRoadAnyDepot2, CRoadNodeListExitDir , CYapfDestinationAnyDepotRoadT> > {};
 
 
-Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, bool &path_found)
+/**
+ * Everything the cost field of a road vehicle destination depends on, besides
+ * the map and the YAPF settings. Road vehicles with the same key share a field.
+ */
+struct RoadFieldKey {
+	StationID station; ///< Station the vehicles go to, or #INVALID_STATION.
+	TileIndex tile;    ///< Tile the vehicles go to, when not going to a station.
+	RoadTypes roadtypes; ///< Road types the vehicles can drive on.
+	Owner owner;       ///< Owner of the vehicles; they can only enter its depots.
+	bool bus;          ///< Whether the vehicles use bus stops instead of truck stops.
+	bool non_artic;    ///< Whether the vehicles can use road stops that are no drive-through stops.
+	int max_speed;     ///< Maximum speed of the vehicles, for the speed limits of bridges.
+
+	inline bool operator ==(const RoadFieldKey &other) const
+	{
+		return this->station == other.station && this->tile == other.tile && this->roadtypes == other.roadtypes &&
+				this->owner == other.owner && this->bus == other.bus && this->non_artic == other.non_artic &&
+				this->max_speed == other.max_speed;
+	}
+
+	inline bool operator !=(const RoadFieldKey &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+/** Cost from a tile and trackdir to the destination of a field. */
+struct RoadFieldNode {
+	uint32 key; ///< Tile and trackdir, see #RoadFieldNodeKey.
+	int cost;   ///< Cost to the destination, including the cost of the tile itself.
+
+	inline bool operator <(const RoadFieldNode &other) const
+	{
+		return this->key < other.key;
+	}
+};
+
+static inline uint32 RoadFieldNodeKey(TileIndex tile, Trackdir td)
+{
+	return tile << 4 | td;
+}
+
+static inline bool RoadFieldNodesEqual(const RoadFieldNode &a, const RoadFieldNode &b)
+{
+	return a.key == b.key && a.cost == b.cost;
+}
+
+/**
+ * Cost to a destination from the tiles and trackdirs around it. The field is
+ * built by a search from the destination backwards, and only depends on the
+ * map, the YAPF settings and its key. So a field taken from the cache gives
+ * the same choices as a freshly built one, in every client.
+ * The costs of vehicles in road stops are left out, as those change all the time.
+ */
+struct RoadField {
+	RoadFieldKey key;                 ///< The vehicles and destination the field is for.
+	VehicleID vehicle;                ///< Vehicle the field was built for, to check it against a rebuilt field.
+	std::vector<RoadFieldNode> nodes; ///< Tiles and trackdirs with their cost, sorted by key.
+
+	/**
+	 * Get the cost to the destination.
+	 * @param tile The tile.
+	 * @param td The trackdir on the tile.
+	 * @return The cost, or -1 when the tile and trackdir are not in the field.
+	 */
+	int GetCost(TileIndex tile, Trackdir td) const
+	{
+		RoadFieldNode node = { RoadFieldNodeKey(tile, td), 0 };
+		std::vector<RoadFieldNode>::const_iterator it = std::lower_bound(this->nodes.begin(), this->nodes.end(), node);
+		return (it != this->nodes.end() && it->key == node.key) ? it->cost : -1;
+	}
+};
+
+/** The cost fields, the one used last first. */
+static std::list<RoadField> _road_fields;
+
+static uint _road_field_builds  = 0;
+static uint _road_field_hits    = 0;
+static uint _road_field_misses  = 0;
+static uint _road_field_flushes = 0;
+
+/**
+ * Get the key of the cost field a road vehicle can use.
+ * @param v The road vehicle.
+ * @param[out] key The key.
+ * @return Whether the vehicle goes to a station or a depot, the destinations fields are made for.
+ */
+static bool GetRoadFieldKey(const RoadVehicle *v, RoadFieldKey *key)
+{
+	key->station = INVALID_STATION;
+	key->tile = INVALID_TILE;
+	key->bus = false;
+	key->non_artic = false;
+	if (v->current_order.IsType(OT_GOTO_STATION)) {
+		key->station = v->current_order.GetDestination();
+		key->bus = v->IsBus();
+		key->non_artic = !v->HasArticulatedPart();
+	} else if (v->current_order.IsType(OT_GOTO_DEPOT)) {
+		key->tile = v->dest_tile;
+	} else {
+		return false;
+	}
+	key->roadtypes = v->compatible_roadtypes;
+	key->owner = v->owner;
+	key->max_speed = v->GetDisplayMaxSpeed();
+	return true;
+}
+
+/**
+ * Get the trackdirs a road vehicle could be on at a tile, the way #CFollowTrackRoad sees them.
+ * @param tile The tile.
+ * @param F Track follower of the road vehicle.
+ * @param roadtypes The road types of the road vehicle.
+ * @return The trackdirs.
+ */
+static TrackdirBits GetRoadFieldTrackdirs(TileIndex tile, CFollowTrackRoad &F, RoadTypes roadtypes)
+{
+	TrackdirBits trackdirs = TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_ROAD, roadtypes));
+	if (trackdirs == TRACKDIR_BIT_NONE && F.IsTram()) {
+		/* Single tram bits, see CFollowTrackT::QueryNewTileTrackStatus. */
+		switch (F.GetSingleTramBit(tile)) {
+			case DIAGDIR_NE:
+			case DIAGDIR_SW:
+				return TRACKDIR_BIT_X_NE | TRACKDIR_BIT_X_SW;
+
+			case DIAGDIR_NW:
+			case DIAGDIR_SE:
+				return TRACKDIR_BIT_Y_NW | TRACKDIR_BIT_Y_SE;
+
+			default: break;
+		}
+	}
+	return trackdirs;
+}
+
+/** Builder of a #RoadField: Dijkstra from the destination over the reversed road graph. */
+class RoadFieldBuilder {
+	/** Open node; std::priority_queue returns the largest element first. */
+	struct OpenNode {
+		int cost;
+		uint32 key;
+
+		inline bool operator <(const OpenNode &other) const
+		{
+			if (this->cost != other.cost) return this->cost > other.cost;
+			return this->key > other.key;
+		}
+	};
+
+	/** Lowest cost found so far of a node. */
+	struct Label {
+		int cost;
+		bool settled; ///< Whether the cost is final.
+	};
+
+	const RoadFieldKey &key;
+	const YAPFSettings &settings;
+	CFollowTrackRoad F;
+	std::map<uint32, Label> labels;
+	std::priority_queue<OpenNode> open;
+	RoadField &field;
+
+	void Add(TileIndex tile, Trackdir td, int cost)
+	{
+		uint32 node_key = RoadFieldNodeKey(tile, td);
+		std::map<uint32, Label>::iterator it = this->labels.find(node_key);
+		if (it != this->labels.end()) {
+			if (it->second.settled || it->second.cost <= cost) return;
+			it->second.cost = cost;
+		} else {
+			Label label = { cost, false };
+			this->labels[node_key] = label;
+		}
+		OpenNode node = { cost, node_key };
+		this->open.push(node);
+	}
+
+	/**
+	 * Add the trackdirs on a tile from which a road vehicle gets to the given tile and trackdir.
+	 * @param from The tile the road vehicle comes from.
+	 * @param exitdir The direction the road vehicle leaves \a from in.
+	 * @param tile The tile the road vehicle gets to.
+	 * @param td The trackdir the road vehicle gets to.
+	 * @param cost The cost from \a tile and \a td to the destination.
+	 */
+	void AddPredecessors(TileIndex from, DiagDirection exitdir, TileIndex tile, Trackdir td, int cost)
+	{
+		TrackdirBits trackdirs = GetRoadFieldTrackdirs(from, this->F, this->key.roadtypes);
+		while (trackdirs != TRACKDIR_BIT_NONE) {
+			Trackdir from_td = RemoveFirstTrackdir(&trackdirs);
+			if (TrackdirToExitdir(from_td) != exitdir) continue;
+			/* Follow the road forwards, so one way roads, road stops, depots and turning around are handled like YAPF does. */
+			if (!this->F.Follow(from, from_td) || this->F.m_new_tile != tile || !HasTrackdir(this->F.m_new_td_bits, td)) continue;
+
+			int edge_cost = RoadTileBaseCost(from, from_td, this->settings) + this->F.m_tiles_skipped * YAPF_TILE_LENGTH;
+			edge_cost += RoadSlopeCost(from, tile, this->settings);
+			int min_speed = 0;
+			int max_speed = this->F.GetSpeedLimit(&min_speed);
+			if (max_speed < this->key.max_speed) edge_cost += 1 * (this->key.max_speed - max_speed);
+			if (min_speed > this->key.max_speed) edge_cost += 10 * (min_speed - this->key.max_speed);
+			this->Add(from, from_td, cost + edge_cost);
+		}
+	}
+
+	/** Add the destination tiles and trackdirs. */
+	void AddDestinations()
+	{
+		if (this->key.station == INVALID_STATION) {
+			TrackdirBits trackdirs = GetRoadFieldTrackdirs(this->key.tile, this->F, this->key.roadtypes);
+			while (trackdirs != TRACKDIR_BIT_NONE) {
+				Trackdir td = RemoveFirstTrackdir(&trackdirs);
+				this->Add(this->key.tile, td, RoadTileBaseCost(this->key.tile, td, this->settings));
+			}
+			return;
+		}
+
+		const Station *st = Station::GetIfValid(this->key.station);
+		if (st == NULL) return;
+
+		/* The same tiles CYapfDestinationTileRoadT::PfDetectDestinationTile accepts. */
+		TILE_AREA_LOOP(tile, this->key.bus ? st->bus_station : st->truck_station) {
+			if (!IsTileType(tile, MP_STATION) || GetStationIndex(tile) != this->key.station) continue;
+			if (!(this->key.bus ? IsBusStop(tile) : IsTruckStop(tile))) continue;
+			if (!this->key.non_artic && !IsDriveThroughStopTile(tile)) continue;
+
+			TrackdirBits trackdirs = GetRoadFieldTrackdirs(tile, this->F, this->key.roadtypes);
+			while (trackdirs != TRACKDIR_BIT_NONE) {
+				Trackdir td = RemoveFirstTrackdir(&trackdirs);
+				this->Add(tile, td, RoadTileBaseCost(tile, td, this->settings));
+			}
+		}
+	}
+
+public:
+	RoadFieldBuilder(const RoadVehicle *v, RoadField &field) :
+			key(field.key), settings(_settings_game.pf.yapf), F(v), field(field)
+	{
+	}
+
+	void Build()
+	{
+		this->field.nodes.clear();
+		this->AddDestinations();
+
+		while (!this->open.empty() && this->field.nodes.size() < (size_t)YAPF_ROADVEH_DESTINATION_FIELD_NODES) {
+			OpenNode node = this->open.top();
+			this->open.pop();
+
+			Label &label = this->labels[node.key];
+			if (label.settled || label.cost != node.cost) continue; // found cheaper later
+			label.settled = true;
+
+			RoadFieldNode settled = { node.key, node.cost };
+			this->field.nodes.push_back(settled);
+
+			TileIndex tile = node.key >> 4;
+			Trackdir td = (Trackdir)(node.key & 0xF);
+			for (DiagDirection enterdir = DIAGDIR_BEGIN; enterdir < DIAGDIR_END; enterdir++) {
+				if (!HasTrackdir(DiagdirReachesTrackdirs(enterdir), td)) continue;
+
+				/* Coming from the neighbouring tile, or from the other end of a tunnel or bridge. */
+				if (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(tile) == ReverseDiagDir(enterdir)) {
+					this->AddPredecessors(GetOtherTunnelBridgeEnd(tile), enterdir, tile, td, node.cost);
+				} else {
+					this->AddPredecessors(TileAddByDiagDir(tile, ReverseDiagDir(enterdir)), enterdir, tile, td, node.cost);
+				}
+				/* Turning around on the tile itself, at road ends, depots, road stops and single tram bits. */
+				this->AddPredecessors(tile, ReverseDiagDir(enterdir), tile, td, node.cost);
+			}
+		}
+
+		/* Only the settled nodes are in the field, as only their cost is final. */
+		std::sort(this->field.nodes.begin(), this->field.nodes.end());
+	}
+};
+
+/**
+ * Get the cost field for a road vehicle, building it when it is not cached.
+ * @param v The road vehicle.
+ * @param key The key of the field of the road vehicle.
+ * @return The field.
+ */
+static const RoadField &GetRoadField(const RoadVehicle *v, const RoadFieldKey &key)
+{
+	for (std::list<RoadField>::iterator it = _road_fields.begin(); it != _road_fields.end(); ++it) {
+		if (it->key != key) continue;
+		/* Move it to the front, so the ones used least recently get dropped. */
+		_road_fields.splice(_road_fields.begin(), _road_fields, it);
+		return _road_fields.front();
+	}
+
+	if (_road_fields.size() >= (size_t)YAPF_ROADVEH_DESTINATION_FIELDS) _road_fields.pop_back();
+	_road_fields.push_front(RoadField());
+	RoadField &field = _road_fields.front();
+	field.key = key;
+	field.vehicle = v->index;
+	RoadFieldBuilder(v, field).Build();
+	_road_field_builds++;
+	return field;
+}
+
+/**
+ * Choose the trackdir of a road vehicle with the cost field of its destination.
+ * @param v The road vehicle.
+ * @param tile The tile the road vehicle is about to enter.
+ * @param trackdirs The trackdirs to choose from.
+ * @return The trackdir, or INVALID_TRACKDIR when the field can't tell and a normal search is needed.
+ */
+static Trackdir ChooseRoadTrackByField(const RoadVehicle *v, TileIndex tile, TrackdirBits trackdirs)
+{
+	RoadFieldKey key;
+	if (!GetRoadFieldKey(v, &key)) return INVALID_TRACKDIR;
+
+	/* Near its destination, the normal search lets the vehicle pick a free road stop. */
+	if (tile == v->dest_tile) return INVALID_TRACKDIR;
+	if (key.station != INVALID_STATION) {
+		const Station *st = Station::GetIfValid(key.station);
+		if (st == NULL || IsNearArea(tile, key.bus ? st->bus_station : st->truck_station, YAPF_ROADVEH_PATH_CACHE_DESTINATION_LIMIT)) return INVALID_TRACKDIR;
+	}
+
+	const RoadField &field = GetRoadField(v, key);
+	Trackdir best_td = INVALID_TRACKDIR;
+	int best_cost = INT_MAX;
+	while (trackdirs != TRACKDIR_BIT_NONE) {
+		Trackdir td = RemoveFirstTrackdir(&trackdirs);
+		int cost = field.GetCost(tile, td);
+		if (cost >= 0 && cost < best_cost) {
+			best_cost = cost;
+			best_td = td;
+		}
+	}
+
+	if (best_td == INVALID_TRACKDIR) {
+		_road_field_misses++;
+	} else {
+		_road_field_hits++;
+	}
+	return best_td;
+}
+
+void YapfNotifyRoadLayoutChange()
+{
+	if (_road_fields.empty()) return;
+	_road_fields.clear();
+	_road_field_flushes++;
+}
+
+/**
+ * Get the statistics of the cost fields of road vehicle destinations.
+ * @param[out] stats The statistics since they were last reset.
+ */
+void YapfGetRoadFieldStats(YapfRoadFieldStats *stats)
+{
+	stats->fields = (uint)_road_fields.size();
+	stats->nodes = 0;
+	for (std::list<RoadField>::const_iterator it = _road_fields.begin(); it != _road_fields.end(); ++it) {
+		stats->nodes += (uint)it->nodes.size();
+	}
+	stats->builds  = _road_field_builds;
+	stats->hits    = _road_field_hits;
+	stats->misses  = _road_field_misses;
+	stats->flushes = _road_field_flushes;
+}
+
+/** Reset the counters of the cost fields of road vehicle destinations; the fields stay. */
+void YapfResetRoadFieldStats()
+{
+	_road_field_builds  = 0;
+	_road_field_hits    = 0;
+	_road_field_misses  = 0;
+	_road_field_flushes = 0;
+}
+
+/** Check whether the cached cost fields are still the same as freshly built ones. */
+void YapfCheckRoadFields()
+{
+	for (std::list<RoadField>::const_iterator it = _road_fields.begin(); it != _road_fields.end(); ++it) {
+		/* The field can only be rebuilt with a road vehicle that has the same key. */
+		const RoadVehicle *v = RoadVehicle::GetIfValid(it->vehicle);
+		RoadFieldKey key;
+		if (v == NULL || !GetRoadFieldKey(v, &key) || key != it->key) continue;
+
+		RoadField check;
+		check.key = key;
+		RoadFieldBuilder(v, check).Build();
+		if (check.nodes.size() != it->nodes.size() || !std::equal(check.nodes.begin(), check.nodes.end(), it->nodes.begin(), RoadFieldNodesEqual)) {
+			DEBUG(desync, 2, "road destination field mismatch: vehicle %i, station %i, tile %i", v->index, it->key.station, it->key.tile);
+		}
+	}
+}
+
+
+Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, bool &path_found, RoadVehPathCache &path_cache)
 {
 	/* default is YAPF type 2 */
-	typedef Trackdir (*PfnChooseRoadTrack)(const RoadVehicle*, TileIndex, DiagDirection, bool &path_found);
+	typedef Trackdir (*PfnChooseRoadTrack)(const RoadVehicle*, TileIndex, DiagDirection, bool &path_found, RoadVehPathCache &path_cache);
 	PfnChooseRoadTrack pfnChooseRoadTrack = &CYapfRoad2::stChooseRoadTrack; // default: ExitDir, allow 90-deg
 
 	/* check if non-default YAPF type should be used */
@@ -508,7 +974,17 @@ Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDi
 		pfnChooseRoadTrack = &CYapfRoad1::stChooseRoadTrack; // Trackdir, allow 90-deg
 	}
 
-	Trackdir td_ret = pfnChooseRoadTrack(v, tile, enterdir, path_found);
+	if (_settings_game.pf.yapf.road_destination_fields) {
+		Trackdir td_field = ChooseRoadTrackByField(v, tile, trackdirs);
+		if (td_field != INVALID_TRACKDIR) {
+			/* The following choices come from the field too. */
+			path_cache.clear();
+			path_found = true;
+			return td_field;
+		}
+	}
+
+	Trackdir td_ret = pfnChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
 	return (td_ret != INVALID_TRACKDIR) ? td_ret : (Trackdir)FindFirstBit2x64(trackdirs);
 }
 
@@ -14,9 +14,82 @@
 
 #include "yapf.hpp"
 #include "yapf_node_ship.hpp"
+#include "../water_regions.h"
 
 #include "../../safeguards.h"
 
+/**
+ * Destination module of YAPF for ships. Besides the destination tile it can
+ * search for a water region patch on the way to it.
+ */
+template <class Types>
+class CYapfDestinationShipT : public CYapfDestinationTileT<Types>
+{
+public:
+	typedef CYapfDestinationTileT<Types> base;
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+
+protected:
+	WaterRegionPatchDesc m_intermediate; ///< Patch to search for instead of the destination tile, if valid.
+
+public:
+	CYapfDestinationShipT()
+	{
+		m_intermediate.label = INVALID_WATER_REGION_PATCH;
+	}
+
+	/** Search for any tile in a water region patch instead of the destination tile. */
+	inline void SetIntermediateDestination(const WaterRegionPatchDesc &patch)
+	{
+		m_intermediate = patch;
+	}
+
+	/** Whether the search ends at a water region patch instead of the destination. */
+	inline bool HasIntermediateDestination() const
+	{
+		return m_intermediate.IsValid();
+	}
+
+	/** Called by YAPF to detect if node ends in the desired destination */
+	inline bool PfDetectDestination(Node &n)
+	{
+		if (!m_intermediate.IsValid()) return base::PfDetectDestination(n);
+		return GetWaterRegionPatchInfo(n.GetTile()) == m_intermediate;
+	}
+
+	/**
+	 * Called by YAPF to calculate cost estimate. Calculates distance to the destination
+	 *  adds it to the actual cost from origin and stores the sum to the Node::m_estimate
+	 */
+	inline bool PfCalcEstimate(Node &n)
+	{
+		if (!m_intermediate.IsValid()) return base::PfCalcEstimate(n);
+
+		static const int dg_dir_to_x_offs[] = {-1, 0, 1, 0};
+		static const int dg_dir_to_y_offs[] = {0, 1, 0, -1};
+		if (PfDetectDestination(n)) {
+			n.m_estimate = n.m_cost;
+			return true;
+		}
+
+		/* Distance to the edge of the region, in half tiles. */
+		TileIndex tile = n.GetTile();
+		DiagDirection exitdir = TrackdirToExitdir(n.GetTrackdir());
+		int x1 = 2 * TileX(tile) + dg_dir_to_x_offs[(int)exitdir];
+		int y1 = 2 * TileY(tile) + dg_dir_to_y_offs[(int)exitdir];
+		int left = 2 * m_intermediate.x * WATER_REGION_EDGE_LENGTH - 1;
+		int top = 2 * m_intermediate.y * WATER_REGION_EDGE_LENGTH - 1;
+		int right = left + 2 * WATER_REGION_EDGE_LENGTH;
+		int bottom = top + 2 * WATER_REGION_EDGE_LENGTH;
+		int dx = max(0, max(left - x1, x1 - right));
+		int dy = max(0, max(top - y1, y1 - bottom));
+		int dmin = min(dx, dy);
+		int dxy = abs(dx - dy);
+		n.m_estimate = n.m_cost + dmin * YAPF_TILE_CORNER_LENGTH + dxy * (YAPF_TILE_LENGTH / 2);
+		return true;
+	}
+};
+
 /** Node Follower module of YAPF for ships */
 template <class Types>
 class CYapfFollowShipT
@@ -28,6 +101,8 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
+	const WaterRegionCorridor *m_corridor; ///< Water region patches the search is limited to, or NULL.
+
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
 	{
@@ -35,6 +110,17 @@ protected:
 	}
 
 public:
+	CYapfFollowShipT() : m_corridor(NULL) {}
+
+	/**
+	 * Limit the search to some water region patches.
+	 * @param corridor The patches, or NULL to search everywhere.
+	 */
+	inline void SetCorridor(const WaterRegionCorridor *corridor)
+	{
+		m_corridor = corridor;
+	}
+
 	/**
 	 * Called by YAPF to move from the given node to the next tile. For each
 	 *  reachable trackdir on the new tile creates new node, initializes it
@@ -44,6 +130,10 @@ public:
 	{
 		TrackFollower F(Yapf().GetVehicle());
 		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td)) {
+			if (m_corridor != NULL) {
+				WaterRegionPatchDesc patch = GetWaterRegionPatchInfo(F.m_new_tile);
+				if (patch.IsValid() && !m_corridor->Contains(patch)) return;
+			}
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
@@ -54,41 +144,30 @@ public:
 		return 'w';
 	}
 
-	static Trackdir ChooseShipTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
+	/**
+	 * Search a path and fill the path cache.
+	 * @param v          The ship.
+	 * @param src_tile   Tile the ship comes from.
+	 * @param trackdirs  Trackdir of the ship on \a src_tile.
+	 * @param tile       Tile the ship enters.
+	 * @param path_found [out] Whether the destination was reached.
+	 * @param path_cache [out] The following trackdirs of the path.
+	 * @return The trackdir to take on \a tile, or INVALID_TRACKDIR.
+	 */
+	inline Trackdir FindShipPath(const Ship *v, TileIndex src_tile, TrackdirBits trackdirs, TileIndex tile, bool &path_found, ShipPathCache &path_cache)
 	{
-		/* handle special case - when next tile is destination tile */
-		if (tile == v->dest_tile) {
-			/* convert tracks to trackdirs */
-			TrackdirBits trackdirs = TrackBitsToTrackdirBits(tracks);
-			/* limit to trackdirs reachable from enterdir */
-			trackdirs &= DiagdirReachesTrackdirs(enterdir);
-
-			/* use vehicle's current direction if that's possible, otherwise use first usable one. */
-			Trackdir veh_dir = v->GetVehicleTrackdir();
-			return (HasTrackdir(trackdirs, veh_dir)) ? veh_dir : (Trackdir)FindFirstBit2x64(trackdirs);
-		}
-
-		/* move back to the old tile/trackdir (where ship is coming from) */
-		TileIndex src_tile = TileAddByDiagDir(tile, ReverseDiagDir(enterdir));
-		Trackdir trackdir = v->GetVehicleTrackdir();
-		assert(IsValidTrackdir(trackdir));
-
-		/* convert origin trackdir to TrackdirBits */
-		TrackdirBits trackdirs = TrackdirToTrackdirBits(trackdir);
 		/* get available trackdirs on the destination tile */
 		TrackdirBits dest_trackdirs = TrackStatusToTrackdirBits(GetTileTrackStatus(v->dest_tile, TRANSPORT_WATER, 0));
 
-		/* create pathfinder instance */
-		Tpf pf;
 		/* set origin and destination nodes */
-		pf.SetOrigin(src_tile, trackdirs);
-		pf.SetDestination(v->dest_tile, dest_trackdirs);
+		Yapf().SetOrigin(src_tile, trackdirs);
+		Yapf().SetDestination(v->dest_tile, dest_trackdirs);
 		/* find best path */
-		path_found = pf.FindPath(v);
+		path_found = Yapf().FindPath(v);
 
 		Trackdir next_trackdir = INVALID_TRACKDIR; // this would mean "path not found"
 
-		Node *pNode = pf.GetBestNode();
+		Node *pNode = Yapf().GetBestNode();
 		if (pNode != NULL) {
 			uint steps = 0;
 			for (Node *n = pNode; n->m_parent != NULL; n = n->m_parent) steps++;
@@ -109,11 +188,51 @@ public:
 			assert(best_next_node.GetTile() == tile);
 			next_trackdir = best_next_node.GetTrackdir();
 			/* remove last element for the special case when tile == dest_tile */
-			if (path_found && !path_cache.empty()) path_cache.pop_back();
+			if (path_found && !path_cache.empty() && !Yapf().HasIntermediateDestination()) path_cache.pop_back();
 		}
 		return next_trackdir;
 	}
 
+	static Trackdir ChooseShipTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
+	{
+		/* handle special case - when next tile is destination tile */
+		if (tile == v->dest_tile) {
+			/* convert tracks to trackdirs */
+			TrackdirBits trackdirs = TrackBitsToTrackdirBits(tracks);
+			/* limit to trackdirs reachable from enterdir */
+			trackdirs &= DiagdirReachesTrackdirs(enterdir);
+
+			/* use vehicle's current direction if that's possible, otherwise use first usable one. */
+			Trackdir veh_dir = v->GetVehicleTrackdir();
+			return (HasTrackdir(trackdirs, veh_dir)) ? veh_dir : (Trackdir)FindFirstBit2x64(trackdirs);
+		}
+
+		/* move back to the old tile/trackdir (where ship is coming from) */
+		TileIndex src_tile = TileAddByDiagDir(tile, ReverseDiagDir(enterdir));
+		Trackdir trackdir = v->GetVehicleTrackdir();
+		assert(IsValidTrackdir(trackdir));
+
+		/* convert origin trackdir to TrackdirBits */
+		TrackdirBits trackdirs = TrackdirToTrackdirBits(trackdir);
+
+		/* First search only the water region patches on the way to the
+		 * destination, up to a few regions ahead. Without such a route or
+		 * when the limited search fails, search the whole map. */
+		WaterRegionCorridor corridor;
+		bool intermediate;
+		if (FindWaterRegionCorridor(src_tile, v->dest_tile, YAPF_SHIP_REGION_LOOKAHEAD, &corridor, &intermediate)) {
+			Tpf pf;
+			pf.SetCorridor(&corridor);
+			if (intermediate) pf.SetIntermediateDestination(corridor[corridor.Length() - 1]);
+			Trackdir next_trackdir = pf.FindShipPath(v, src_tile, trackdirs, tile, path_found, path_cache);
+			if (path_found) return next_trackdir;
+			path_cache.clear();
+		}
+
+		Tpf pf;
+		return pf.FindShipPath(v, src_tile, trackdirs, tile, path_found, path_cache);
+	}
+
 	/**
 	 * Check whether a ship should reverse to reach its destination.
 	 * Called when leaving depot.
@@ -219,7 +338,7 @@ struct CYapfShip_TypesT
 	typedef CYapfBaseT<Types>                 PfBase;        // base pathfinder class
 	typedef CYapfFollowShipT<Types>           PfFollow;      // node follower
 	typedef CYapfOriginTileT<Types>           PfOrigin;      // origin provider
-	typedef CYapfDestinationTileT<Types>      PfDestination; // destination/distance provider
+	typedef CYapfDestinationShipT<Types>      PfDestination; // destination/distance provider
 	typedef CYapfSegmentCostCacheNoneT<Types> PfCache;       // segment cost cache provider
 	typedef CYapfCostShipT<Types>             PfCost;        // cost provider
 };
@@ -135,6 +135,38 @@ bool TryReserveRailTrack(TileIndex tile, Track t, bool trigger_stations)
 	return false;
 }
 
+/**
+ * Check whether #TryReserveRailTrack would succeed, without reserving anything.
+ * @param tile the tile
+ * @param t the track
+ * @return \c true if the track is free and doesn't cross any other reserved tracks.
+ */
+bool CanReserveRailTrack(TileIndex tile, Track t)
+{
+	assert(HasTrack(TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)), t));
+
+	switch (GetTileType(tile)) {
+		case MP_RAILWAY:
+			if (IsPlainRail(tile)) {
+				TrackBits res = GetRailReservationTrackBits(tile);
+				return (res & TrackToTrackBits(t)) == TRACK_BIT_NONE && !TracksOverlap(res | TrackToTrackBits(t));
+			}
+			return IsRailDepot(tile) && !HasDepotReservation(tile);
+
+		case MP_ROAD:
+			return IsLevelCrossing(tile) && !HasCrossingReservation(tile);
+
+		case MP_STATION:
+			return HasStationRail(tile) && !HasStationReservation(tile);
+
+		case MP_TUNNELBRIDGE:
+			return GetTunnelBridgeTransportType(tile) == TRANSPORT_RAIL && !GetTunnelBridgeReservationTrackBits(tile);
+
+		default:
+			return false;
+	}
+}
+
 /**
  * Lift the reservation of a specific track on a tile
  * @param tile the tile
@@ -301,7 +333,7 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res)
 	ftoti.res = FollowReservation(v->owner, GetRailTypeInfo(v->railtype)->compatible_railtypes, tile, trackdir);
 	ftoti.res.okay = IsSafeWaitingPosition(v, ftoti.res.tile, ftoti.res.trackdir, true, _settings_game.pf.forbid_90_deg);
 	if (train_on_res != NULL) {
-		FindVehicleOnPos(ftoti.res.tile, &ftoti, FindTrainOnTrackEnum);
+		FindTrainOnPos(ftoti.res.tile, &ftoti, FindTrainOnTrackEnum);
 		if (ftoti.best != NULL) *train_on_res = ftoti.best->First();
 		if (*train_on_res == NULL && IsRailStationTile(ftoti.res.tile)) {
 			/* The target tile is a rail station. The track follower
@@ -310,13 +342,13 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res)
 			 * for a possible train. */
 			TileIndexDiff diff = TileOffsByDiagDir(TrackdirToExitdir(ReverseTrackdir(ftoti.res.trackdir)));
 			for (TileIndex st_tile = ftoti.res.tile + diff; *train_on_res == NULL && IsCompatibleTrainStationTile(st_tile, ftoti.res.tile); st_tile += diff) {
-				FindVehicleOnPos(st_tile, &ftoti, FindTrainOnTrackEnum);
+				FindTrainOnPos(st_tile, &ftoti, FindTrainOnTrackEnum);
 				if (ftoti.best != NULL) *train_on_res = ftoti.best->First();
 			}
 		}
 		if (*train_on_res == NULL && IsTileType(ftoti.res.tile, MP_TUNNELBRIDGE)) {
 			/* The target tile is a bridge/tunnel, also check the other end tile. */
-			FindVehicleOnPos(GetOtherTunnelBridgeEnd(ftoti.res.tile), &ftoti, FindTrainOnTrackEnum);
+			FindTrainOnPos(GetOtherTunnelBridgeEnd(ftoti.res.tile), &ftoti, FindTrainOnTrackEnum);
 			if (ftoti.best != NULL) *train_on_res = ftoti.best->First();
 		}
 	}
@@ -348,21 +380,21 @@ Train *GetTrainForReservation(TileIndex tile, Track track)
 		FindTrainOnTrackInfo ftoti;
 		ftoti.res = FollowReservation(GetTileOwner(tile), rts, tile, trackdir, true);
 
-		FindVehicleOnPos(ftoti.res.tile, &ftoti, FindTrainOnTrackEnum);
+		FindTrainOnPos(ftoti.res.tile, &ftoti, FindTrainOnTrackEnum);
 		if (ftoti.best != NULL) return ftoti.best;
 
 		/* Special case for stations: check the whole platform for a vehicle. */
 		if (IsRailStationTile(ftoti.res.tile)) {
 			TileIndexDiff diff = TileOffsByDiagDir(TrackdirToExitdir(ReverseTrackdir(ftoti.res.trackdir)));
 			for (TileIndex st_tile = ftoti.res.tile + diff; IsCompatibleTrainStationTile(st_tile, ftoti.res.tile); st_tile += diff) {
-				FindVehicleOnPos(st_tile, &ftoti, FindTrainOnTrackEnum);
+				FindTrainOnPos(st_tile, &ftoti, FindTrainOnTrackEnum);
 				if (ftoti.best != NULL) return ftoti.best;
 			}
 		}
 
 		/* Special case for bridges/tunnels: check the other end as well. */
 		if (IsTileType(ftoti.res.tile, MP_TUNNELBRIDGE)) {
-			FindVehicleOnPos(GetOtherTunnelBridgeEnd(ftoti.res.tile), &ftoti, FindTrainOnTrackEnum);
+			FindTrainOnPos(GetOtherTunnelBridgeEnd(ftoti.res.tile), &ftoti, FindTrainOnTrackEnum);
 			if (ftoti.best != NULL) return ftoti.best;
 		}
 	}
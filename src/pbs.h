@@ -22,6 +22,7 @@ TrackBits GetReservedTrackbits(TileIndex t);
 void SetRailStationPlatformReservation(TileIndex start, DiagDirection dir, bool b);
 
 bool TryReserveRailTrack(TileIndex tile, Track t, bool trigger_stations = true);
+bool CanReserveRailTrack(TileIndex tile, Track t);
 void UnreserveRailTrack(TileIndex tile, Track t);
 
 /** This struct contains information about the end of a reserved path. */
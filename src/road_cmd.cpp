@@ -1531,6 +1531,7 @@ static void TileLoop_Road(TileIndex tile)
 					IsNormalRoad(tile) && !HasAtMostOneBit(GetAllRoadBits(tile))) {
 				if (GetFoundationSlope(tile) == SLOPE_FLAT && EnsureNoVehicleOnGround(tile).Succeeded() && Chance16(1, 40)) {
 					StartRoadWorks(tile);
+					YapfNotifyRoadLayoutChange();
 
 					if (_settings_client.sound.ambient) SndPlayTileFx(SND_21_JACKHAMMER, tile);
 					CreateEffectVehicleAbove(
@@ -1567,6 +1568,7 @@ static void TileLoop_Road(TileIndex tile)
 		}
 	} else if (IncreaseRoadWorksCounter(tile)) {
 		TerminateRoadWorks(tile);
+		YapfNotifyRoadLayoutChange();
 
 		if (_settings_game.economy.mod_road_rebuild) {
 			/* Generate a nicer town surface */
@@ -1874,4 +1876,5 @@ extern const TileTypeProcs _tile_type_road_procs = {
 	VehicleEnter_Road,       // vehicle_enter_tile_proc
 	GetFoundation_Road,      // get_foundation_proc
 	TerraformTile_Road,      // terraform_tile_proc
+	NULL,                    // tile_loop_batch_proc
 };
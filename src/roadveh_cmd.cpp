@@ -337,6 +337,7 @@ static FindDepotData FindClosestRoadDepot(const RoadVehicle *v, int max_distance
 {
 	if (IsRoadDepotTile(v->tile)) return FindDepotData(v->tile, 0);
 
+	PerformanceAccumulator framerate(PFE_GL_PF_ROADVEHS);
 	switch (_settings_game.pf.pathfinder_for_roadvehs) {
 		case VPF_NPF: return NPFRoadVehicleFindNearestDepot(v, max_distance);
 		case VPF_YAPF: return YapfRoadVehicleFindNearestDepot(v, max_distance);
@@ -924,6 +925,8 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 	/* Remove tracks unreachable from the enter dir */
 	trackdirs &= DiagdirReachesTrackdirs(enterdir);
 	if (trackdirs == TRACKDIR_BIT_NONE) {
+		/* If vehicle expected a path, it no longer exists, so invalidate it. */
+		if (!v->path.empty()) v->path.clear();
 		/* No reachable tracks, so we'll reverse */
 		return_track(_road_reverse_table[enterdir]);
 	}
@@ -941,6 +944,7 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 		if (reverse) {
 			v->reverse_ctr = 0;
 			if (v->tile != tile) {
+				v->path.clear();
 				return_track(_road_reverse_table[enterdir]);
 			}
 		}
@@ -954,14 +958,39 @@ static Trackdir RoadFindPathToDest(RoadVehicle *v, TileIndex tile, DiagDirection
 
 	/* Only one track to choose between? */
 	if (KillFirstBit(trackdirs) == TRACKDIR_BIT_NONE) {
+		if (!v->path.empty() && v->path.tile.front() == tile) {
+			/* Vehicle expected a choice here, invalidate its path. */
+			v->path.clear();
+		}
 		return_track(FindFirstBit2x64(trackdirs));
 	}
 
-	switch (_settings_game.pf.pathfinder_for_roadvehs) {
-		case VPF_NPF:  best_track = NPFRoadVehicleChooseTrack(v, tile, enterdir, path_found); break;
-		case VPF_YAPF: best_track = YapfRoadVehicleChooseTrack(v, tile, enterdir, trackdirs, path_found); break;
+	/* Attempt to follow cached path. */
+	if (!v->path.empty()) {
+		if (v->path.tile.front() != tile) {
+			/* Vehicle didn't expect a choice here, invalidate its path. */
+			v->path.clear();
+		} else {
+			Trackdir trackdir = v->path.td.front();
+			v->path.td.pop_front();
+			v->path.tile.pop_front();
 
-		default: NOT_REACHED();
+			/* HandlePathfindResult() is not called here because this is not a new pathfinder result. */
+			if (HasTrackdir(trackdirs, trackdir)) return_track(trackdir);
+
+			/* Vehicle expected a choice which is no longer available. */
+			v->path.clear();
+		}
+	}
+
+	{
+		PerformanceAccumulator framerate(PFE_GL_PF_ROADVEHS);
+		switch (_settings_game.pf.pathfinder_for_roadvehs) {
+			case VPF_NPF:  best_track = NPFRoadVehicleChooseTrack(v, tile, enterdir, path_found); break;
+			case VPF_YAPF: best_track = YapfRoadVehicleChooseTrack(v, tile, enterdir, trackdirs, path_found, v->path); break;
+
+			default: NOT_REACHED();
+		}
 	}
 	v->HandlePathfindingResult(path_found);
 
@@ -1586,6 +1615,13 @@ Money RoadVehicle::GetRunningCost() const
 	return GetPrice(e->u.road.running_cost_class, cost_factor, e->GetGRF());
 }
 
+void RoadVehicle::SetDestTile(TileIndex tile)
+{
+	if (tile == this->dest_tile) return;
+	this->path.clear();
+	this->dest_tile = tile;
+}
+
 bool RoadVehicle::Tick()
 {
 	PerformanceAccumulator framerate(PFE_GL_ROADVEHS);
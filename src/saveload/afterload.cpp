@@ -285,6 +285,8 @@ static void InitializeWindowsAndCaches()
 
 	GroupStatistics::UpdateAfterLoad();
 
+	RebuildStationAreaIndex();
+	RebuildIndustryAreaIndex();
 	Station::RecomputeIndustriesNearForAll();
 	RebuildSubsidisedSourceAndDestinationCache();
 
@@ -539,6 +541,9 @@ bool AfterLoadGame()
 
 	if (IsSavegameVersionBefore(SLV_98)) GamelogGRFAddList(_grfconfig);
 
+	/* The k-d tree of towns is not saved, rebuild it before looking for nearby towns. */
+	RebuildTownKdtree();
+
 	if (IsSavegameVersionBefore(SLV_119)) {
 		_pause_mode = (_pause_mode == 2) ? PM_PAUSED_NORMAL : PM_UNPAUSED;
 	} else if (_network_dedicated && (_pause_mode & PM_PAUSED_ERROR) != 0) {
@@ -587,14 +592,14 @@ bool AfterLoadGame()
 
 		/* In old savegame versions, the heightlevel was coded in bits 0..3 of the type field */
 		for (TileIndex t = 0; t < map_size; t++) {
-			_m[t].height = GB(_m[t].type, 0, 4);
-			SB(_m[t].type, 0, 2, GB(_me[t].m6, 0, 2));
+			_m_height[t] = GB(_m_type[t], 0, 4);
+			SB(_m_type[t], 0, 2, GB(_me[t].m6, 0, 2));
 			SB(_me[t].m6, 0, 2, 0);
 			if (MayHaveBridgeAbove(t)) {
-				SB(_m[t].type, 2, 2, GB(_me[t].m6, 6, 2));
+				SB(_m_type[t], 2, 2, GB(_me[t].m6, 6, 2));
 				SB(_me[t].m6, 6, 2, 0);
 			} else {
-				SB(_m[t].type, 2, 2, 0);
+				SB(_m_type[t], 2, 2, 0);
 			}
 		}
 	}
@@ -1359,6 +1364,8 @@ bool AfterLoadGame()
 	}
 
 	YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+	YapfNotifyRoadLayoutChange();
+	ClearSignalBlockCache();
 
 	if (IsSavegameVersionBefore(SLV_34)) {
 		Company *c;
@@ -1478,6 +1485,8 @@ bool AfterLoadGame()
 
 	/* Check and update house and town values */
 	UpdateHousesAndTowns();
+	/* Forget the animation speeds of the tiles; they come from the NewGRFs. */
+	RebuildAnimatedTileIndex();
 
 	if (IsSavegameVersionBefore(SLV_43)) {
 		for (TileIndex t = 0; t < map_size; t++) {
@@ -2186,24 +2195,14 @@ bool AfterLoadGame()
 
 	if (IsSavegameVersionBefore(SLV_122)) {
 		/* Animated tiles would sometimes not be actually animated or
-		 * in case of old savegames duplicate. */
+		 * in case of old savegames duplicate. Duplicates are already
+		 * removed when loading the animated tiles. */
 
 		extern SmallVector<TileIndex, 256> _animated_tiles;
 
-		for (TileIndex *tile = _animated_tiles.Begin(); tile < _animated_tiles.End(); /* Nothing */) {
+		for (TileIndex *tile = _animated_tiles.Begin(); tile < _animated_tiles.End(); tile++) {
 			/* Remove if tile is not animated */
-			bool remove = _tile_type_procs[GetTileType(*tile)]->animate_tile_proc == NULL;
-
-			/* and remove if duplicate */
-			for (TileIndex *j = _animated_tiles.Begin(); !remove && j < tile; j++) {
-				remove = *tile == *j;
-			}
-
-			if (remove) {
-				DeleteAnimatedTile(*tile);
-			} else {
-				tile++;
-			}
+			if (_tile_type_procs[GetTileType(*tile)]->animate_tile_proc == NULL) DeleteAnimatedTile(*tile);
 		}
 	}
 
@@ -3112,6 +3111,8 @@ bool AfterLoadGame()
  */
 void ReloadNewGRFData()
 {
+	CancelTrainPathLookahead();
+
 	/* reload grf data */
 	GfxLoadSprites();
 	LoadStringWidthTable();
@@ -3123,6 +3124,10 @@ void ReloadNewGRFData()
 	GroupStatistics::UpdateAfterLoad();
 	/* update station graphics */
 	AfterLoadStations();
+	/* The animation speeds may have changed with the NewGRFs. */
+	RebuildAnimatedTileIndex();
+	/* Station tiles blocking signal blocks depend on the NewGRF station specs. */
+	ClearSignalBlockCache();
 	/* Update company statistics. */
 	AfterLoadCompanyStats();
 	/* Check and update house and town values */
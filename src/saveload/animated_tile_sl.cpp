@@ -13,6 +13,7 @@
 #include "../tile_type.h"
 #include "../core/alloc_func.hpp"
 #include "../core/smallvec_type.hpp"
+#include "../animated_tile_func.h"
 
 #include "saveload.h"
 
@@ -25,6 +26,7 @@ extern SmallVector<TileIndex, 256> _animated_tiles;
  */
 static void Save_ANIT()
 {
+	CompactAnimatedTiles();
 	SlSetLength(_animated_tiles.Length() * sizeof(*_animated_tiles.Begin()));
 	SlArray(_animated_tiles.Begin(), _animated_tiles.Length(), SLE_UINT32);
 }
@@ -44,6 +46,7 @@ static void Load_ANIT()
 			if (anim_list[i] == 0) break;
 			*_animated_tiles.Append() = anim_list[i];
 		}
+		RebuildAnimatedTileIndex();
 		return;
 	}
 
@@ -51,6 +54,7 @@ static void Load_ANIT()
 	_animated_tiles.Clear();
 	_animated_tiles.Append(count);
 	SlArray(_animated_tiles.Begin(), count, SLE_UINT32);
+	RebuildAnimatedTileIndex();
 }
 
 /**
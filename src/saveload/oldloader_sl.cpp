@@ -23,6 +23,7 @@
 #include "../debug.h"
 #include "../depot_base.h"
 #include "../date_func.h"
+#include "../animated_tile_func.h"
 #include "../vehicle_func.h"
 #include "../effectvehicle_base.h"
 #include "../engine_func.h"
@@ -49,6 +50,8 @@ void FixOldMapArray()
 	/* TTO/TTD/TTDP savegames could have buoys at tile 0
 	 * (without assigned station struct) */
 	MemSetT(&_m[0], 0);
+	_m_type[0] = 0;
+	_m_height[0] = 0;
 	SetTileType(0, MP_WATER);
 	SetTileOwner(0, OWNER_WATER);
 }
@@ -653,6 +656,7 @@ static bool LoadOldAnimTileList(LoadgameState *ls, int num)
 		if (anim_list[i] == 0) break;
 		*_animated_tiles.Append() = anim_list[i];
 	}
+	RebuildAnimatedTileIndex();
 
 	return true;
 }
@@ -1475,6 +1479,8 @@ static bool LoadOldMapPart1(LoadgameState *ls, int num)
 	if (_savegame_type == SGT_TTO) {
 		MemSetT(_m, 0, OLD_MAP_SIZE);
 		MemSetT(_me, 0, OLD_MAP_SIZE);
+		MemSetT(_m_type, 0, OLD_MAP_SIZE);
+		MemSetT(_m_height, 0, OLD_MAP_SIZE);
 	}
 
 	for (uint i = 0; i < OLD_MAP_SIZE; i++) {
@@ -1506,7 +1512,7 @@ static bool LoadOldMapPart2(LoadgameState *ls, int num)
 	uint i;
 
 	for (i = 0; i < OLD_MAP_SIZE; i++) {
-		_m[i].type = ReadByte(ls);
+		_m_type[i] = ReadByte(ls);
 	}
 	for (i = 0; i < OLD_MAP_SIZE; i++) {
 		_m[i].m5 = ReadByte(ls);
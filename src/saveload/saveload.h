@@ -291,6 +291,12 @@ enum SaveLoadVersion : uint16 {
 	SLV_GROUP_LIVERIES,                     ///< 205  PR#7108 Livery storage change and group liveries.
 	SLV_SHIPS_STOP_IN_LOCKS,                ///< 206  PR#7150 Ship/lock movement changes.
 	SLV_FIX_CARGO_MONITOR,                  ///< 207  PR#7175 Cargo monitor data packing fix to support 64 cargotypes.
+	SLV_TILE_LOOP_BATCHING,                 ///< 208  Tile loop grouped by tile type.
+	SLV_ROADVEH_PATH_CACHE,                 ///< 209  Add path cache for road vehicles.
+	SLV_RAIL_PATH_LOOKAHEAD,                ///< 210  Search paths of stuck trains ahead of time.
+	SLV_ROADVEH_DESTINATION_FIELDS,         ///< 211  Shared cost fields of road vehicle destinations.
+	SLV_PARALLEL_VEHICLE_TICKS,             ///< 212  Parallel vehicle ticks became a game setting.
+	SLV_FAST_MCF_SOLVER,                    ///< 213  Choice of the MCF solver backend became a game setting.
 
 	SL_MAX_VERSION,                         ///< Highest possible saveload version
 };
@@ -39,6 +39,17 @@ struct LoadFilter {
 	 */
 	virtual size_t Read(byte *buf, size_t len) = 0;
 
+	/**
+	 * Get direct access to the rest of the savegame instead of copying it with #Read.
+	 * Afterwards the filter is at the end of its data.
+	 * @param[out] len The number of bytes available at the returned pointer.
+	 * @return The data, or NULL if this filter cannot give direct access.
+	 */
+	virtual const byte *ReadDirect(size_t *len)
+	{
+		return NULL;
+	}
+
 	/**
 	 * Reset this filter to read from the beginning of the file.
 	 */
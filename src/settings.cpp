@@ -32,8 +32,10 @@
 #include "command_func.h"
 #include "console_func.h"
 #include "pathfinder/pathfinder_type.h"
+#include "pathfinder/yapf/yapf_cache.h"
 #include "genworld.h"
 #include "train.h"
+#include "vehicle_func.h"
 #include "news_func.h"
 #include "window_func.h"
 #include "sound_func.h"
@@ -1322,6 +1324,29 @@ static bool InvalidateShipPathCache(int32 p1)
 	return true;
 }
 
+static bool InvalidateRoadVehPathCache(int32 p1)
+{
+	RoadVehicle *rv;
+	FOR_ALL_ROADVEHICLES(rv) {
+		rv->path.clear();
+	}
+	return true;
+}
+
+static bool InvalidateRoadDestinationFields(int32 p1)
+{
+	YapfNotifyRoadLayoutChange();
+	return true;
+}
+
+static bool ChangeTrainTileCounts(int32 p1)
+{
+	/* The path searches running in the background look for trains too. */
+	CancelTrainPathLookahead();
+	RebuildTrainTileCounts();
+	return true;
+}
+
 
 #ifdef ENABLE_NETWORK
 
@@ -112,6 +112,9 @@ struct GUISettings {
 	bool   disable_unsuitable_building;      ///< disable infrastructure building when no suitable vehicles are available
 	byte   autosave;                         ///< how often should we do autosaves?
 	bool   threaded_saves;                   ///< should we do threaded saves?
+	bool   parallel_sprite_sorting;          ///< should the sprites of large viewport redraws be sorted on worker threads?
+	bool   count_trains_per_tile;            ///< should the number of trains on each tile be counted, so looking for trains on empty tiles is quick?
+	uint8  linkgraph_threads;                ///< number of threads running link graph jobs (0 = one less than the number of cores)
 	bool   keep_all_autosave;                ///< name the autosave in a different way
 	bool   autosave_on_exit;                 ///< save an autosave when you quit the game, but do not ask "Do you really want to quit?"
 	bool   autosave_on_network_disconnect;   ///< save an autosave when you get disconnected from a network game with an error?
@@ -394,6 +397,7 @@ struct YAPFSettings {
 	uint32 road_stop_penalty;                ///< penalty for going through a drive-through road stop
 	uint32 road_stop_occupied_penalty;       ///< penalty multiplied by the fill percentage of a drive-through road stop
 	uint32 road_stop_bay_occupied_penalty;   ///< penalty multiplied by the fill percentage of a road bay
+	bool   road_destination_fields;          ///< let road vehicles going to the same destination share one search towards it
 	bool   rail_firstred_twoway_eol;         ///< treat first red two-way signal as dead end
 	uint32 rail_firstred_penalty;            ///< penalty for first red signal
 	uint32 rail_firstred_exit_penalty;       ///< penalty for first red exit signal
@@ -418,6 +422,8 @@ struct YAPFSettings {
 	uint32 rail_longer_platform_per_tile_penalty;  ///< penalty for longer  station platform than train (per tile)
 	uint32 rail_shorter_platform_penalty;          ///< penalty for shorter station platform than train
 	uint32 rail_shorter_platform_per_tile_penalty; ///< penalty for shorter station platform than train (per tile)
+
+	bool   rail_path_lookahead;                    ///< search the paths of stuck trains in the background before they try to reserve again
 };
 
 /** Settings related to all pathfinders. */
@@ -473,6 +479,7 @@ struct VehicleSettings {
 	byte   extend_vehicle_life;              ///< extend vehicle life by this many years
 	byte   road_side;                        ///< the side of the road vehicles drive on
 	uint8  plane_crashes;                    ///< number of plane crashes, 0 = none, 1 = reduced, 2 = normal
+	bool   parallel_vehicle_ticks;           ///< should the independent parts of the vehicle ticks run on worker threads?
 };
 
 /** Settings related to the economy. */
@@ -499,6 +506,7 @@ struct EconomySettings {
 	uint16 town_noise_population[3];         ///< population to base decision on noise evaluation (@see town_council_tolerance)
 	bool   allow_town_level_crossings;       ///< towns are allowed to build level crossings
 	bool   infrastructure_maintenance;       ///< enable monthly maintenance fee for owner infrastructure
+	bool   tile_loop_batching;               ///< run the tile loop of each tick grouped by tile type
 };
 
 struct LinkGraphSettings {
@@ -512,6 +520,7 @@ struct LinkGraphSettings {
 	uint8 demand_size;                          ///< influence of supply ("station size") on the demand function
 	uint8 demand_distance;                      ///< influence of distance between stations on the demand function
 	uint8 short_path_saturation;                ///< percentage up to which short paths are saturated before saturating most capacious paths
+	bool fast_mcf_solver;                       ///< use the heap based backend of the multi-commodity flow solver
 
 	inline DistributionType GetDistributionType(CargoID cargo) const {
 		if (IsCargoInClass(cargo, CC_PASSENGERS)) return this->distribution_pax;
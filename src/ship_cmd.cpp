@@ -370,6 +370,7 @@ static bool CheckShipLeaveDepot(Ship *v)
 		/* Ask pathfinder for best direction */
 		bool reverse = false;
 		bool path_found;
+		PerformanceAccumulator framerate(PFE_GL_PF_SHIPS);
 		switch (_settings_game.pf.pathfinder_for_ships) {
 			case VPF_OPF: reverse = OPFShipChooseTrack(v, north_neighbour, north_dir, north_tracks, path_found) == INVALID_TRACK; break; // OPF always allows reversing
 			case VPF_NPF: reverse = NPFShipCheckReverse(v); break;
@@ -498,6 +499,7 @@ static Track ChooseShipTrack(Ship *v, TileIndex tile, DiagDirection enterdir, Tr
 			v->path.clear();
 		}
 
+		PerformanceAccumulator framerate(PFE_GL_PF_SHIPS);
 		switch (_settings_game.pf.pathfinder_for_ships) {
 			case VPF_OPF: track = OPFShipChooseTrack(v, tile, enterdir, tracks, path_found); break;
 			case VPF_NPF: track = NPFShipChooseTrack(v, path_found); break;
@@ -17,6 +17,11 @@
 #include "viewport_func.h"
 #include "train.h"
 #include "company_base.h"
+#include "command_func.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
 
 #include "safeguards.h"
 
@@ -26,6 +31,7 @@ static const uint SIG_TBU_SIZE    =  64; ///< number of signals entering to bloc
 static const uint SIG_TBD_SIZE    = 256; ///< number of intersections - open nodes in current block
 static const uint SIG_GLOB_SIZE   = 128; ///< number of open blocks (block can be opened more times until detected)
 static const uint SIG_GLOB_UPDATE =  64; ///< how many items need to be in _globset to force update
+static const uint SIG_BLOCK_CACHE_SIZE = 4096; ///< number of explored signal blocks kept until the cache is flushed
 
 assert_compile(SIG_GLOB_UPDATE <= SIG_GLOB_SIZE);
 
@@ -189,6 +195,107 @@ static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset("_tbdset");    ///< set of
 static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of places to be updated in following runs
 
 
+/**
+ * Tile and direction found while exploring a signal block.
+ * @tparam Tdir Trackdir of a signal or DiagDirection of a tile side.
+ */
+template <typename Tdir>
+struct SignalBlockItem {
+	TileIndex tile; ///< The tile.
+	Tdir dir;       ///< The direction on the tile.
+
+	bool operator ==(const SignalBlockItem &other) const
+	{
+		return this->tile == other.tile && this->dir == other.dir;
+	}
+};
+
+/** Tile of a signal block that has to be checked for trains. */
+struct SignalBlockProbe {
+	TileIndex tile;   ///< The tile.
+	TrackBits tracks; ///< Tracks a train has to interact with, or #TRACK_BIT_NONE for any train that is not in a depot.
+
+	bool operator <(const SignalBlockProbe &other) const
+	{
+		return this->tile != other.tile ? this->tile < other.tile : this->tracks < other.tracks;
+	}
+
+	bool operator ==(const SignalBlockProbe &other) const
+	{
+		return this->tile == other.tile && this->tracks == other.tracks;
+	}
+};
+
+/**
+ * Everything #ExploreSegment learns about a signal block, except for the
+ * parts that change while trains are moving. It only depends on the track
+ * layout, so it can be kept until that changes. The trains in the block and
+ * the states of its pre-signal exits are looked up when the block is updated.
+ */
+struct SignalBlock {
+	std::vector<SignalBlockProbe> probes;                 ///< Tiles of the block that are checked for trains.
+	std::vector<SignalBlockItem<Trackdir> > signals;      ///< Signals around the block that are updated, in the order they were found.
+	std::vector<SignalBlockItem<Trackdir> > exits;        ///< Pre-signal exits leaving the block.
+	std::vector<SignalBlockItem<DiagDirection> > sides;   ///< Tile sides passed while exploring, in the order they were passed.
+	bool pbs;                                             ///< Is there a path signal around the block?
+	bool full;                                            ///< Was some buffer full while exploring the block?
+
+	SignalBlock() : pbs(false), full(false) { }
+
+	/** Forget everything about the block, but keep the allocated memory. */
+	void Clear()
+	{
+		this->probes.clear();
+		this->signals.clear();
+		this->exits.clear();
+		this->sides.clear();
+		this->pbs = false;
+		this->full = false;
+	}
+
+	/**
+	 * Add a tile that has to be checked for trains.
+	 * @param tile the tile
+	 * @param tracks tracks a train has to interact with, or #TRACK_BIT_NONE for any train
+	 */
+	void AddProbe(TileIndex tile, TrackBits tracks)
+	{
+		SignalBlockProbe probe = { tile, tracks };
+		this->probes.push_back(probe);
+	}
+
+	/** Remove the tiles that were found more than once, so they are only checked once. */
+	void Compact()
+	{
+		std::sort(this->probes.begin(), this->probes.end());
+		this->probes.erase(std::unique(this->probes.begin(), this->probes.end()), this->probes.end());
+	}
+
+	bool operator ==(const SignalBlock &other) const
+	{
+		return this->pbs == other.pbs && this->full == other.full && this->probes == other.probes &&
+				this->signals == other.signals && this->exits == other.exits && this->sides == other.sides;
+	}
+};
+
+typedef std::map<uint64, SignalBlock> SignalBlockCache; ///< Explored signal blocks by the #SignalBlockKey they were started from.
+
+static SignalBlockCache _signal_blocks; ///< Explored signal blocks, dropped when the track layout changes.
+static SignalBlock _signal_block;       ///< Signal block that is explored without being cached.
+
+/**
+ * Get the key of a signal block in the cache.
+ * @param tile tile the update of the block started at
+ * @param dir side of the tile the update started at
+ * @param owner owner whose signals are updated
+ * @return the key
+ */
+static inline uint64 SignalBlockKey(TileIndex tile, DiagDirection dir, Owner owner)
+{
+	return (uint64)tile << 16 | owner << 8 | dir;
+}
+
+
 /** Check whether there is a train on rail, not in a depot */
 static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
 {
@@ -200,21 +307,24 @@ static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
 
 /**
  * Perform some operations before adding data into Todo set
- * The new and reverse direction is removed from _globset, because we are sure
- * it doesn't need to be checked again
+ * The new and reverse direction is marked for removal from _globset, because
+ * we are sure it doesn't need to be checked again
  * Also, remove reverse direction from _tbdset
  * This is the 'core' part so the graph searching won't enter any tile twice
  *
+ * @param block signal block being explored
  * @param t1 tile we are entering
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
  * @return false iff reverse direction was in Todo set
  */
-static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline bool CheckAddToTodoSet(SignalBlock *block, TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
 {
-	_globset.Remove(t1, d1); // it can be in Global but not in Todo
-	_globset.Remove(t2, d2); // remove in all cases
+	SignalBlockItem<DiagDirection> side1 = { t1, d1 };
+	SignalBlockItem<DiagDirection> side2 = { t2, d2 };
+	block->sides.push_back(side1); // it can be in Global but not in Todo
+	block->sides.push_back(side2); // remove in all cases
 
 	assert(!_tbdset.IsIn(t1, d1)); // it really shouldn't be there already
 
@@ -226,20 +336,21 @@ static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
 
 /**
  * Perform some operations before adding data into Todo set
- * The new and reverse direction is removed from Global set, because we are sure
- * it doesn't need to be checked again
+ * The new and reverse direction is marked for removal from Global set, because
+ * we are sure it doesn't need to be checked again
  * Also, remove reverse direction from Todo set
  * This is the 'core' part so the graph searching won't enter any tile twice
  *
+ * @param block signal block being explored
  * @param t1 tile we are entering
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
  * @return false iff the Todo buffer would be overrun
  */
-static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline bool MaybeAddToTodoSet(SignalBlock *block, TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
 {
-	if (!CheckAddToTodoSet(t1, d1, t2, d2)) return true;
+	if (!CheckAddToTodoSet(block, t1, d1, t2, d2)) return true;
 
 	return _tbdset.Add(t1, d1);
 }
@@ -262,14 +373,14 @@ DECLARE_ENUM_AS_BIT_SET(SigFlags)
 
 /**
  * Search signal block
+ * Only the track layout is looked at; the trains and signal states are
+ * checked by #EvaluateSegment, so the result can be cached.
  *
  * @param owner owner whose signals we are updating
- * @return SigFlags
+ * @param block signal block to fill, block->full is set when some buffer was full
  */
-static SigFlags ExploreSegment(Owner owner)
+static void ExploreSegment(Owner owner, SignalBlock *block)
 {
-	SigFlags flags = SF_NONE;
-
 	TileIndex tile;
 	DiagDirection enterdir;
 
@@ -283,13 +394,13 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (IsRailDepot(tile)) {
 					if (enterdir == INVALID_DIAGDIR) { // from 'inside' - train just entered or left the depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						block->AddProbe(tile, TRACK_BIT_NONE);
 						exitdir = GetRailDepotDirection(tile);
 						tile += TileOffsByDiagDir(exitdir);
 						enterdir = ReverseDiagDir(exitdir);
 						break;
 					} else if (enterdir == GetRailDepotDirection(tile)) { // entered a depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						block->AddProbe(tile, TRACK_BIT_NONE);
 						continue;
 					} else {
 						continue;
@@ -302,11 +413,12 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) { // there is exactly one incidating track, no need to check
 					tracks = tracks_masked;
-					/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
-					if (!(flags & SF_TRAIN) && EnsureNoTrainOnTrackBits(tile, tracks).Failed()) flags |= SF_TRAIN;
+					/* only a train on this very track occupies the block */
+					assert(tracks != TRACK_BIT_NONE);
+					block->AddProbe(tile, tracks);
 				} else {
 					if (tracks_masked == TRACK_BIT_NONE) continue; // no incidating track
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					block->AddProbe(tile, TRACK_BIT_NONE);
 				}
 
 				if (HasSignals(tile)) { // there is exactly one track - not zero, because there is exit from this tile
@@ -320,21 +432,22 @@ static SigFlags ExploreSegment(Owner owner)
 						 * (if it is a presignal EXIT and it changes, it will be added to 'to-be-done' set later) */
 						if (HasSignalOnTrackdir(tile, reversedir)) {
 							if (IsPbsSignal(sig)) {
-								flags |= SF_PBS;
-							} else if (!_tbuset.Add(tile, reversedir)) {
-								return flags | SF_FULL;
+								block->pbs = true;
+							} else if (block->signals.size() == SIG_TBU_SIZE) {
+								DEBUG(misc, 0, "SignalSegment too complex. Set _tbuset is full (maximum %d)", SIG_TBU_SIZE);
+								block->full = true;
+								return;
+							} else {
+								SignalBlockItem<Trackdir> signal = { tile, reversedir };
+								block->signals.push_back(signal);
 							}
 						}
-						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) flags |= SF_PBS;
-
-						/* if it is a presignal EXIT in OUR direction and we haven't found 2 green exits yes, do special check */
-						if (!(flags & SF_GREEN2) && IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
-							if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
-							flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
-							if (GetSignalStateByTrackdir(tile, trackdir) == SIGNAL_STATE_GREEN) { // found green presignal exit
-								if (flags & SF_GREEN) flags |= SF_GREEN2;
-								flags |= SF_GREEN;
-							}
+						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) block->pbs = true;
+
+						/* if it is a presignal EXIT in OUR direction, its state is checked when evaluating the block */
+						if (IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
+							SignalBlockItem<Trackdir> exit = { tile, trackdir };
+							block->exits.push_back(exit);
 						}
 
 						continue;
@@ -345,7 +458,10 @@ static SigFlags ExploreSegment(Owner owner)
 					if (dir != enterdir && (tracks & _enterdir_to_trackbits[dir])) { // any track incidating?
 						TileIndex newtile = tile + TileOffsByDiagDir(dir);  // new tile to check
 						DiagDirection newdir = ReverseDiagDir(dir); // direction we are entering from
-						if (!MaybeAddToTodoSet(newtile, newdir, tile, dir)) return flags | SF_FULL;
+						if (!MaybeAddToTodoSet(block, newtile, newdir, tile, dir)) {
+							block->full = true;
+							return;
+						}
 					}
 				}
 
@@ -358,7 +474,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (DiagDirToAxis(enterdir) != GetRailStationAxis(tile)) continue; // different axis
 				if (IsStationTileBlocked(tile)) continue; // 'eye-candy' station tile
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				block->AddProbe(tile, TRACK_BIT_NONE);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -367,7 +483,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (GetTileOwner(tile) != owner) continue;
 				if (DiagDirToAxis(enterdir) == GetCrossingRoadAxis(tile)) continue; // different axis
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				block->AddProbe(tile, TRACK_BIT_NONE);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -377,13 +493,13 @@ static SigFlags ExploreSegment(Owner owner)
 				DiagDirection dir = GetTunnelBridgeDirection(tile);
 
 				if (enterdir == INVALID_DIAGDIR) { // incoming from the wormhole
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					block->AddProbe(tile, TRACK_BIT_NONE);
 					enterdir = dir;
 					exitdir = ReverseDiagDir(dir);
 					tile += TileOffsByDiagDir(exitdir); // just skip to next tile
 				} else { // NOT incoming from the wormhole!
 					if (ReverseDiagDir(enterdir) != dir) continue;
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, NULL, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					block->AddProbe(tile, TRACK_BIT_NONE);
 					tile = GetOtherTunnelBridgeEnd(tile); // just skip to exit tile
 					enterdir = INVALID_DIAGDIR;
 					exitdir = INVALID_DIAGDIR;
@@ -395,7 +511,56 @@ static SigFlags ExploreSegment(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		if (!MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir)) return flags | SF_FULL;
+		if (!MaybeAddToTodoSet(block, tile, enterdir, oldtile, exitdir)) {
+			block->full = true;
+			return;
+		}
+	}
+}
+
+
+/**
+ * Check the trains and pre-signal exits of an explored signal block,
+ * and put its signals into _tbuset
+ * The sides passed while exploring are removed from _globset, just like
+ * when exploring the block again.
+ *
+ * @param block explored signal block
+ * @return SigFlags
+ */
+static SigFlags EvaluateSegment(const SignalBlock *block)
+{
+	SigFlags flags = block->pbs ? SF_PBS : SF_NONE;
+
+	/* nothing else is used when some buffer was full */
+	if (block->full) return flags | SF_FULL;
+
+	for (std::vector<SignalBlockProbe>::const_iterator it = block->probes.begin(); it != block->probes.end(); ++it) {
+		if (it->tracks == TRACK_BIT_NONE ? HasTrainOnPos(it->tile, NULL, &TrainOnTileEnum) : EnsureNoTrainOnTrackBits(it->tile, it->tracks).Failed()) {
+			flags |= SF_TRAIN;
+			break;
+		}
+	}
+
+	/* stop looking at presignal exits when 2 green exits were found */
+	for (std::vector<SignalBlockItem<Trackdir> >::const_iterator it = block->exits.begin(); it != block->exits.end() && !(flags & SF_GREEN2); ++it) {
+		if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
+		flags |= SF_EXIT; // found at least one exit - allow for compiler optimizations
+		if (GetSignalStateByTrackdir(it->tile, it->dir) == SIGNAL_STATE_GREEN) { // found green presignal exit
+			if (flags & SF_GREEN) flags |= SF_GREEN2;
+			flags |= SF_GREEN;
+		}
+	}
+
+	/* the order matters, removing an item moves another one in _globset */
+	if (!_globset.IsEmpty()) {
+		for (std::vector<SignalBlockItem<DiagDirection> >::const_iterator it = block->sides.begin(); it != block->sides.end(); ++it) {
+			_globset.Remove(it->tile, it->dir);
+		}
+	}
+
+	for (std::vector<SignalBlockItem<Trackdir> >::const_iterator it = block->signals.begin(); it != block->signals.end(); ++it) {
+		_tbuset.Add(it->tile, it->dir);
 	}
 
 	return flags;
@@ -462,6 +627,108 @@ static inline void ResetSets()
 }
 
 
+/**
+ * Put the starting points of the signal block at a tile side into _tbdset
+ *
+ * @param tile tile where we start
+ * @param dir side of tile
+ * @return false iff there is no track at the side, so there is no block to update
+ */
+static bool StartSegment(TileIndex tile, DiagDirection dir)
+{
+	assert(_tbdset.IsEmpty());
+
+	/* After updating signal, data stored are always MP_RAILWAY with signals.
+	 * Other situations happen when data are from outside functions -
+	 * modification of railbits (including both rail building and removal),
+	 * train entering/leaving block, train leaving depot...
+	 */
+	switch (GetTileType(tile)) {
+		case MP_TUNNELBRIDGE:
+			/* 'optimization assert' - do not try to update signals when it is not needed */
+			assert(GetTunnelBridgeTransportType(tile) == TRANSPORT_RAIL);
+			assert(dir == INVALID_DIAGDIR || dir == ReverseDiagDir(GetTunnelBridgeDirection(tile)));
+			_tbdset.Add(tile, INVALID_DIAGDIR);  // we can safely start from wormhole centre
+			_tbdset.Add(GetOtherTunnelBridgeEnd(tile), INVALID_DIAGDIR);
+			break;
+
+		case MP_RAILWAY:
+			if (IsRailDepot(tile)) {
+				/* 'optimization assert' do not try to update signals in other cases */
+				assert(dir == INVALID_DIAGDIR || dir == GetRailDepotDirection(tile));
+				_tbdset.Add(tile, INVALID_DIAGDIR); // start from depot inside
+				break;
+			}
+			FALLTHROUGH;
+
+		case MP_STATION:
+		case MP_ROAD:
+			if ((TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)) & _enterdir_to_trackbits[dir]) != TRACK_BIT_NONE) {
+				/* only add to set when there is some 'interesting' track */
+				_tbdset.Add(tile, dir);
+				_tbdset.Add(tile + TileOffsByDiagDir(dir), ReverseDiagDir(dir));
+				break;
+			}
+			FALLTHROUGH;
+
+		default:
+			/* jump to next tile */
+			tile = tile + TileOffsByDiagDir(dir);
+			dir = ReverseDiagDir(dir);
+			if ((TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)) & _enterdir_to_trackbits[dir]) != TRACK_BIT_NONE) {
+				_tbdset.Add(tile, dir);
+				break;
+			}
+			/* happens when removing a rail that wasn't connected at one or both sides */
+			return false;
+	}
+
+	assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
+	assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
+
+	return true;
+}
+
+
+/**
+ * Find the signal block at a tile side
+ * Blocks are taken from the cache when possible. While a command is
+ * executed the track layout may change at any moment, so the cache is
+ * neither used nor filled then; it is flushed after commands that change
+ * the landscape.
+ *
+ * @param tile tile where we start
+ * @param dir side of tile
+ * @param owner owner whose signals we are updating
+ * @return the signal block, NULL iff there is no block at the side
+ */
+static const SignalBlock *FindSegment(TileIndex tile, DiagDirection dir, Owner owner)
+{
+	bool use_cache = !IsCommandRunning();
+	uint64 key = SignalBlockKey(tile, dir, owner);
+
+	if (use_cache) {
+		SignalBlockCache::const_iterator it = _signal_blocks.find(key);
+		if (it != _signal_blocks.end()) return &it->second;
+	}
+
+	if (!StartSegment(tile, dir)) return NULL;
+
+	_signal_block.Clear();
+	ExploreSegment(owner, &_signal_block);
+
+	/* a block that did not fit into the buffers is explored again every time */
+	if (!use_cache || _signal_block.full) return &_signal_block;
+
+	if (_signal_blocks.size() >= SIG_BLOCK_CACHE_SIZE) ClearSignalBlockCache();
+
+	SignalBlock &block = _signal_blocks[key];
+	block = _signal_block;
+	block.Compact();
+	return &block;
+}
+
+
 /**
  * Updates blocks in _globset buffer
  *
@@ -483,55 +750,10 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 		assert(_tbuset.IsEmpty());
 		assert(_tbdset.IsEmpty());
 
-		/* After updating signal, data stored are always MP_RAILWAY with signals.
-		 * Other situations happen when data are from outside functions -
-		 * modification of railbits (including both rail building and removal),
-		 * train entering/leaving block, train leaving depot...
-		 */
-		switch (GetTileType(tile)) {
-			case MP_TUNNELBRIDGE:
-				/* 'optimization assert' - do not try to update signals when it is not needed */
-				assert(GetTunnelBridgeTransportType(tile) == TRANSPORT_RAIL);
-				assert(dir == INVALID_DIAGDIR || dir == ReverseDiagDir(GetTunnelBridgeDirection(tile)));
-				_tbdset.Add(tile, INVALID_DIAGDIR);  // we can safely start from wormhole centre
-				_tbdset.Add(GetOtherTunnelBridgeEnd(tile), INVALID_DIAGDIR);
-				break;
-
-			case MP_RAILWAY:
-				if (IsRailDepot(tile)) {
-					/* 'optimization assert' do not try to update signals in other cases */
-					assert(dir == INVALID_DIAGDIR || dir == GetRailDepotDirection(tile));
-					_tbdset.Add(tile, INVALID_DIAGDIR); // start from depot inside
-					break;
-				}
-				FALLTHROUGH;
+		const SignalBlock *block = FindSegment(tile, dir, owner);
+		if (block == NULL) continue; // continue the while() loop
 
-			case MP_STATION:
-			case MP_ROAD:
-				if ((TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)) & _enterdir_to_trackbits[dir]) != TRACK_BIT_NONE) {
-					/* only add to set when there is some 'interesting' track */
-					_tbdset.Add(tile, dir);
-					_tbdset.Add(tile + TileOffsByDiagDir(dir), ReverseDiagDir(dir));
-					break;
-				}
-				FALLTHROUGH;
-
-			default:
-				/* jump to next tile */
-				tile = tile + TileOffsByDiagDir(dir);
-				dir = ReverseDiagDir(dir);
-				if ((TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_RAIL, 0)) & _enterdir_to_trackbits[dir]) != TRACK_BIT_NONE) {
-					_tbdset.Add(tile, dir);
-					break;
-				}
-				/* happens when removing a rail that wasn't connected at one or both sides */
-				continue; // continue the while() loop
-		}
-
-		assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
-		assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
-
-		SigFlags flags = ExploreSegment(owner);
+		SigFlags flags = EvaluateSegment(block);
 
 		if (first) {
 			first = false;
@@ -627,6 +849,33 @@ void AddSideToSignalBuffer(TileIndex tile, DiagDirection side, Owner owner)
 	}
 }
 
+/** Forget all explored signal blocks, because the track layout changed. */
+void ClearSignalBlockCache()
+{
+	_signal_blocks.clear();
+}
+
+/** Check whether the cached signal blocks are still the same as freshly explored ones. */
+void CheckSignalBlockCache()
+{
+	for (SignalBlockCache::const_iterator it = _signal_blocks.begin(); it != _signal_blocks.end(); ++it) {
+		TileIndex tile = (TileIndex)(it->first >> 16);
+		Owner owner = (Owner)GB(it->first, 8, 8);
+		DiagDirection dir = (DiagDirection)GB(it->first, 0, 8);
+
+		_signal_block.Clear();
+		if (StartSegment(tile, dir)) {
+			ExploreSegment(owner, &_signal_block);
+			_tbdset.Reset();
+			_signal_block.Compact();
+		}
+
+		if (!(_signal_block == it->second)) {
+			DEBUG(desync, 2, "signal block cache mismatch: tile %i, dir %i, company %i", tile, dir, (int)owner);
+		}
+	}
+}
+
 /**
  * Update signals, starting at one side of a tile
  * Will check tile next to this at opposite side too
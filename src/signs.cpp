@@ -14,6 +14,7 @@
 #include "signs_base.h"
 #include "signs_func.h"
 #include "strings_func.h"
+#include "viewport_kdtree.h"
 #include "core/pool_func.hpp"
 
 #include "table/strings.h"
@@ -39,6 +40,7 @@ Sign::~Sign()
 
 	if (CleaningPool()) return;
 
+	if (this->sign.width_normal != 0) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeSign(this->index));
 	DeleteRenameSignWindow(this->index);
 }
 
@@ -49,7 +51,9 @@ void Sign::UpdateVirtCoord()
 {
 	Point pt = RemapCoords(this->x, this->y, this->z);
 	SetDParam(0, this->index);
+	if (this->sign.width_normal != 0) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeSign(this->index));
 	this->sign.UpdatePosition(pt.x, pt.y - 6 * ZOOM_LVL_BASE, STR_WHITE_SIGN);
+	_viewport_sign_kdtree.Insert(ViewportSignKdtreeItem::MakeSign(this->index));
 }
 
 /** Update the coordinates of all signs */
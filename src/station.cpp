@@ -14,6 +14,7 @@
 #include "company_base.h"
 #include "roadveh.h"
 #include "viewport_func.h"
+#include "viewport_kdtree.h"
 #include "date_func.h"
 #include "command_func.h"
 #include "news_func.h"
@@ -35,6 +36,8 @@
 StationPool _station_pool("Station");
 INSTANTIATE_POOL_METHODS(Station)
 
+TileAreaIndex<StationID> _station_area_index; ///< Index of the areas covered by stations.
+
 BaseStation::~BaseStation()
 {
 	free(this->name);
@@ -48,6 +51,7 @@ BaseStation::~BaseStation()
 	DeleteWindowById(WC_AIRCRAFT_LIST, VehicleListIdentifier(VL_STATION_LIST, VEH_AIRCRAFT, this->owner, this->index).Pack());
 
 	this->sign.MarkDirty();
+	if (this->sign.width_normal != 0) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeStation(this->index));
 }
 
 Station::Station(TileIndex tile) :
@@ -122,6 +126,8 @@ Station::~Station()
 	/* Clear the persistent storage. */
 	delete this->airport.psa;
 
+	_station_area_index.Remove(this->index, this->indexed_area);
+
 	if (this->owner == OWNER_NONE) {
 		/* Invalidate all in case of oil rigs. */
 		InvalidateWindowClassesData(WC_STATION_LIST, 0);
@@ -305,6 +311,51 @@ Rect Station::GetCatchmentRect() const
 	return ret;
 }
 
+/**
+ * Update the area the station is listed with in the station area index, after
+ * station parts have been added or removed. The area covers all station parts.
+ */
+void Station::UpdateAreaIndex()
+{
+	TileArea area;
+	if (!this->rect.IsEmpty()) {
+		area.Add(TileXY(this->rect.left, this->rect.top));
+		area.Add(TileXY(this->rect.right, this->rect.bottom));
+	}
+
+	/* The station rect does not cover parts larger than the station spread. */
+	const TileArea *parts[] = { &this->train_station, &this->bus_station, &this->truck_station, &this->airport };
+	for (uint i = 0; i < lengthof(parts); i++) {
+		if (parts[i]->tile == INVALID_TILE) continue;
+		area.Add(parts[i]->tile);
+		area.Add(TILE_ADDXY(parts[i]->tile, parts[i]->w - 1, parts[i]->h - 1));
+	}
+	if (this->dock_tile != INVALID_TILE) {
+		area.Add(this->dock_tile);
+		if (IsDockTile(this->dock_tile)) area.Add(this->dock_tile + TileOffsByDiagDir(GetDockDirection(this->dock_tile)));
+	}
+
+	if (area.tile == this->indexed_area.tile && area.w == this->indexed_area.w && area.h == this->indexed_area.h) return;
+
+	_station_area_index.Remove(this->index, this->indexed_area);
+	_station_area_index.Add(this->index, area);
+	this->indexed_area = area;
+}
+
+/**
+ * Rebuild the station area index, e.g. after loading a game.
+ */
+void RebuildStationAreaIndex()
+{
+	_station_area_index.Reset();
+
+	Station *st;
+	FOR_ALL_STATIONS(st) {
+		st->indexed_area.Clear();
+		st->UpdateAreaIndex();
+	}
+}
+
 /** Rect and pointer to IndustryVector */
 struct RectAndIndustryVector {
 	Rect rect;                       ///< The rectangle to search the industries in.
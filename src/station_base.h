@@ -19,6 +19,7 @@
 #include "industry_type.h"
 #include "linkgraph/linkgraph_type.h"
 #include "newgrf_storage.h"
+#include "tilearea_index.h"
 #include <map>
 
 typedef Pool<BaseStation, StationID, 32, 64000> StationPool;
@@ -473,6 +474,7 @@ public:
 	CargoTypes always_accepted;       ///< Bitmask of always accepted cargo types (by houses, HQs, industry tiles when industry doesn't accept cargo)
 
 	IndustryVector industries_near; ///< Cached list of industries near the station that can accept cargo, @see DeliverGoodsToIndustry()
+	TileArea indexed_area;          ///< Area the station is listed with in #_station_area_index.
 
 	Station(TileIndex tile = INVALID_TILE);
 	~Station();
@@ -484,6 +486,7 @@ public:
 	void UpdateVirtCoord();
 
 	void AfterStationTileSetChange(bool adding, StationType type);
+	void UpdateAreaIndex();
 
 	/* virtual */ uint GetPlatformLength(TileIndex tile, DiagDirection dir) const;
 	/* virtual */ uint GetPlatformLength(TileIndex tile) const;
@@ -510,6 +513,9 @@ public:
 
 #define FOR_ALL_STATIONS(var) FOR_ALL_BASE_STATIONS_OF_TYPE(Station, var)
 
+extern TileAreaIndex<StationID> _station_area_index;
+void RebuildStationAreaIndex();
+
 /** Iterator to iterate over all tiles belonging to an airport. */
 class AirportTileIterator : public OrthogonalTileIterator {
 private:
@@ -14,6 +14,7 @@
 #include "bridge_map.h"
 #include "cmd_helper.h"
 #include "viewport_func.h"
+#include "viewport_kdtree.h"
 #include "command_func.h"
 #include "town.h"
 #include "news_func.h"
@@ -44,6 +45,7 @@
 #include "pbs.h"
 #include "debug.h"
 #include "core/random_func.hpp"
+#include "core/sort_func.hpp"
 #include "company_base.h"
 #include "table/airporttile_ids.h"
 #include "newgrf_airporttiles.h"
@@ -420,7 +422,9 @@ void Station::UpdateVirtCoord()
 
 	SetDParam(0, this->index);
 	SetDParam(1, this->facilities);
+	if (this->sign.width_normal != 0) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeStation(this->index));
 	this->sign.UpdatePosition(pt.x, pt.y, STR_VIEWPORT_STATION);
+	_viewport_sign_kdtree.Insert(ViewportSignKdtreeItem::MakeStation(this->index));
 
 	SetWindowDirty(WC_STATION_VIEW, this->index);
 }
@@ -503,8 +507,10 @@ CargoArray GetProductionAroundTiles(TileIndex tile, int w, int h, int rad)
 	 * area loop might not hit an industry tile while
 	 * the industry would produce cargo for the station.
 	 */
-	const Industry *i;
-	FOR_ALL_INDUSTRIES(i) {
+	SmallVector<IndustryID, 8> industries;
+	_industry_area_index.Find(x1, y1, x2 - 1, y2 - 1, &industries);
+	for (const IndustryID *id = industries.Begin(); id != industries.End(); id++) {
+		const Industry *i = Industry::Get(*id);
 		if (!ta.Intersects(i->location)) continue;
 
 		for (uint j = 0; j < lengthof(i->produced_cargo); j++) {
@@ -723,6 +729,7 @@ static void DeleteStationIfEmpty(BaseStation *st)
 void Station::AfterStationTileSetChange(bool adding, StationType type)
 {
 	this->UpdateVirtCoord();
+	this->UpdateAreaIndex();
 	this->RecomputeIndustriesNear();
 	DirtyCompanyInfrastructureWindows(this->owner);
 	if (adding) InvalidateWindowData(WC_STATION_LIST, this->owner, 0);
@@ -1630,6 +1637,7 @@ CommandCost CmdRemoveFromRailStation(TileIndex start, DoCommandFlag flags, uint3
 
 		if (st->train_station.tile == INVALID_TILE) SetWindowWidgetDirty(WC_STATION_VIEW, st->index, WID_SV_TRAINS);
 		st->MarkTilesDirty(false);
+		st->UpdateAreaIndex();
 		st->RecomputeIndustriesNear();
 	}
 
@@ -1713,7 +1721,10 @@ static CommandCost RemoveRailStation(TileIndex tile, DoCommandFlag flags)
 	Station *st = Station::GetByTile(tile);
 	CommandCost cost = RemoveRailStation(st, flags, _price[PR_CLEAR_STATION_RAIL]);
 
-	if (flags & DC_EXEC) st->RecomputeIndustriesNear();
+	if (flags & DC_EXEC) {
+		st->UpdateAreaIndex();
+		st->RecomputeIndustriesNear();
+	}
 
 	return cost;
 }
@@ -2160,20 +2171,33 @@ uint8 GetAirportNoiseLevelForTown(const AirportSpec *as, TileIterator &it, TileI
  */
 Town *AirportGetNearestTown(const AirportSpec *as, const TileIterator &it)
 {
-	Town *t, *nearest = NULL;
-	uint add = as->size_x + as->size_y - 2; // GetMinimalAirportDistanceToTile can differ from DistanceManhattan by this much
-	uint mindist = UINT_MAX - add; // prevent overflow
-	FOR_ALL_TOWNS(t) {
-		if (DistanceManhattan(t->xy, it) < mindist + add) { // avoid calling GetMinimalAirportDistanceToTile too often
-			TileIterator *copy = it.Clone();
-			uint dist = GetMinimalAirportDistanceToTile(*copy, t->xy);
-			delete copy;
-			if (dist < mindist) {
-				nearest = t;
-				mindist = dist;
-			}
+	TileIndex tile = it;
+	TownID tid;
+	if (!_town_kdtree.FindNearest(TileX(tile), TileY(tile), UINT_MAX, &tid)) return NULL;
+
+	/* The town nearest to the first tile is at most its distance away from the airport, and
+	 * GetMinimalAirportDistanceToTile can differ from DistanceManhattan by \c add, so no town
+	 * further away than \c radius from the first tile can be nearer to the airport. */
+	uint add = as->size_x + as->size_y - 2;
+	uint radius = DistanceManhattan(Town::Get(tid)->xy, tile) + add;
+
+	Town *nearest = NULL;
+	uint mindist = UINT_MAX;
+	int x = TileX(tile);
+	int y = TileY(tile);
+	_town_kdtree.FindContained(max(x - (int)radius, 0), max(y - (int)radius, 0), min<int>(x + radius, MapMaxX()), min<int>(y + radius, MapMaxY()), [&](TownID id) {
+		Town *t = Town::Get(id);
+		if (DistanceManhattan(t->xy, tile) > radius) return;
+
+		TileIterator *copy = it.Clone();
+		uint dist = GetMinimalAirportDistanceToTile(*copy, t->xy);
+		delete copy;
+		/* The k-d tree reports towns in no particular order, so prefer the lowest index on ties. */
+		if (nearest == NULL || dist < mindist || (dist == mindist && t->index < nearest->index)) {
+			nearest = t;
+			mindist = dist;
 		}
-	}
+	});
 
 	return nearest;
 }
@@ -3776,9 +3800,30 @@ CommandCost CmdRenameStation(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 	return CommandCost();
 }
 
+/** A station found around a producer, with the first tile it was found at. */
+struct FoundStation {
+	TileIndex tile; ///< First station tile in the search area.
+	Station *st;    ///< The station.
+};
+
+/**
+ * Compare two found stations by the order they appear in the search area.
+ * @param a First station.
+ * @param b Second station.
+ * @return <0 if \a a was found first, >0 otherwise.
+ */
+static int CDECL FoundStationSorter(const FoundStation *a, const FoundStation *b)
+{
+	return (int)a->tile - (int)b->tile;
+}
+
 /**
  * Find all stations around a rectangular producer (industry, house, headquarter, ...)
  *
+ * The stations are listed in the order their tiles appear in the area around
+ * the producer, row by row, as cargo distribution among stations with equal
+ * ratings depends on it.
+ *
  * @param location The location/area of the producer
  * @param stations The list to store the stations in
  */
@@ -3799,31 +3844,53 @@ void FindStationsAroundTiles(const TileArea &location, StationList *stations)
 	if (min_y == 0 && _settings_game.construction.freeform_edges) min_y = 1;
 	if (max_x >= MapSizeX()) max_x = MapSizeX() - 1;
 	if (max_y >= MapSizeY()) max_y = MapSizeY() - 1;
+	if (min_x >= max_x || min_y >= max_y) return;
+
+	SmallVector<StationID, 8> candidates;
+	_station_area_index.Find(min_x, min_y, max_x - 1, max_y - 1, &candidates);
+
+	SmallVector<FoundStation, 4> found;
+	for (const StationID *id = candidates.Begin(); id != candidates.End(); id++) {
+		Station *st = Station::Get(*id);
+
+		/* Limit the search to the part of the search area that is within the catchment of the station. */
+		uint x1 = min_x, x2 = max_x, y1 = min_y, y2 = max_y;
+		if (_settings_game.station.modified_catchment) {
+			int rad = st->GetCatchmentRadius();
+			x1 = max<int>(x1, (int)x - rad);
+			x2 = min<int>(x2, x + location.w + rad);
+			y1 = max<int>(y1, (int)y - rad);
+			y2 = min<int>(y2, y + location.h + rad);
+		}
 
-	for (uint cy = min_y; cy < max_y; cy++) {
-		for (uint cx = min_x; cx < max_x; cx++) {
-			TileIndex cur_tile = TileXY(cx, cy);
-			if (!IsTileType(cur_tile, MP_STATION)) continue;
-
-			Station *st = Station::GetByTile(cur_tile);
-			/* st can be NULL in case of waypoints */
-			if (st == NULL) continue;
-
-			if (_settings_game.station.modified_catchment) {
-				int rad = st->GetCatchmentRadius();
-				int rad_x = cx - x;
-				int rad_y = cy - y;
-
-				if (rad_x < -rad || rad_x >= rad + location.w) continue;
-				if (rad_y < -rad || rad_y >= rad + location.h) continue;
+		const TileArea &area = st->indexed_area;
+		x1 = max(x1, TileX(area.tile));
+		x2 = min<uint>(x2, TileX(area.tile) + area.w);
+		y1 = max(y1, TileY(area.tile));
+		y2 = min<uint>(y2, TileY(area.tile) + area.h);
+
+		for (uint cy = y1; cy < y2; cy++) {
+			uint cx;
+			for (cx = x1; cx < x2; cx++) {
+				TileIndex cur_tile = TileXY(cx, cy);
+				if (IsTileType(cur_tile, MP_STATION) && GetStationIndex(cur_tile) == st->index) break;
 			}
+			if (cx == x2) continue;
 
-			/* Insert the station in the set. This will fail if it has
-			 * already been added.
-			 */
-			stations->Include(st);
+			FoundStation *fs = found.Append();
+			fs->tile = TileXY(cx, cy);
+			fs->st = st;
+			break;
 		}
 	}
+
+	QSortT(found.Begin(), found.Length(), &FoundStationSorter);
+	for (const FoundStation *fs = found.Begin(); fs != found.End(); fs++) {
+		/* Insert the station in the set. This will fail if it has
+		 * already been added.
+		 */
+		stations->Include(fs->st);
+	}
 }
 
 /**
@@ -3931,6 +3998,7 @@ void BuildOilRig(TileIndex tile)
 	st->rect.BeforeAddTile(tile, StationRect::ADD_FORCE);
 
 	st->UpdateVirtCoord();
+	st->UpdateAreaIndex();
 	UpdateStationAcceptance(st, false);
 	st->RecomputeIndustriesNear();
 }
@@ -3949,6 +4017,7 @@ void DeleteOilRig(TileIndex tile)
 	st->rect.AfterRemoveTile(st, tile);
 
 	st->UpdateVirtCoord();
+	st->UpdateAreaIndex();
 	st->RecomputeIndustriesNear();
 	if (!st->IsInUse()) delete st;
 }
@@ -4544,4 +4613,5 @@ extern const TileTypeProcs _tile_type_station_procs = {
 	VehicleEnter_Station,       // vehicle_enter_tile_proc
 	GetFoundation_Station,      // get_foundation_proc
 	TerraformTile_Station,      // terraform_tile_proc
+	NULL,                       // tile_loop_batch_proc
 };
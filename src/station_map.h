@@ -17,6 +17,7 @@
 #include "water_map.h"
 #include "station_func.h"
 #include "rail.h"
+#include "animated_tile_func.h"
 
 typedef byte StationGfx; ///< Index of station graphics. @see _station_display_datas
 
@@ -82,6 +83,7 @@ static inline void SetStationGfx(TileIndex t, StationGfx gfx)
 {
 	assert(IsTileType(t, MP_STATION));
 	_m[t].m5 = gfx;
+	ResetAnimatedTileSpeed(t);
 }
 
 /**
@@ -483,6 +485,7 @@ static inline void SetCustomStationSpecIndex(TileIndex t, byte specindex)
 {
 	assert(HasStationTileRail(t));
 	_m[t].m4 = specindex;
+	ResetAnimatedTileSpeed(t);
 }
 
 /**
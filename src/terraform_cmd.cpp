@@ -18,6 +18,8 @@
 #include "object_base.h"
 #include "company_base.h"
 #include "company_func.h"
+#include "tile_cmd.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "table/strings.h"
 
@@ -326,6 +328,11 @@ CommandCost CmdTerraformLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 			SetTileHeight(tile, (uint)height);
 		}
 
+		/* The slope of tracks changed, so their cost for YAPF did too. */
+		for (TileIndexSet::const_iterator it = ts.dirty_tiles.begin(); it != ts.dirty_tiles.end(); it++) {
+			if (GetTileTrackStatus(*it, TRANSPORT_RAIL, 0) != 0) YapfNotifyTrackLayoutChange(*it, INVALID_TRACK);
+		}
+
 		if (c != NULL) c->terraform_limit -= (uint32)ts.tile_to_new_height.size() << 16;
 	}
 	return total_cost;
@@ -0,0 +1,207 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.cpp Implementation of the worker thread pool. */
+
+#include "../stdafx.h"
+#include "../core/math_func.hpp"
+#include "thread_pool.h"
+
+#include "../safeguards.h"
+
+/** State of a single ThreadPool::ParallelFor call, shared by the caller and its helpers. */
+struct ThreadPool::RangeBatch {
+	ThreadPool *pool;         ///< The pool running the batch.
+	ThreadPoolRangeProc proc; ///< Procedure to call for each range.
+	void *data;               ///< Data for the procedure.
+	uint count;               ///< Total number of indices.
+	uint grain;               ///< Number of indices handed out at once.
+	uint next;                ///< First index not handed out yet.
+	uint pending;             ///< Number of indices not finished yet.
+	uint helpers;             ///< Number of helper tasks that are queued or running.
+};
+
+/**
+ * Create a pool without any workers.
+ * @param name Name of the worker threads.
+ */
+ThreadPool::ThreadPool(const char *name) : name(name), exit(false)
+{
+	this->queue_mutex = ThreadMutex::New();
+	this->batch_mutex = ThreadMutex::New();
+}
+
+ThreadPool::~ThreadPool()
+{
+	this->SetWorkerCount(0);
+	delete this->queue_mutex;
+	delete this->batch_mutex;
+}
+
+/**
+ * Change the number of worker threads. Already queued tasks are finished
+ * by the old workers before they stop.
+ * @param count The new number of workers; 0 executes everything on the calling thread.
+ */
+void ThreadPool::SetWorkerCount(uint count)
+{
+	if (count == this->workers.Length()) return;
+
+	this->queue_mutex->BeginCritical();
+	this->exit = true;
+	this->queue_mutex->EndCritical();
+	for (uint i = 0; i < this->workers.Length(); i++) {
+		this->queue_mutex->BeginCritical();
+		this->queue_mutex->SendSignal();
+		this->queue_mutex->EndCritical();
+	}
+	for (ThreadObject **t = this->workers.Begin(); t != this->workers.End(); t++) {
+		(*t)->Join();
+		delete *t;
+	}
+	this->workers.Clear();
+	this->exit = false;
+
+	for (uint i = 0; i < count; i++) {
+		ThreadObject *t;
+		if (!ThreadObject::New(&ThreadPool::WorkerProc, this, &t, this->name)) break;
+		*this->workers.Append() = t;
+	}
+}
+
+/**
+ * Queue a task for the next free worker.
+ * Without workers the task is executed immediately.
+ * @param proc  Procedure to call.
+ * @param param Parameter to the procedure.
+ */
+void ThreadPool::Enqueue(OTTDThreadFunc proc, void *param)
+{
+	if (this->workers.Length() == 0) {
+		proc(param);
+		return;
+	}
+
+	Task task = { proc, param };
+	ThreadMutexLocker lock(this->queue_mutex);
+	this->tasks.push_back(task);
+	this->queue_mutex->SendSignal();
+}
+
+/**
+ * Call \a proc for all indices in [0, count), split into ranges of at most
+ * \a grain indices that are processed concurrently by the workers and the
+ * calling thread. Returns when all ranges are done.
+ * @param count Number of indices.
+ * @param proc  Procedure to call for each range.
+ * @param data  Data for the procedure.
+ * @param grain Number of indices handed out at once.
+ * @note Only one thread may run a ParallelFor on a pool at a time.
+ */
+void ThreadPool::ParallelFor(uint count, ThreadPoolRangeProc proc, void *data, uint grain)
+{
+	grain = max(grain, 1U);
+	if (this->workers.Length() == 0 || count <= grain) {
+		if (count > 0) proc(data, 0, count);
+		return;
+	}
+
+	uint helpers = min(this->workers.Length(), CeilDiv(count, grain) - 1);
+	RangeBatch batch = { this, proc, data, count, grain, 0, count, helpers };
+	for (uint i = 0; i < helpers; i++) this->Enqueue(&ThreadPool::RangeHelperProc, &batch);
+
+	RunRanges(&batch);
+
+	this->batch_mutex->BeginCritical();
+	while (batch.pending > 0) this->batch_mutex->WaitForSignal();
+	this->batch_mutex->EndCritical();
+
+	/* Helpers that did not start yet have nothing left to do. */
+	uint removed = 0;
+	this->queue_mutex->BeginCritical();
+	for (std::deque<Task>::iterator it = this->tasks.begin(); it != this->tasks.end();) {
+		if (it->param == &batch) {
+			it = this->tasks.erase(it);
+			removed++;
+		} else {
+			++it;
+		}
+	}
+	this->queue_mutex->EndCritical();
+
+	this->batch_mutex->BeginCritical();
+	batch.helpers -= removed;
+	while (batch.helpers > 0) this->batch_mutex->WaitForSignal();
+	this->batch_mutex->EndCritical();
+}
+
+/**
+ * Process ranges of a batch until none are left.
+ * @param batch The batch to work on.
+ */
+/* static */ void ThreadPool::RunRanges(RangeBatch *batch)
+{
+	ThreadMutex *mutex = batch->pool->batch_mutex;
+	for (;;) {
+		mutex->BeginCritical();
+		if (batch->next >= batch->count) {
+			mutex->EndCritical();
+			return;
+		}
+		uint first = batch->next;
+		uint last = min(batch->count, first + batch->grain);
+		batch->next = last;
+		mutex->EndCritical();
+
+		batch->proc(batch->data, first, last);
+
+		mutex->BeginCritical();
+		batch->pending -= last - first;
+		if (batch->pending == 0) mutex->SendSignal();
+		mutex->EndCritical();
+	}
+}
+
+/**
+ * Task helping out with a ParallelFor on a worker thread.
+ * @param batch The RangeBatch to help with.
+ */
+/* static */ void ThreadPool::RangeHelperProc(void *batch)
+{
+	RangeBatch *b = (RangeBatch *)batch;
+	ThreadMutex *mutex = b->pool->batch_mutex;
+	RunRanges(b);
+
+	mutex->BeginCritical();
+	b->helpers--;
+	mutex->SendSignal();
+	mutex->EndCritical();
+}
+
+/**
+ * Main loop of a worker thread.
+ * @param pool The ThreadPool the worker belongs to.
+ */
+/* static */ void ThreadPool::WorkerProc(void *pool)
+{
+	ThreadPool *self = (ThreadPool *)pool;
+	for (;;) {
+		self->queue_mutex->BeginCritical();
+		while (self->tasks.empty() && !self->exit) self->queue_mutex->WaitForSignal();
+		if (self->tasks.empty()) {
+			self->queue_mutex->EndCritical();
+			return;
+		}
+		Task task = self->tasks.front();
+		self->tasks.pop_front();
+		self->queue_mutex->EndCritical();
+
+		task.proc(task.param);
+	}
+}
@@ -0,0 +1,69 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.h A fixed set of worker threads executing queued tasks. */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "thread.h"
+#include "../core/smallvec_type.hpp"
+#include <deque>
+
+/**
+ * Procedure for a range of a ThreadPool::ParallelFor.
+ * @param data  The data passed to ParallelFor.
+ * @param first First index of the range to process.
+ * @param last  One past the last index of the range to process.
+ */
+typedef void (*ThreadPoolRangeProc)(void *data, uint first, uint last);
+
+/**
+ * A pool of persistent worker threads. Tasks are handed out in the order
+ * they were queued. If threads are unavailable, or the pool has no workers,
+ * all work is executed on the calling thread instead.
+ */
+class ThreadPool {
+public:
+	ThreadPool(const char *name);
+	~ThreadPool();
+
+	void SetWorkerCount(uint count);
+
+	/**
+	 * Get the number of worker threads that are running.
+	 * @return Number of workers.
+	 */
+	inline uint GetWorkerCount() const { return this->workers.Length(); }
+
+	void Enqueue(OTTDThreadFunc proc, void *param);
+	void ParallelFor(uint count, ThreadPoolRangeProc proc, void *data, uint grain = 1);
+
+private:
+	/** A task waiting for a worker. */
+	struct Task {
+		OTTDThreadFunc proc; ///< Procedure to call.
+		void *param;         ///< Parameter to the procedure.
+	};
+
+	struct RangeBatch;
+
+	const char *name;                     ///< Name given to the worker threads.
+	SmallVector<ThreadObject *, 4> workers; ///< The running worker threads.
+	std::deque<Task> tasks;               ///< Tasks waiting for a worker.
+	ThreadMutex *queue_mutex;             ///< Mutex protecting #tasks and #exit; workers wait on it.
+	ThreadMutex *batch_mutex;             ///< Mutex protecting a running ParallelFor; its caller waits on it.
+	bool exit;                            ///< Whether the workers should stop.
+
+	static void WorkerProc(void *pool);
+	static void RangeHelperProc(void *batch);
+	static void RunRanges(RangeBatch *batch);
+};
+
+#endif /* THREAD_POOL_H */
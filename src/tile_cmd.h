@@ -114,6 +114,7 @@ typedef void AddProducedCargoProc(TileIndex tile, CargoArray &produced);
 typedef bool ClickTileProc(TileIndex tile);
 typedef void AnimateTileProc(TileIndex tile);
 typedef void TileLoopProc(TileIndex tile);
+typedef void TileLoopBatchProc(const TileIndex *tiles, uint count);
 typedef void ChangeTileOwnerProc(TileIndex tile, Owner old_owner, Owner new_owner);
 
 /** @see VehicleEnterTileStatus to see what the return values mean */
@@ -156,10 +157,33 @@ struct TileTypeProcs {
 	VehicleEnterTileProc *vehicle_enter_tile_proc; ///< Called when a vehicle enters a tile
 	GetFoundationProc *get_foundation_proc;
 	TerraformTileProc *terraform_tile_proc;        ///< Called when a terraforming operation is about to take place
+	TileLoopBatchProc *tile_loop_batch_proc;       ///< Called instead of tile_loop_proc with all tiles of this type in a tick, when the tile loop is batched
 };
 
 extern const TileTypeProcs * const _tile_type_procs[16];
 
+/**
+ * Batch version of a tile loop proc, for TileTypeProcs::tile_loop_batch_proc.
+ * Tiles that changed their type since they were put in the batch, because of
+ * the tile loop of an earlier tile, are passed to the tile loop of their new type.
+ * @tparam Ttype Type of the tiles in the batch.
+ * @tparam Tproc Tile loop proc of the type.
+ * @param tiles The tiles to run the tile loop on, in order.
+ * @param count Number of tiles.
+ */
+template <TileType Ttype, TileLoopProc *Tproc>
+void TileLoopBatch(const TileIndex *tiles, uint count)
+{
+	for (uint i = 0; i < count; i++) {
+		TileIndex tile = tiles[i];
+		if (IsTileType(tile, Ttype)) {
+			Tproc(tile);
+		} else {
+			_tile_type_procs[GetTileType(tile)]->tile_loop_proc(tile);
+		}
+	}
+}
+
 TrackStatus GetTileTrackStatus(TileIndex tile, TransportType mode, uint sub_mode, DiagDirection side = INVALID_DIAGDIR);
 VehicleEnterTileStatus VehicleEnterTile(Vehicle *v, TileIndex tile, int x, int y);
 void ChangeTileOwner(TileIndex tile, Owner old_owner, Owner new_owner);
@@ -16,6 +16,7 @@
 #include "map_func.h"
 #include "core/bitmath_func.hpp"
 #include "settings_type.h"
+#include "pathfinder/water_regions.h"
 
 /**
  * Returns the height of a tile
@@ -31,7 +32,7 @@
 static inline uint TileHeight(TileIndex tile)
 {
 	assert(tile < MapSize());
-	return _m[tile].height;
+	return _m_height[tile];
 }
 
 /**
@@ -60,7 +61,7 @@ static inline void SetTileHeight(TileIndex tile, uint height)
 {
 	assert(tile < MapSize());
 	assert(height <= MAX_TILE_HEIGHT);
-	_m[tile].height = height;
+	_m_height[tile] = height;
 }
 
 /**
@@ -98,7 +99,7 @@ static inline uint TilePixelHeightOutsideMap(int x, int y)
 static inline TileType GetTileType(TileIndex tile)
 {
 	assert(tile < MapSize());
-	return (TileType)GB(_m[tile].type, 4, 4);
+	return (TileType)GB(_m_type[tile], 4, 4);
 }
 
 /**
@@ -137,7 +138,9 @@ static inline void SetTileType(TileIndex tile, TileType type)
 	 * edges of the map. If _settings_game.construction.freeform_edges is true,
 	 * the upper edges of the map are also VOID tiles. */
 	assert(IsInnerTile(tile) == (type != MP_VOID));
-	SB(_m[tile].type, 4, 4, type);
+	SB(_m_type[tile], 4, 4, type);
+	/* All changes to water tiles rebuild the tile, so they pass here. */
+	InvalidateWaterRegion(tile);
 }
 
 /**
@@ -228,7 +231,7 @@ static inline void SetTropicZone(TileIndex tile, TropicZone type)
 {
 	assert(tile < MapSize());
 	assert(!IsTileType(tile, MP_VOID) || type == TROPICZONE_NORMAL);
-	SB(_m[tile].type, 0, 2, type);
+	SB(_m_type[tile], 0, 2, type);
 }
 
 /**
@@ -240,7 +243,7 @@ static inline void SetTropicZone(TileIndex tile, TropicZone type)
 static inline TropicZone GetTropicZone(TileIndex tile)
 {
 	assert(tile < MapSize());
-	return (TropicZone)GB(_m[tile].type, 0, 2);
+	return (TropicZone)GB(_m_type[tile], 0, 2);
 }
 
 /**
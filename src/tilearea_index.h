@@ -0,0 +1,134 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tilearea_index.h Spatial index of things covering an area of the map. */
+
+#ifndef TILEAREA_INDEX_H
+#define TILEAREA_INDEX_H
+
+#include "tilearea_type.h"
+#include "core/smallvec_type.hpp"
+#include <vector>
+
+/**
+ * Index of items that cover a rectangular area of the map, to find the items
+ * near some tiles without looking at every tile around them. The map is split
+ * in square cells and every item is listed in each cell its area touches.
+ * Lookups therefore return a superset of the items overlapping the searched
+ * rectangle; callers have to check the candidates themselves.
+ * @tparam T Type of the indexed items, usually a pool index.
+ */
+template <typename T>
+class TileAreaIndex {
+	static const uint CELL_BITS = 4; ///< Cells are (1 << CELL_BITS) tiles in both directions.
+
+	typedef SmallVector<T, 4> Cell;
+
+	std::vector<Cell> cells; ///< All cells, row by row.
+	uint size_x;             ///< Number of cells in x direction.
+	uint size_y;             ///< Number of cells in y direction.
+
+	/**
+	 * Get the cells touched by a rectangle, clamped to the index.
+	 * @param left   Minimal tile X of the rectangle.
+	 * @param top    Minimal tile Y of the rectangle.
+	 * @param right  Maximal tile X of the rectangle (inclusive).
+	 * @param bottom Maximal tile Y of the rectangle (inclusive).
+	 * @param[out] cx1 First cell in x direction.
+	 * @param[out] cy1 First cell in y direction.
+	 * @param[out] cx2 Last cell in x direction (inclusive).
+	 * @param[out] cy2 Last cell in y direction (inclusive).
+	 * @return False if the index is empty.
+	 */
+	bool GetCells(uint left, uint top, uint right, uint bottom, uint *cx1, uint *cy1, uint *cx2, uint *cy2) const
+	{
+		if (this->size_x == 0 || this->size_y == 0) return false;
+		*cx1 = min(left >> CELL_BITS, this->size_x - 1);
+		*cy1 = min(top >> CELL_BITS, this->size_y - 1);
+		*cx2 = min(right >> CELL_BITS, this->size_x - 1);
+		*cy2 = min(bottom >> CELL_BITS, this->size_y - 1);
+		return true;
+	}
+
+public:
+	TileAreaIndex() : size_x(0), size_y(0) {}
+
+	/**
+	 * Remove all items and resize the index to the current map.
+	 */
+	void Reset()
+	{
+		this->size_x = max(MapSizeX() >> CELL_BITS, 1U);
+		this->size_y = max(MapSizeY() >> CELL_BITS, 1U);
+		this->cells.clear();
+		this->cells.resize(this->size_x * this->size_y);
+	}
+
+	/**
+	 * Add an item to the index.
+	 * @param item The item to add.
+	 * @param area The area the item covers.
+	 */
+	void Add(T item, const TileArea &area)
+	{
+		uint cx1, cy1, cx2, cy2;
+		if (area.tile == INVALID_TILE || area.w == 0 || area.h == 0) return;
+		if (!this->GetCells(TileX(area.tile), TileY(area.tile), TileX(area.tile) + area.w - 1, TileY(area.tile) + area.h - 1, &cx1, &cy1, &cx2, &cy2)) return;
+
+		for (uint cy = cy1; cy <= cy2; cy++) {
+			for (uint cx = cx1; cx <= cx2; cx++) {
+				this->cells[cy * this->size_x + cx].Include(item);
+			}
+		}
+	}
+
+	/**
+	 * Remove an item from the index. Cells not listing the item are left alone.
+	 * @param item The item to remove.
+	 * @param area The area the item was added with.
+	 */
+	void Remove(T item, const TileArea &area)
+	{
+		uint cx1, cy1, cx2, cy2;
+		if (area.tile == INVALID_TILE || area.w == 0 || area.h == 0) return;
+		if (!this->GetCells(TileX(area.tile), TileY(area.tile), TileX(area.tile) + area.w - 1, TileY(area.tile) + area.h - 1, &cx1, &cy1, &cx2, &cy2)) return;
+
+		for (uint cy = cy1; cy <= cy2; cy++) {
+			for (uint cx = cx1; cx <= cx2; cx++) {
+				Cell &cell = this->cells[cy * this->size_x + cx];
+				T *found = cell.Find(item);
+				if (found != cell.End()) cell.Erase(found);
+			}
+		}
+	}
+
+	/**
+	 * Find the items that possibly overlap a rectangle. Every item is reported once.
+	 * @param left   Minimal tile X of the rectangle.
+	 * @param top    Minimal tile Y of the rectangle.
+	 * @param right  Maximal tile X of the rectangle (inclusive).
+	 * @param bottom Maximal tile Y of the rectangle (inclusive).
+	 * @param[out] result List to add the candidates to.
+	 */
+	template <uint S>
+	void Find(uint left, uint top, uint right, uint bottom, SmallVector<T, S> *result) const
+	{
+		uint cx1, cy1, cx2, cy2;
+		if (!this->GetCells(left, top, right, bottom, &cx1, &cy1, &cx2, &cy2)) return;
+
+		for (uint cy = cy1; cy <= cy2; cy++) {
+			for (uint cx = cx1; cx <= cx2; cx++) {
+				const Cell &cell = this->cells[cy * this->size_x + cx];
+				for (const T *item = cell.Begin(); item != cell.End(); item++) result->Include(*item);
+			}
+		}
+	}
+};
+
+#endif /* TILEAREA_INDEX_H */
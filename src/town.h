@@ -18,6 +18,7 @@
 #include "newgrf_storage.h"
 #include "cargotype.h"
 #include "tilematrix_type.hpp"
+#include "core/kdtree.hpp"
 #include <list>
 
 template <typename T>
@@ -178,6 +179,22 @@ Town *CalcClosestTownFromTile(TileIndex tile, uint threshold = UINT_MAX);
 #define FOR_ALL_TOWNS_FROM(var, start) FOR_ALL_ITEMS_FROM(Town, town_index, var, start)
 #define FOR_ALL_TOWNS(var) FOR_ALL_TOWNS_FROM(var, 0)
 
+/** Coordinate function of towns for the k-d tree of towns. */
+struct Kdtree_TownXYFunc {
+	inline uint16 operator()(TownID tid, int dim) const
+	{
+		TileIndex xy = Town::Get(tid)->xy;
+		return dim == 0 ? TileX(xy) : TileY(xy);
+	}
+};
+
+/** K-d tree of the centres of all towns. */
+typedef Kdtree<TownID, Kdtree_TownXYFunc, uint16, uint> TownKdtree;
+extern TownKdtree _town_kdtree;
+
+void RebuildTownKdtree();
+void BenchmarkClosestTown(uint queries);
+
 void ResetHouses();
 
 void ClearTownHouse(Town *t, TileIndex tile);
@@ -14,6 +14,7 @@
 #include "road_cmd.h"
 #include "landscape.h"
 #include "viewport_func.h"
+#include "viewport_kdtree.h"
 #include "cmd_helper.h"
 #include "command_func.h"
 #include "industry.h"
@@ -46,6 +47,8 @@
 #include "object_base.h"
 #include "ai/ai.hpp"
 #include "game/game.hpp"
+#include "console_func.h"
+#include <chrono>
 
 #include "table/strings.h"
 #include "table/town_land.h"
@@ -59,6 +62,17 @@ CargoTypes _town_cargoes_accepted; ///< Bitmap of all cargoes accepted by houses
 TownPool _town_pool("Town");
 INSTANTIATE_POOL_METHODS(Town)
 
+TownKdtree _town_kdtree; ///< K-d tree of the centres of all towns.
+
+/** Rebuild the k-d tree of towns, e.g. after loading a game. */
+void RebuildTownKdtree()
+{
+	std::vector<TownID> towns;
+	const Town *t;
+	FOR_ALL_TOWNS(t) towns.push_back(t->index);
+	_town_kdtree.Build(towns.begin(), towns.end());
+}
+
 Town::~Town()
 {
 	free(this->name);
@@ -104,6 +118,8 @@ Town::~Town()
 	DeleteSubsidyWith(ST_TOWN, this->index);
 	DeleteNewGRFInspectWindow(GSF_FAKE_TOWNS, this->index);
 	CargoPacket::InvalidateAllFrom(ST_TOWN, this->index);
+	_town_kdtree.Remove(this->index);
+	if (this->cache.sign.width_normal != 0) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeTown(this->index));
 	MarkWholeScreenDirty();
 }
 
@@ -341,30 +357,8 @@ static void AnimateTile_Town(TileIndex tile)
  */
 static bool IsCloseToTown(TileIndex tile, uint dist)
 {
-	/* On a large map with many towns, it may be faster to check the surroundings of the tile.
-	 * An iteration in TILE_AREA_LOOP() is generally 2 times faster than one in FOR_ALL_TOWNS(). */
-	if (Town::GetNumItems() > (size_t) (dist * dist * 2)) {
-		const int tx = TileX(tile);
-		const int ty = TileY(tile);
-		TileArea tile_area = TileArea(
-			TileXY(max(0,         tx - (int) dist), max(0,         ty - (int) dist)),
-			TileXY(min(MapMaxX(), tx + (int) dist), min(MapMaxY(), ty + (int) dist))
-		);
-		TILE_AREA_LOOP(atile, tile_area) {
-			if (GetTileType(atile) == MP_HOUSE) {
-				Town *t = Town::GetByTile(atile);
-				if (DistanceManhattan(tile, t->xy) < dist) return true;
-			}
-		}
-		return false;
-	}
-
-	const Town *t;
-
-	FOR_ALL_TOWNS(t) {
-		if (DistanceManhattan(tile, t->xy) < dist) return true;
-	}
-	return false;
+	TownID tid;
+	return _town_kdtree.FindNearest(TileX(tile), TileY(tile), dist, &tid);
 }
 
 /**
@@ -376,9 +370,11 @@ void Town::UpdateVirtCoord()
 	Point pt = RemapCoords2(TileX(this->xy) * TILE_SIZE, TileY(this->xy) * TILE_SIZE);
 	SetDParam(0, this->index);
 	SetDParam(1, this->cache.population);
+	if (this->cache.sign.width_normal != 0) _viewport_sign_kdtree.Remove(ViewportSignKdtreeItem::MakeTown(this->index));
 	this->cache.sign.UpdatePosition(pt.x, pt.y - 24 * ZOOM_LVL_BASE,
 		_settings_client.gui.population_in_label ? STR_VIEWPORT_TOWN_POP : STR_VIEWPORT_TOWN,
 		STR_VIEWPORT_TOWN);
+	_viewport_sign_kdtree.Insert(ViewportSignKdtreeItem::MakeTown(this->index));
 
 	SetWindowDirty(WC_TOWN_VIEW, this->index);
 }
@@ -1592,6 +1588,7 @@ static void UpdateTownGrowth(Town *t);
 static void DoCreateTown(Town *t, TileIndex tile, uint32 townnameparts, TownSize size, bool city, TownLayout layout, bool manual)
 {
 	t->xy = tile;
+	_town_kdtree.Insert(t->index);
 	t->cache.num_houses = 0;
 	t->time_until_rebuild = 10;
 	UpdateTownRadius(t);
@@ -3303,19 +3300,56 @@ CommandCost CheckIfAuthorityAllowsNewStation(TileIndex tile, DoCommandFlag flags
  */
 Town *CalcClosestTownFromTile(TileIndex tile, uint threshold)
 {
-	Town *t;
-	uint best = threshold;
-	Town *best_town = NULL;
-
-	FOR_ALL_TOWNS(t) {
-		uint dist = DistanceManhattan(tile, t->xy);
-		if (dist < best) {
-			best = dist;
-			best_town = t;
+	TownID tid;
+	if (!_town_kdtree.FindNearest(TileX(tile), TileY(tile), threshold, &tid)) return NULL;
+	return Town::Get(tid);
+}
+
+/**
+ * Look up the closest town of random tiles with the k-d tree of towns and by
+ * going over all towns, and print the time both take to the console. This
+ * doesn't change the game state.
+ * @param queries Number of tiles to look up.
+ */
+void BenchmarkClosestTown(uint queries)
+{
+	/* Use a randomizer of our own, so the game's random state stays the same. */
+	Randomizer random;
+	random.SetSeed(queries);
+	TileIndex *tiles = MallocT<TileIndex>(queries);
+	for (uint i = 0; i < queries; i++) tiles[i] = random.Next(MapSize());
+
+	TownID *found = MallocT<TownID>(queries);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < queries; i++) {
+		const Town *t = CalcClosestTownFromTile(tiles[i]);
+		found[i] = t == NULL ? INVALID_TOWN : t->index;
+	}
+	uint64 kdtree_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	uint mismatches = 0;
+	start = std::chrono::steady_clock::now();
+	for (uint i = 0; i < queries; i++) {
+		/* The lowest index wins ties, like in the k-d tree. */
+		TownID best_town = INVALID_TOWN;
+		uint best = UINT_MAX;
+		const Town *t;
+		FOR_ALL_TOWNS(t) {
+			uint dist = DistanceManhattan(tiles[i], t->xy);
+			if (dist < best) {
+				best = dist;
+				best_town = t->index;
+			}
 		}
+		if (best_town != found[i]) mismatches++;
 	}
+	uint64 scan_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	free(found);
+	free(tiles);
 
-	return best_town;
+	IConsolePrintF(CC_INFO, "%u towns, %u lookups: k-d tree %u us, scan of all towns %u us", (uint)Town::GetNumItems(), queries, (uint)kdtree_time, (uint)scan_time);
+	if (mismatches != 0) IConsolePrintF(CC_ERROR, "%u lookups found a different town", mismatches);
 }
 
 /**
@@ -3546,6 +3580,7 @@ extern const TileTypeProcs _tile_type_town_procs = {
 	NULL,                    // vehicle_enter_tile_proc
 	GetFoundation_Town,      // get_foundation_proc
 	TerraformTile_Town,      // terraform_tile_proc
+	TileLoopBatch<MP_HOUSE, TileLoop_Town>, // tile_loop_batch_proc
 };
 
 
@@ -14,6 +14,7 @@
 
 #include "road_map.h"
 #include "house.h"
+#include "animated_tile_func.h"
 
 /**
  * Get the index of which town this house/street is attached to.
@@ -74,6 +75,7 @@ static inline void SetHouseType(TileIndex t, HouseID house_id)
 	assert(IsTileType(t, MP_HOUSE));
 	_m[t].m4 = GB(house_id, 0, 8);
 	SB(_m[t].m3, 6, 1, GB(house_id, 8, 1));
+	ResetAnimatedTileSpeed(t);
 }
 
 /**
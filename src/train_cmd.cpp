@@ -1661,12 +1661,12 @@ static bool TrainApproachingCrossing(TileIndex tile)
 	DiagDirection dir = AxisToDiagDir(GetCrossingRailAxis(tile));
 	TileIndex tile_from = tile + TileOffsByDiagDir(dir);
 
-	if (HasVehicleOnPos(tile_from, &tile, &TrainApproachingCrossingEnum)) return true;
+	if (HasTrainOnPos(tile_from, &tile, &TrainApproachingCrossingEnum)) return true;
 
 	dir = ReverseDiagDir(dir);
 	tile_from = tile + TileOffsByDiagDir(dir);
 
-	return HasVehicleOnPos(tile_from, &tile, &TrainApproachingCrossingEnum);
+	return HasTrainOnPos(tile_from, &tile, &TrainApproachingCrossingEnum);
 }
 
 
@@ -1681,7 +1681,7 @@ void UpdateLevelCrossing(TileIndex tile, bool sound)
 	assert(IsLevelCrossingTile(tile));
 
 	/* reserved || train on crossing || train approaching crossing */
-	bool new_state = HasCrossingReservation(tile) || HasVehicleOnPos(tile, NULL, &TrainOnTileEnum) || TrainApproachingCrossing(tile);
+	bool new_state = HasCrossingReservation(tile) || HasTrainOnPos(tile, NULL, &TrainOnTileEnum) || TrainApproachingCrossing(tile);
 
 	if (new_state != IsCrossingBarred(tile)) {
 		if (new_state && sound) {
@@ -2004,6 +2004,7 @@ static FindDepotData FindClosestTrainDepot(Train *v, int max_distance)
 	PBSTileInfo origin = FollowTrainReservation(v);
 	if (IsRailDepotTile(origin.tile)) return FindDepotData(origin.tile, 0);
 
+	PerformanceAccumulator framerate(PFE_GL_PF_TRAINS);
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF: return NPFTrainFindNearestDepot(v, max_distance);
 		case VPF_YAPF: return YapfTrainFindNearestDepot(v, max_distance);
@@ -2312,6 +2313,7 @@ static const byte _initial_tile_subcoord[6][4][3] = {
  */
 static Track DoTrainPathfind(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool do_track_reservation, PBSTileInfo *dest)
 {
+	PerformanceAccumulator framerate(PFE_GL_PF_TRAINS);
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF: return NPFTrainChooseTrack(v, path_found, do_track_reservation, dest);
 		case VPF_YAPF: return YapfTrainChooseTrack(v, tile, enterdir, tracks, path_found, do_track_reservation, dest);
@@ -2419,6 +2421,7 @@ static PBSTileInfo ExtendTrainReservation(const Train *v, TrackBits *new_tracks,
  */
 static bool TryReserveSafeTrack(const Train *v, TileIndex tile, Trackdir td, bool override_railtype)
 {
+	PerformanceAccumulator framerate(PFE_GL_PF_TRAINS);
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF: return NPFTrainFindNearestSafeTile(v, tile, td, override_railtype);
 		case VPF_YAPF: return YapfTrainFindNearestSafeTile(v, tile, td, override_railtype);
@@ -2738,6 +2741,113 @@ bool TryPathReserve(Train *v, bool mark_as_stuck, bool first_tile_okay)
 }
 
 
+/**
+ * Predict whether a stuck train will need the pathfinder when it tries to reserve
+ * a path in the next tick, and where its reservation will end then. This follows
+ * TryPathReserve() and ExtendTrainReservation() without changing anything.
+ * @param v The train.
+ * @param[out] origin The end of the reservation the pathfinder will start from.
+ * @return True if the train will most likely call the pathfinder.
+ */
+static bool PredictTrainPathfinding(const Train *v, PBSTileInfo *origin)
+{
+	if (!HasBit(v->flags, VRF_TRAIN_STUCK) || (v->vehstatus & (VS_CRASHED | VS_STOPPED)) != 0) return false;
+	if (v->force_proceed != TFP_NONE || v->track == TRACK_BIT_DEPOT || v->current_order.IsType(OT_LOADING)) return false;
+
+	/* Will the train try again in the next tick? See TrainLocoHandler(). */
+	uint wait_counter = (uint16)(v->wait_counter + 1);
+	bool turn_around = wait_counter % (_settings_game.pf.wait_for_pbs_path * DAY_TICKS) == 0 && _settings_game.pf.reverse_at_signals;
+	if (!turn_around && wait_counter % _settings_game.pf.path_backoff_interval != 0) return false;
+
+	Vehicle *other_train = NULL;
+	PBSTileInfo res = FollowTrainReservation(v, &other_train);
+	if (other_train != NULL && other_train->index != v->index) return false;
+	if (res.okay && v->tile != res.tile) return false;
+
+	/* The train already has a reserved track to continue on. */
+	DiagDirection exitdir = TrackdirToExitdir(res.trackdir);
+	if (HasReservedTracks(TileAddByDiagDir(res.tile, exitdir), DiagdirReachesTracks(exitdir))) return false;
+
+	CFollowTrackRail ft(v);
+
+	TileIndex tile = res.tile;
+	Trackdir  cur_td = res.trackdir;
+	while (ft.Follow(tile, cur_td)) {
+		if (KillFirstBit(ft.m_new_td_bits) == TRACKDIR_BIT_NONE) {
+			if (HasOnewaySignalBlockingTrackdir(ft.m_new_tile, FindFirstTrackdir(ft.m_new_td_bits))) return false;
+		}
+
+		if (_settings_game.pf.forbid_90_deg) {
+			ft.m_new_td_bits &= ~TrackdirCrossesTrackdirs(ft.m_old_td);
+			if (ft.m_new_td_bits == TRACKDIR_BIT_NONE) return false;
+		}
+
+		bool target_seen = ft.m_is_station || (IsTileType(ft.m_new_tile, MP_RAILWAY) && !IsPlainRail(ft.m_new_tile));
+		if (target_seen || KillFirstBit(ft.m_new_td_bits) != TRACKDIR_BIT_NONE) {
+			if (HasReservedTracks(ft.m_new_tile, TrackdirBitsToTrackBits(TrackdirReachesTrackdirs(ft.m_old_td)))) return false;
+
+			/* The reservation will be extended up to here, then the pathfinder takes over. */
+			*origin = PBSTileInfo(tile, cur_td, false);
+			return true;
+		}
+
+		tile = ft.m_new_tile;
+		cur_td = FindFirstTrackdir(ft.m_new_td_bits);
+
+		if (IsSafeWaitingPosition(v, tile, cur_td, true, _settings_game.pf.forbid_90_deg)) return false;
+		if (!CanReserveRailTrack(tile, TrackdirToTrack(cur_td))) return false;
+	}
+
+	return false;
+}
+
+/**
+ * Search the paths of the stuck trains that will try to reserve a path in the next tick.
+ * @param threaded Whether the searches may run in the background.
+ */
+static void SearchTrainPathsAhead(bool threaded)
+{
+	YapfTrainDiscardPathSearches();
+	if (!_settings_game.pf.yapf.rail_path_lookahead || _settings_game.pf.pathfinder_for_trains != VPF_YAPF) return;
+
+	Train *v;
+	FOR_ALL_TRAINS(v) {
+		PBSTileInfo origin;
+		if (v->IsFrontEngine() && PredictTrainPathfinding(v, &origin)) YapfTrainQueuePathSearch(v, origin);
+	}
+
+	YapfTrainStartPathSearches(threaded);
+}
+
+/**
+ * Start searching the paths the stuck trains need in the next tick, in the background.
+ * Called at the end of a tick; nothing in the game may change until
+ * FinishTrainPathLookahead() or CancelTrainPathLookahead() is called.
+ */
+void StartTrainPathLookahead()
+{
+	SearchTrainPathsAhead(true);
+}
+
+/**
+ * Wait for the path searches started at the end of the previous tick. If the game
+ * changed in the meantime, the searches are done again now. This way their result
+ * only depends on the game state at the start of the tick, which is the same for
+ * every client, no matter whether it executed commands or loaded the game since.
+ */
+void FinishTrainPathLookahead()
+{
+	if (!YapfTrainHasPathSearches()) SearchTrainPathsAhead(false);
+	YapfTrainWaitForPathSearches();
+}
+
+/** Stop the running path searches and forget their results, because the game is going to change. */
+void CancelTrainPathLookahead()
+{
+	YapfTrainDiscardPathSearches();
+}
+
+
 static bool CheckReverseTrain(const Train *v)
 {
 	if (_settings_game.difficulty.line_reverse_mode != 0 ||
@@ -2748,6 +2858,7 @@ static bool CheckReverseTrain(const Train *v)
 
 	assert(v->track != TRACK_BIT_NONE);
 
+	PerformanceAccumulator framerate(PFE_GL_PF_TRAINS);
 	switch (_settings_game.pf.pathfinder_for_trains) {
 		case VPF_NPF: return NPFTrainCheckReverse(v);
 		case VPF_YAPF: return YapfTrainCheckReverse(v);
@@ -3049,8 +3160,8 @@ static bool CheckTrainCollision(Train *v)
 
 	/* find colliding vehicles */
 	if (v->track == TRACK_BIT_WORMHOLE) {
-		FindVehicleOnPos(v->tile, &tcc, FindTrainCollideEnum);
-		FindVehicleOnPos(GetOtherTunnelBridgeEnd(v->tile), &tcc, FindTrainCollideEnum);
+		FindTrainOnPos(v->tile, &tcc, FindTrainCollideEnum);
+		FindTrainOnPos(GetOtherTunnelBridgeEnd(v->tile), &tcc, FindTrainCollideEnum);
 	} else {
 		FindVehicleOnPosXY(v->x_pos, v->y_pos, &tcc, FindTrainCollideEnum);
 	}
@@ -3198,7 +3309,7 @@ bool TrainController(Train *v, Vehicle *nomove, bool reverse)
 								exitdir = ReverseDiagDir(exitdir);
 
 								/* check if a train is waiting on the other side */
-								if (!HasVehicleOnPos(o_tile, &exitdir, &CheckTrainAtSignal)) return false;
+								if (!HasTrainOnPos(o_tile, &exitdir, &CheckTrainAtSignal)) return false;
 							}
 						}
 
@@ -3474,7 +3585,7 @@ static void DeleteLastWagon(Train *v)
 
 		/* If there are still crashed vehicles on the tile, give the track reservation to them */
 		TrackBits remaining_trackbits = TRACK_BIT_NONE;
-		FindVehicleOnPos(tile, &remaining_trackbits, CollectTrackbitsFromCrashedVehiclesEnum);
+		FindTrainOnPos(tile, &remaining_trackbits, CollectTrackbitsFromCrashedVehiclesEnum);
 
 		/* It is important that these two are the first in the loop, as reservation cannot deal with every trackbit combination */
 		assert(TRACK_BEGIN == TRACK_X && TRACK_Y == TRACK_BEGIN + 1);
@@ -814,4 +814,5 @@ extern const TileTypeProcs _tile_type_trees_procs = {
 	NULL,                     // vehicle_enter_tile_proc
 	GetFoundation_Trees,      // get_foundation_proc
 	TerraformTile_Trees,      // terraform_tile_proc
+	TileLoopBatch<MP_TREES, TileLoop_Trees>, // tile_loop_batch_proc
 };
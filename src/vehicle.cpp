@@ -53,6 +53,9 @@
 #include "linkgraph/linkgraph.h"
 #include "linkgraph/refresh.h"
 #include "framerate_type.h"
+#include "settings_type.h"
+#include "debug.h"
+#include "thread/thread_pool.h"
 
 #include "table/strings.h"
 
@@ -379,6 +382,16 @@ const int HASH_RES = 0;
 
 static Vehicle *_vehicle_tile_hash[TOTAL_HASH_SIZE];
 
+/* The number of trains on a tile sticks at this value, as it is not known anymore when they have all left. */
+static const uint8 TRAIN_TILE_COUNT_STUCK = UINT8_MAX;
+
+/**
+ * Number of train vehicles in the tile hash per tile of the map. When it is
+ * 0 for a tile, looking for trains on it does not need to walk the hash.
+ * NULL when the counters are disabled with gui.count_trains_per_tile.
+ */
+static uint8 *_train_tile_count = NULL;
+
 static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first)
 {
 	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
@@ -515,6 +528,61 @@ bool HasVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
 	return VehicleFromPos(tile, data, proc, true) != NULL;
 }
 
+/**
+ * Helper function for FindTrainOnPos/HasTrainOnPos.
+ * Only walks the tile hash when there is a train on the tile.
+ * @note Do not call this function directly!
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The proc that determines whether a vehicle will be "found", it may only find trains.
+ * @param find_first Whether to return on the first found or iterate over
+ *                   all vehicles
+ * @return the best matching or first vehicle (depending on find_first).
+ */
+static Vehicle *TrainFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
+{
+	if (_train_tile_count != NULL && _train_tile_count[tile] == 0) {
+#ifdef _DEBUG
+		/* Make sure the counter is in sync with the tile hash. */
+		int x = GB(TileX(tile), HASH_RES, HASH_BITS);
+		int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
+		for (const Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK]; v != NULL; v = v->hash_tile_next) {
+			assert(v->type != VEH_TRAIN || v->hash_tile_counted != tile);
+		}
+#endif /* _DEBUG */
+		return NULL;
+	}
+
+	return VehicleFromPos(tile, data, proc, find_first);
+}
+
+/**
+ * Find a train from a specific location, like #FindVehicleOnPos.
+ * Use this instead of #FindVehicleOnPos when \a proc only finds trains,
+ * because it does not need to look at tiles without trains.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The proc that determines whether a vehicle will be "found", it may only find trains.
+ */
+void FindTrainOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
+{
+	TrainFromPos(tile, data, proc, false);
+}
+
+/**
+ * Checks whether a train is on a specific location, like #HasVehicleOnPos.
+ * Use this instead of #HasVehicleOnPos when \a proc only finds trains,
+ * because it is only an array lookup for tiles without trains.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The \a proc that determines whether a vehicle will be "found", it may only find trains.
+ * @return True if proc returned non-NULL.
+ */
+bool HasTrainOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
+{
+	return TrainFromPos(tile, data, proc, true) != NULL;
+}
+
 /**
  * Callback that returns 'real' vehicles lower or at height \c *(int*)data .
  * @param v Vehicle to examine.
@@ -604,13 +672,39 @@ CommandCost EnsureNoTrainOnTrackBits(TileIndex tile, TrackBits track_bits)
 	 * error message only (which may be different for different machines).
 	 * Such a message does not affect MP synchronisation.
 	 */
-	Vehicle *v = VehicleFromPos(tile, &track_bits, &EnsureNoTrainOnTrackProc, true);
+	Vehicle *v = TrainFromPos(tile, &track_bits, &EnsureNoTrainOnTrackProc, true);
 	if (v != NULL) return_cmd_error(STR_ERROR_TRAIN_IN_THE_WAY + v->type);
 	return CommandCost();
 }
 
+/**
+ * Move a train to the counter of its current tile.
+ * @param v The train.
+ * @param remove Whether the train is removed from the tile hash.
+ */
+static void UpdateTrainTileCount(Vehicle *v, bool remove)
+{
+	TileIndex old_tile = v->hash_tile_current != NULL ? v->hash_tile_counted : INVALID_TILE;
+	TileIndex new_tile = remove ? INVALID_TILE : v->tile;
+
+	if (old_tile == new_tile) return;
+
+	/* The tile is remembered even without counters, so they can be rebuilt when enabled. */
+	v->hash_tile_counted = new_tile;
+	if (_train_tile_count == NULL) return;
+
+	if (old_tile != INVALID_TILE && _train_tile_count[old_tile] != TRAIN_TILE_COUNT_STUCK) {
+		assert(_train_tile_count[old_tile] != 0);
+		_train_tile_count[old_tile]--;
+	}
+	if (new_tile != INVALID_TILE && _train_tile_count[new_tile] != TRAIN_TILE_COUNT_STUCK) _train_tile_count[new_tile]++;
+}
+
 static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 {
+	/* Needs the old hash_tile_current to know whether the train is counted. */
+	if (v->type == VEH_TRAIN) UpdateTrainTileCount(v, remove);
+
 	Vehicle **old_hash = v->hash_tile_current;
 	Vehicle **new_hash;
 
@@ -676,6 +770,52 @@ void ResetVehicleHash()
 	FOR_ALL_VEHICLES(v) { v->hash_tile_current = NULL; }
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
 	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+	if (_train_tile_count != NULL) MemSetT(_train_tile_count, 0, MapSize());
+}
+
+/** (Re)allocate the train tile counters for a newly allocated map, if they are enabled. */
+void AllocateTrainTileCounts()
+{
+	free(_train_tile_count);
+	_train_tile_count = _settings_client.gui.count_trains_per_tile ? CallocT<uint8>(MapSize()) : NULL;
+}
+
+/** Allocate or free the train tile counters after enabling or disabling them, and count the trains in the tile hash. */
+void RebuildTrainTileCounts()
+{
+	AllocateTrainTileCounts();
+	if (_train_tile_count == NULL) return;
+
+	const Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		if (v->type != VEH_TRAIN || v->hash_tile_current == NULL) continue;
+		if (_train_tile_count[v->hash_tile_counted] != TRAIN_TILE_COUNT_STUCK) _train_tile_count[v->hash_tile_counted]++;
+	}
+}
+
+/** Check whether the train tile counters match the trains in the tile hash. */
+void CheckTrainTileCounts()
+{
+	if (_train_tile_count == NULL) return;
+
+	uint8 *count = CallocT<uint8>(MapSize());
+
+	const Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		if (v->type != VEH_TRAIN || v->hash_tile_current == NULL) continue;
+		if (v->hash_tile_counted != v->tile) {
+			DEBUG(desync, 2, "train tile count mismatch: vehicle %i, counted on tile %i, on tile %i", v->index, v->hash_tile_counted, v->tile);
+		}
+		if (count[v->hash_tile_counted] != TRAIN_TILE_COUNT_STUCK) count[v->hash_tile_counted]++;
+	}
+
+	for (TileIndex tile = 0; tile < MapSize(); tile++) {
+		if (count[tile] != _train_tile_count[tile] && _train_tile_count[tile] != TRAIN_TILE_COUNT_STUCK) {
+			DEBUG(desync, 2, "train tile count mismatch: tile %i, counted %i, in hash %i", tile, _train_tile_count[tile], count[tile]);
+		}
+	}
+
+	free(count);
 }
 
 void ResetVehicleColourMap()
@@ -940,10 +1080,83 @@ static void RunVehicleDayProc()
 	}
 }
 
+/** Worker threads for the parallel part of the vehicle ticks. */
+static ThreadPool _vehicle_tick_pool("ottd:vehticks");
+
+/**
+ * Age the cargo of a range of vehicles with pending cargo aging.
+ * @param data  Array of vehicles.
+ * @param first First vehicle of the range.
+ * @param last  One past the last vehicle of the range.
+ */
+static void AgeVehicleCargoRange(void *data, uint first, uint last)
+{
+	Vehicle **vehicles = (Vehicle **)data;
+	for (uint i = first; i < last; i++) vehicles[i]->cargo.AgePendingCargo();
+}
+
+/**
+ * Execute the cargo aging that was requested during the vehicle ticks.
+ * Every vehicle only touches its own cargo list, so the work is spread
+ * over the worker threads; the result does not depend on the order.
+ * With desync debugging enabled the packets are aged serially on the main
+ * thread first, and the result of the workers is compared with that.
+ */
+static void AgePendingVehicleCargo()
+{
+	static SmallVector<Vehicle *, 64> pending;
+	static SmallVector<byte, 256> expected;
+	pending.Clear();
+
+	Vehicle *v;
+	FOR_ALL_VEHICLES(v) {
+		if (v->cargo.IsAgingPending()) *pending.Append() = v;
+	}
+	if (pending.Length() == 0) return;
+
+	bool check = _debug_desync_level > 1;
+	Randomizer old_random = _random;
+	if (check) {
+		expected.Clear();
+		for (Vehicle **it = pending.Begin(); it != pending.End(); it++) {
+			const CargoPacketList *packets = (*it)->cargo.Packets();
+			for (VehicleCargoList::ConstIterator p = packets->begin(); p != packets->end(); p++) {
+				byte days = (*p)->DaysInTransit();
+				*expected.Append() = (days == 0xFF) ? days : days + 1;
+			}
+		}
+	}
+
+	_vehicle_tick_pool.SetWorkerCount(max(GetCPUCoreCount(), 1U) - 1);
+	_vehicle_tick_pool.ParallelFor(pending.Length(), &AgeVehicleCargoRange, pending.Begin(), 64);
+
+	if (check) {
+		if (memcmp(&old_random, &_random, sizeof(_random)) != 0) {
+			DEBUG(desync, 2, "parallel vehicle ticks changed the random state");
+		}
+		const byte *days = expected.Begin();
+		for (Vehicle **it = pending.Begin(); it != pending.End(); it++) {
+			const CargoPacketList *packets = (*it)->cargo.Packets();
+			uint sum = 0;
+			bool match = true;
+			for (VehicleCargoList::ConstIterator p = packets->begin(); p != packets->end(); p++) {
+				if ((*p)->DaysInTransit() != *days++) match = false;
+				sum += (*p)->DaysInTransit() * (*p)->Count();
+			}
+			if (!match || sum != (*it)->cargo.CargoDaysInTransit()) {
+				DEBUG(desync, 2, "cargo aging mismatch: vehicle %i", (*it)->index);
+			}
+		}
+	}
+}
+
 void CallVehicleTicks()
 {
 	_vehicles_to_autoreplace.Clear();
 
+	/* Aging cargo is the expensive, independent part of the vehicle ticks, so defer it to the workers. */
+	bool defer_cargo_aging = _settings_game.vehicle.parallel_vehicle_ticks;
+
 	RunVehicleDayProc();
 
 	{
@@ -952,8 +1165,11 @@ void CallVehicleTicks()
 		FOR_ALL_STATIONS(st) LoadUnloadStation(st);
 	}
 	PerformanceAccumulator::Reset(PFE_GL_TRAINS);
+	PerformanceAccumulator::Reset(PFE_GL_PF_TRAINS);
 	PerformanceAccumulator::Reset(PFE_GL_ROADVEHS);
+	PerformanceAccumulator::Reset(PFE_GL_PF_ROADVEHS);
 	PerformanceAccumulator::Reset(PFE_GL_SHIPS);
+	PerformanceAccumulator::Reset(PFE_GL_PF_SHIPS);
 	PerformanceAccumulator::Reset(PFE_GL_AIRCRAFT);
 
 	Vehicle *v;
@@ -978,7 +1194,11 @@ void CallVehicleTicks()
 				if (v->vcache.cached_cargo_age_period != 0) {
 					v->cargo_age_counter = min(v->cargo_age_counter, v->vcache.cached_cargo_age_period);
 					if (--v->cargo_age_counter == 0) {
-						v->cargo.AgeCargo();
+						if (defer_cargo_aging) {
+							v->cargo.RequestAgeCargo();
+						} else {
+							v->cargo.AgeCargo();
+						}
 						v->cargo_age_counter = v->vcache.cached_cargo_age_period;
 					}
 				}
@@ -1026,6 +1246,8 @@ void CallVehicleTicks()
 		}
 	}
 
+	if (defer_cargo_aging) AgePendingVehicleCargo();
+
 	Backup<CompanyByte> cur_company(_current_company, FILE_LINE);
 	for (AutoreplaceMap::iterator it = _vehicles_to_autoreplace.Begin(); it != _vehicles_to_autoreplace.End(); it++) {
 		v = it->first;
@@ -250,6 +250,7 @@ public:
 	Vehicle *hash_tile_next;            ///< NOSAVE: Next vehicle in the tile location hash.
 	Vehicle **hash_tile_prev;           ///< NOSAVE: Previous vehicle in the tile location hash.
 	Vehicle **hash_tile_current;        ///< NOSAVE: Cache of the current hash chain.
+	TileIndex hash_tile_counted;        ///< NOSAVE: Tile a train is counted on in the train tile counters, valid while it is in the tile hash.
 
 	SpriteID colourmap;                 ///< NOSAVE: cached colour mapping
 
@@ -46,6 +46,8 @@ void FindVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 void FindVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
 bool HasVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
+void FindTrainOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
+bool HasTrainOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 void CallVehicleTicks();
 uint8 CalcPercentVehicleFilled(const Vehicle *v, StringID *colour);
 
@@ -53,6 +55,9 @@ void VehicleLengthChanged(const Vehicle *u);
 
 byte VehicleRandomBits();
 void ResetVehicleHash();
+void AllocateTrainTileCounts();
+void RebuildTrainTileCounts();
+void CheckTrainTileCounts();
 void ResetVehicleColourMap();
 
 byte GetBestFittingSubType(Vehicle *v_from, Vehicle *v_for, CargoID dest_cargo_type);
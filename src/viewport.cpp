@@ -65,6 +65,7 @@
 #include "stdafx.h"
 #include "landscape.h"
 #include "viewport_func.h"
+#include "viewport_kdtree.h"
 #include "station_base.h"
 #include "waypoint_base.h"
 #include "town.h"
@@ -88,6 +89,7 @@
 #include "command_func.h"
 #include "network/network_func.h"
 #include "framerate_type.h"
+#include "thread/thread_pool.h"
 
 #include <map>
 
@@ -175,7 +177,11 @@ struct ViewportDrawer {
 
 static void MarkViewportDirty(const ViewPort *vp, int left, int top, int right, int bottom);
 
-static ViewportDrawer _vd;
+static const uint VIEWPORT_DRAW_BATCH = 8; ///< Maximum number of viewport parts collected before they are drawn.
+
+static ViewportDrawer _viewport_drawers[VIEWPORT_DRAW_BATCH]; ///< Sprites of the viewport parts being drawn.
+static ViewportDrawer *_vd = &_viewport_drawers[0];           ///< Drawer of the viewport part that is collected or drawn right now.
+static ThreadPool _viewport_sort_pool("ottd:vpsort");          ///< Workers sorting the sprites of viewport parts.
 
 TileHighlightData _thd;
 static TileInfo *_cur_ti;
@@ -184,6 +190,9 @@ bool _draw_dirty_blocks = false;
 uint _dirty_block_colour = 0;
 static VpSpriteSorter _vp_sprite_sorter = NULL;
 
+ViewportSignKdtree _viewport_sign_kdtree; ///< Positions of all viewport signs.
+static int _viewport_sign_maxwidth = 0;   ///< Width of the widest viewport sign seen so far.
+
 static Point MapXYZToViewport(const ViewPort *vp, int x, int y, int z)
 {
 	Point p = RemapCoords(x, y, z);
@@ -494,7 +503,7 @@ static void AddTileSpriteToDraw(SpriteID image, PaletteID pal, int32 x, int32 y,
 {
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
-	TileSpriteToDraw *ts = _vd.tile_sprites_to_draw.Append();
+	TileSpriteToDraw *ts = _vd->tile_sprites_to_draw.Append();
 	ts->image = image;
 	ts->pal = pal;
 	ts->sub = sub;
@@ -518,17 +527,17 @@ static void AddTileSpriteToDraw(SpriteID image, PaletteID pal, int32 x, int32 y,
 static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubSprite *sub, FoundationPart foundation_part, int extra_offs_x, int extra_offs_y)
 {
 	assert(IsInsideMM(foundation_part, 0, FOUNDATION_PART_END));
-	assert(_vd.foundation[foundation_part] != -1);
-	Point offs = _vd.foundation_offset[foundation_part];
+	assert(_vd->foundation[foundation_part] != -1);
+	Point offs = _vd->foundation_offset[foundation_part];
 
 	/* Change the active ChildSprite list to the one of the foundation */
-	int *old_child = _vd.last_child;
-	_vd.last_child = _vd.last_foundation_child[foundation_part];
+	int *old_child = _vd->last_child;
+	_vd->last_child = _vd->last_foundation_child[foundation_part];
 
 	AddChildSpriteScreen(image, pal, offs.x + extra_offs_x, offs.y + extra_offs_y, false, sub, false);
 
 	/* Switch back to last ChildSprite list */
-	_vd.last_child = old_child;
+	_vd->last_child = old_child;
 }
 
 /**
@@ -547,11 +556,11 @@ static void AddChildSpriteToFoundation(SpriteID image, PaletteID pal, const SubS
 void DrawGroundSpriteAt(SpriteID image, PaletteID pal, int32 x, int32 y, int z, const SubSprite *sub, int extra_offs_x, int extra_offs_y)
 {
 	/* Switch to first foundation part, if no foundation was drawn */
-	if (_vd.foundation_part == FOUNDATION_PART_NONE) _vd.foundation_part = FOUNDATION_PART_NORMAL;
+	if (_vd->foundation_part == FOUNDATION_PART_NONE) _vd->foundation_part = FOUNDATION_PART_NORMAL;
 
-	if (_vd.foundation[_vd.foundation_part] != -1) {
+	if (_vd->foundation[_vd->foundation_part] != -1) {
 		Point pt = RemapCoords(x, y, z);
-		AddChildSpriteToFoundation(image, pal, sub, _vd.foundation_part, pt.x + extra_offs_x * ZOOM_LVL_BASE, pt.y + extra_offs_y * ZOOM_LVL_BASE);
+		AddChildSpriteToFoundation(image, pal, sub, _vd->foundation_part, pt.x + extra_offs_x * ZOOM_LVL_BASE, pt.y + extra_offs_y * ZOOM_LVL_BASE);
 	} else {
 		AddTileSpriteToDraw(image, pal, _cur_ti->x + x, _cur_ti->y + y, _cur_ti->z + z, sub, extra_offs_x * ZOOM_LVL_BASE, extra_offs_y * ZOOM_LVL_BASE);
 	}
@@ -582,22 +591,22 @@ void DrawGroundSprite(SpriteID image, PaletteID pal, const SubSprite *sub, int e
 void OffsetGroundSprite(int x, int y)
 {
 	/* Switch to next foundation part */
-	switch (_vd.foundation_part) {
+	switch (_vd->foundation_part) {
 		case FOUNDATION_PART_NONE:
-			_vd.foundation_part = FOUNDATION_PART_NORMAL;
+			_vd->foundation_part = FOUNDATION_PART_NORMAL;
 			break;
 		case FOUNDATION_PART_NORMAL:
-			_vd.foundation_part = FOUNDATION_PART_HALFTILE;
+			_vd->foundation_part = FOUNDATION_PART_HALFTILE;
 			break;
 		default: NOT_REACHED();
 	}
 
-	/* _vd.last_child == NULL if foundation sprite was clipped by the viewport bounds */
-	if (_vd.last_child != NULL) _vd.foundation[_vd.foundation_part] = _vd.parent_sprites_to_draw.Length() - 1;
+	/* _vd->last_child == NULL if foundation sprite was clipped by the viewport bounds */
+	if (_vd->last_child != NULL) _vd->foundation[_vd->foundation_part] = _vd->parent_sprites_to_draw.Length() - 1;
 
-	_vd.foundation_offset[_vd.foundation_part].x = x * ZOOM_LVL_BASE;
-	_vd.foundation_offset[_vd.foundation_part].y = y * ZOOM_LVL_BASE;
-	_vd.last_foundation_child[_vd.foundation_part] = _vd.last_child;
+	_vd->foundation_offset[_vd->foundation_part].x = x * ZOOM_LVL_BASE;
+	_vd->foundation_offset[_vd->foundation_part].y = y * ZOOM_LVL_BASE;
+	_vd->last_foundation_child[_vd->foundation_part] = _vd->last_child;
 }
 
 /**
@@ -616,13 +625,13 @@ static void AddCombinedSprite(SpriteID image, PaletteID pal, int x, int y, int z
 	Point pt = RemapCoords(x, y, z);
 	const Sprite *spr = GetSprite(image & SPRITE_MASK, ST_NORMAL);
 
-	if (pt.x + spr->x_offs >= _vd.dpi.left + _vd.dpi.width ||
-			pt.x + spr->x_offs + spr->width <= _vd.dpi.left ||
-			pt.y + spr->y_offs >= _vd.dpi.top + _vd.dpi.height ||
-			pt.y + spr->y_offs + spr->height <= _vd.dpi.top)
+	if (pt.x + spr->x_offs >= _vd->dpi.left + _vd->dpi.width ||
+			pt.x + spr->x_offs + spr->width <= _vd->dpi.left ||
+			pt.y + spr->y_offs >= _vd->dpi.top + _vd->dpi.height ||
+			pt.y + spr->y_offs + spr->height <= _vd->dpi.top)
 		return;
 
-	const ParentSpriteToDraw *pstd = _vd.parent_sprites_to_draw.End() - 1;
+	const ParentSpriteToDraw *pstd = _vd->parent_sprites_to_draw.End() - 1;
 	AddChildSpriteScreen(image, pal, pt.x - pstd->left, pt.y - pstd->top, false, sub, false);
 }
 
@@ -663,12 +672,12 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 		pal = PALETTE_TO_TRANSPARENT;
 	}
 
-	if (_vd.combine_sprites == SPRITE_COMBINE_ACTIVE) {
+	if (_vd->combine_sprites == SPRITE_COMBINE_ACTIVE) {
 		AddCombinedSprite(image, pal, x, y, z, sub);
 		return;
 	}
 
-	_vd.last_child = NULL;
+	_vd->last_child = NULL;
 
 	Point pt = RemapCoords(x, y, z);
 	int tmp_left, tmp_top, tmp_x = pt.x, tmp_y = pt.y;
@@ -696,14 +705,14 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 	}
 
 	/* Do not add the sprite to the viewport, if it is outside */
-	if (left   >= _vd.dpi.left + _vd.dpi.width ||
-	    right  <= _vd.dpi.left                 ||
-	    top    >= _vd.dpi.top + _vd.dpi.height ||
-	    bottom <= _vd.dpi.top) {
+	if (left   >= _vd->dpi.left + _vd->dpi.width ||
+	    right  <= _vd->dpi.left                 ||
+	    top    >= _vd->dpi.top + _vd->dpi.height ||
+	    bottom <= _vd->dpi.top) {
 		return;
 	}
 
-	ParentSpriteToDraw *ps = _vd.parent_sprites_to_draw.Append();
+	ParentSpriteToDraw *ps = _vd->parent_sprites_to_draw.Append();
 	ps->x = tmp_x;
 	ps->y = tmp_y;
 
@@ -725,9 +734,9 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 	ps->comparison_done = false;
 	ps->first_child = -1;
 
-	_vd.last_child = &ps->first_child;
+	_vd->last_child = &ps->first_child;
 
-	if (_vd.combine_sprites == SPRITE_COMBINE_PENDING) _vd.combine_sprites = SPRITE_COMBINE_ACTIVE;
+	if (_vd->combine_sprites == SPRITE_COMBINE_PENDING) _vd->combine_sprites = SPRITE_COMBINE_ACTIVE;
 }
 
 /**
@@ -750,8 +759,8 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
  */
 void StartSpriteCombine()
 {
-	assert(_vd.combine_sprites == SPRITE_COMBINE_NONE);
-	_vd.combine_sprites = SPRITE_COMBINE_PENDING;
+	assert(_vd->combine_sprites == SPRITE_COMBINE_NONE);
+	_vd->combine_sprites = SPRITE_COMBINE_PENDING;
 }
 
 /**
@@ -760,8 +769,8 @@ void StartSpriteCombine()
  */
 void EndSpriteCombine()
 {
-	assert(_vd.combine_sprites != SPRITE_COMBINE_NONE);
-	_vd.combine_sprites = SPRITE_COMBINE_NONE;
+	assert(_vd->combine_sprites != SPRITE_COMBINE_NONE);
+	_vd->combine_sprites = SPRITE_COMBINE_NONE;
 }
 
 /**
@@ -811,7 +820,7 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 	assert((image & SPRITE_MASK) < MAX_SPRITES);
 
 	/* If the ParentSprite was clipped by the viewport bounds, do not draw the ChildSprites either */
-	if (_vd.last_child == NULL) return;
+	if (_vd->last_child == NULL) return;
 
 	/* make the sprites transparent with the right palette */
 	if (transparent) {
@@ -819,9 +828,9 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 		pal = PALETTE_TO_TRANSPARENT;
 	}
 
-	*_vd.last_child = _vd.child_screen_sprites_to_draw.Length();
+	*_vd->last_child = _vd->child_screen_sprites_to_draw.Length();
 
-	ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Append();
+	ChildScreenSpriteToDraw *cs = _vd->child_screen_sprites_to_draw.Append();
 	cs->image = image;
 	cs->pal = pal;
 	cs->sub = sub;
@@ -832,15 +841,15 @@ void AddChildSpriteScreen(SpriteID image, PaletteID pal, int x, int y, bool tran
 	/* Append the sprite to the active ChildSprite list.
 	 * If the active ParentSprite is a foundation, update last_foundation_child as well.
 	 * Note: ChildSprites of foundations are NOT sequential in the vector, as selection sprites are added at last. */
-	if (_vd.last_foundation_child[0] == _vd.last_child) _vd.last_foundation_child[0] = &cs->next;
-	if (_vd.last_foundation_child[1] == _vd.last_child) _vd.last_foundation_child[1] = &cs->next;
-	_vd.last_child = &cs->next;
+	if (_vd->last_foundation_child[0] == _vd->last_child) _vd->last_foundation_child[0] = &cs->next;
+	if (_vd->last_foundation_child[1] == _vd->last_child) _vd->last_foundation_child[1] = &cs->next;
+	_vd->last_child = &cs->next;
 }
 
 static void AddStringToDraw(int x, int y, StringID string, uint64 params_1, uint64 params_2, Colours colour, uint16 width)
 {
 	assert(width != 0);
-	StringSpriteToDraw *ss = _vd.string_sprites_to_draw.Append();
+	StringSpriteToDraw *ss = _vd->string_sprites_to_draw.Append();
 	ss->string = string;
 	ss->x = x;
 	ss->y = y;
@@ -865,7 +874,7 @@ static void AddStringToDraw(int x, int y, StringID string, uint64 params_1, uint
 static void DrawSelectionSprite(SpriteID image, PaletteID pal, const TileInfo *ti, int z_offset, FoundationPart foundation_part)
 {
 	/* FIXME: This is not totally valid for some autorail highlights that extend over the edges of the tile. */
-	if (_vd.foundation[foundation_part] == -1) {
+	if (_vd->foundation[foundation_part] == -1) {
 		/* draw on real ground */
 		AddTileSpriteToDraw(image, pal, ti->x, ti->y, ti->z + z_offset);
 	} else {
@@ -1060,11 +1069,11 @@ static int GetViewportY(Point tile)
  */
 static void ViewportAddLandscape()
 {
-	assert(_vd.dpi.top <= _vd.dpi.top + _vd.dpi.height);
-	assert(_vd.dpi.left <= _vd.dpi.left + _vd.dpi.width);
+	assert(_vd->dpi.top <= _vd->dpi.top + _vd->dpi.height);
+	assert(_vd->dpi.left <= _vd->dpi.left + _vd->dpi.width);
 
-	Point upper_left = InverseRemapCoords(_vd.dpi.left, _vd.dpi.top);
-	Point upper_right = InverseRemapCoords(_vd.dpi.left + _vd.dpi.width, _vd.dpi.top);
+	Point upper_left = InverseRemapCoords(_vd->dpi.left, _vd->dpi.top);
+	Point upper_right = InverseRemapCoords(_vd->dpi.left + _vd->dpi.width, _vd->dpi.top);
 
 	/* Transformations between tile coordinates and viewport rows/columns: See vp_column_row
 	 *   column = y - x
@@ -1127,14 +1136,14 @@ static void ViewportAddLandscape()
 
 			int viewport_y = GetViewportY(tilecoord);
 
-			if (viewport_y + MAX_TILE_EXTENT_BOTTOM < _vd.dpi.top) {
+			if (viewport_y + MAX_TILE_EXTENT_BOTTOM < _vd->dpi.top) {
 				/* The tile in this column is not visible yet.
 				 * Tiles in other columns may be visible, but we need more rows in any case. */
 				last_row = false;
 				continue;
 			}
 
-			int min_visible_height = viewport_y - (_vd.dpi.top + _vd.dpi.height);
+			int min_visible_height = viewport_y - (_vd->dpi.top + _vd->dpi.height);
 			bool tile_visible = min_visible_height <= 0;
 
 			if (tile_type != MP_VOID) {
@@ -1159,11 +1168,11 @@ static void ViewportAddLandscape()
 
 			if (tile_visible) {
 				last_row = false;
-				_vd.foundation_part = FOUNDATION_PART_NONE;
-				_vd.foundation[0] = -1;
-				_vd.foundation[1] = -1;
-				_vd.last_foundation_child[0] = NULL;
-				_vd.last_foundation_child[1] = NULL;
+				_vd->foundation_part = FOUNDATION_PART_NONE;
+				_vd->foundation[0] = -1;
+				_vd->foundation[1] = -1;
+				_vd->last_foundation_child[0] = NULL;
+				_vd->last_foundation_child[1] = NULL;
 
 				_tile_type_procs[tile_type]->draw_tile_proc(&tile_info);
 				if (tile_info.tile != INVALID_TILE) DrawTileSelection(&tile_info);
@@ -1214,12 +1223,12 @@ void ViewportAddString(const DrawPixelInfo *dpi, ZoomLevel small_from, const Vie
 	}
 }
 
-static void ViewportAddTownNames(DrawPixelInfo *dpi)
+static void ViewportAddTownNames(DrawPixelInfo *dpi, const SmallVector<TownID, 16> &towns)
 {
 	if (!HasBit(_display_opt, DO_SHOW_TOWN_NAMES) || _game_mode == GM_MENU) return;
 
-	const Town *t;
-	FOR_ALL_TOWNS(t) {
+	for (const TownID *it = towns.Begin(); it != towns.End(); it++) {
+		const Town *t = Town::Get(*it);
 		ViewportAddString(dpi, ZOOM_LVL_OUT_16X, &t->cache.sign,
 				_settings_client.gui.population_in_label ? STR_VIEWPORT_TOWN_POP : STR_VIEWPORT_TOWN,
 				STR_VIEWPORT_TOWN_TINY_WHITE, STR_VIEWPORT_TOWN_TINY_BLACK,
@@ -1228,12 +1237,13 @@ static void ViewportAddTownNames(DrawPixelInfo *dpi)
 }
 
 
-static void ViewportAddStationNames(DrawPixelInfo *dpi)
+static void ViewportAddStationNames(DrawPixelInfo *dpi, const SmallVector<StationID, 16> &stations)
 {
 	if (!(HasBit(_display_opt, DO_SHOW_STATION_NAMES) || HasBit(_display_opt, DO_SHOW_WAYPOINT_NAMES)) || _game_mode == GM_MENU) return;
 
-	const BaseStation *st;
-	FOR_ALL_BASE_STATIONS(st) {
+	for (const StationID *it = stations.Begin(); it != stations.End(); it++) {
+		const BaseStation *st = BaseStation::Get(*it);
+
 		/* Check whether the base station is a station or a waypoint */
 		bool is_station = Station::IsExpected(st);
 
@@ -1251,13 +1261,14 @@ static void ViewportAddStationNames(DrawPixelInfo *dpi)
 }
 
 
-static void ViewportAddSigns(DrawPixelInfo *dpi)
+static void ViewportAddSigns(DrawPixelInfo *dpi, const SmallVector<SignID, 16> &signs)
 {
 	/* Signs are turned off or are invisible */
 	if (!HasBit(_display_opt, DO_SHOW_SIGNS) || IsInvisibilitySet(TO_SIGNS)) return;
 
-	const Sign *si;
-	FOR_ALL_SIGNS(si) {
+	for (const SignID *it = signs.Begin(); it != signs.End(); it++) {
+		const Sign *si = Sign::Get(*it);
+
 		/* Don't draw if sign is owned by another company and competitor signs should be hidden.
 		 * Note: It is intentional that also signs owned by OWNER_NONE are hidden. Bankrupt
 		 * companies can leave OWNER_NONE signs after them. */
@@ -1270,6 +1281,90 @@ static void ViewportAddSigns(DrawPixelInfo *dpi)
 	}
 }
 
+ViewportSignKdtreeItem ViewportSignKdtreeItem::MakeStation(StationID id)
+{
+	const BaseStation *st = BaseStation::Get(id);
+	ViewportSignKdtreeItem item = { VKI_STATION, id, st->sign.center, st->sign.top };
+	return item;
+}
+
+ViewportSignKdtreeItem ViewportSignKdtreeItem::MakeTown(TownID id)
+{
+	const Town *t = Town::Get(id);
+	ViewportSignKdtreeItem item = { VKI_TOWN, id, t->cache.sign.center, t->cache.sign.top };
+	return item;
+}
+
+ViewportSignKdtreeItem ViewportSignKdtreeItem::MakeSign(SignID id)
+{
+	const Sign *si = Sign::Get(id);
+	ViewportSignKdtreeItem item = { VKI_SIGN, id, si->sign.center, si->sign.top };
+	return item;
+}
+
+/**
+ * Rebuild the k-d tree of viewport signs from the current sign positions.
+ * Signs that have not been positioned yet are left out.
+ */
+void RebuildViewportKdtree()
+{
+	std::vector<ViewportSignKdtreeItem> items;
+
+	const BaseStation *st;
+	FOR_ALL_BASE_STATIONS(st) {
+		if (st->sign.width_normal != 0) items.push_back(ViewportSignKdtreeItem::MakeStation(st->index));
+	}
+
+	const Town *t;
+	FOR_ALL_TOWNS(t) {
+		if (t->cache.sign.width_normal != 0) items.push_back(ViewportSignKdtreeItem::MakeTown(t->index));
+	}
+
+	const Sign *si;
+	FOR_ALL_SIGNS(si) {
+		if (si->sign.width_normal != 0) items.push_back(ViewportSignKdtreeItem::MakeSign(si->index));
+	}
+
+	_viewport_sign_kdtree.Build(items.begin(), items.end());
+}
+
+/**
+ * Add the town names, station names and signs that overlap the drawn area.
+ * The signs are looked up in #_viewport_sign_kdtree and drawn by kind and
+ * pool index, so overlapping signs stack the same way on every redraw.
+ * @param dpi current viewport area
+ */
+static void ViewportAddKdtreeSigns(DrawPixelInfo *dpi)
+{
+	/* A sign is drawn when its box, which hangs below its top and is centred around its center, overlaps the area. */
+	int sign_height = ScaleByZoom(VPSM_TOP + FONT_HEIGHT_NORMAL + VPSM_BOTTOM, dpi->zoom);
+	int sign_half_width = ScaleByZoom(_viewport_sign_maxwidth / 2, dpi->zoom);
+
+	SmallVector<TownID, 16> towns;
+	SmallVector<StationID, 16> stations;
+	SmallVector<SignID, 16> signs;
+
+	_viewport_sign_kdtree.FindContained(dpi->left - sign_half_width, dpi->top - sign_height,
+			dpi->left + dpi->width + sign_half_width, dpi->top + dpi->height,
+			[&](const ViewportSignKdtreeItem &item) {
+		switch (item.type) {
+			case ViewportSignKdtreeItem::VKI_STATION: *stations.Append() = item.id; break;
+			case ViewportSignKdtreeItem::VKI_TOWN:    *towns.Append() = item.id; break;
+			case ViewportSignKdtreeItem::VKI_SIGN:    *signs.Append() = item.id; break;
+			default: NOT_REACHED();
+		}
+	});
+
+	/* Keep the drawing order of iterating the pools. */
+	std::sort(towns.Begin(), towns.End());
+	std::sort(stations.Begin(), stations.End());
+	std::sort(signs.Begin(), signs.End());
+
+	ViewportAddTownNames(dpi, towns);
+	ViewportAddStationNames(dpi, stations);
+	ViewportAddSigns(dpi, signs);
+}
+
 /**
  * Update the position of the viewport sign.
  * @param center the (preferred) center of the viewport sign
@@ -1295,6 +1390,8 @@ void ViewportSign::UpdatePosition(int center, int top, StringID str, StringID st
 	}
 	this->width_small = VPSM_LEFT + Align(GetStringBoundingBox(buffer, FS_SMALL).width, 2) + VPSM_RIGHT;
 
+	_viewport_sign_maxwidth = max<int>(_viewport_sign_maxwidth, max(this->width_normal, this->width_small));
+
 	this->MarkDirty();
 }
 
@@ -1495,52 +1592,77 @@ static void ViewportDrawStrings(ZoomLevel zoom, const StringSpriteToDrawVector *
 	}
 }
 
-void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom)
+/**
+ * Collect the sprites of a part of a viewport, and prepare them for sorting.
+ * @param vd     Drawer to collect the sprites in.
+ * @param vp     The viewport.
+ * @param left   Left edge of the part, in virtual coordinates.
+ * @param top    Top edge of the part, in virtual coordinates.
+ * @param right  Right edge of the part, in virtual coordinates.
+ * @param bottom Bottom edge of the part, in virtual coordinates.
+ */
+static void ViewportCollectSprites(ViewportDrawer *vd, const ViewPort *vp, int left, int top, int right, int bottom)
 {
 	DrawPixelInfo *old_dpi = _cur_dpi;
-	_cur_dpi = &_vd.dpi;
+	_vd = vd;
+	_cur_dpi = &_vd->dpi;
 
-	_vd.dpi.zoom = vp->zoom;
+	_vd->dpi.zoom = vp->zoom;
 	int mask = ScaleByZoom(-1, vp->zoom);
 
-	_vd.combine_sprites = SPRITE_COMBINE_NONE;
+	_vd->combine_sprites = SPRITE_COMBINE_NONE;
 
-	_vd.dpi.width = (right - left) & mask;
-	_vd.dpi.height = (bottom - top) & mask;
-	_vd.dpi.left = left & mask;
-	_vd.dpi.top = top & mask;
-	_vd.dpi.pitch = old_dpi->pitch;
-	_vd.last_child = NULL;
+	_vd->dpi.width = (right - left) & mask;
+	_vd->dpi.height = (bottom - top) & mask;
+	_vd->dpi.left = left & mask;
+	_vd->dpi.top = top & mask;
+	_vd->dpi.pitch = old_dpi->pitch;
+	_vd->last_child = NULL;
 
-	int x = UnScaleByZoom(_vd.dpi.left - (vp->virtual_left & mask), vp->zoom) + vp->left;
-	int y = UnScaleByZoom(_vd.dpi.top - (vp->virtual_top & mask), vp->zoom) + vp->top;
+	int x = UnScaleByZoom(_vd->dpi.left - (vp->virtual_left & mask), vp->zoom) + vp->left;
+	int y = UnScaleByZoom(_vd->dpi.top - (vp->virtual_top & mask), vp->zoom) + vp->top;
 
-	_vd.dpi.dst_ptr = BlitterFactory::GetCurrentBlitter()->MoveTo(old_dpi->dst_ptr, x - old_dpi->left, y - old_dpi->top);
+	_vd->dpi.dst_ptr = BlitterFactory::GetCurrentBlitter()->MoveTo(old_dpi->dst_ptr, x - old_dpi->left, y - old_dpi->top);
 
 	ViewportAddLandscape();
-	ViewportAddVehicles(&_vd.dpi);
-
-	ViewportAddTownNames(&_vd.dpi);
-	ViewportAddStationNames(&_vd.dpi);
-	ViewportAddSigns(&_vd.dpi);
+	ViewportAddVehicles(&_vd->dpi);
 
-	DrawTextEffects(&_vd.dpi);
+	ViewportAddKdtreeSigns(&_vd->dpi);
 
-	if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+	DrawTextEffects(&_vd->dpi);
 
-	ParentSpriteToDraw *psd_end = _vd.parent_sprites_to_draw.End();
-	for (ParentSpriteToDraw *it = _vd.parent_sprites_to_draw.Begin(); it != psd_end; it++) {
-		*_vd.parent_sprites_to_sort.Append() = it;
+	ParentSpriteToDraw *psd_end = _vd->parent_sprites_to_draw.End();
+	for (ParentSpriteToDraw *it = _vd->parent_sprites_to_draw.Begin(); it != psd_end; it++) {
+		*_vd->parent_sprites_to_sort.Append() = it;
 	}
 
-	_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
-	ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+	_cur_dpi = old_dpi;
+}
+
+/**
+ * Draw the sorted sprites of a part of a viewport, and forget about them.
+ * @param vd Drawer with the sprites of the part.
+ * @param vp The viewport.
+ */
+static void ViewportDrawSprites(ViewportDrawer *vd, const ViewPort *vp)
+{
+	DrawPixelInfo *old_dpi = _cur_dpi;
+	_vd = vd;
+	_cur_dpi = &_vd->dpi;
+
+	int mask = ScaleByZoom(-1, vp->zoom);
+	int x = UnScaleByZoom(_vd->dpi.left - (vp->virtual_left & mask), vp->zoom) + vp->left;
+	int y = UnScaleByZoom(_vd->dpi.top - (vp->virtual_top & mask), vp->zoom) + vp->top;
+
+	if (_vd->tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd->tile_sprites_to_draw);
 
-	if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
+	ViewportDrawParentSprites(&_vd->parent_sprites_to_sort, &_vd->child_screen_sprites_to_draw);
+
+	if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd->parent_sprites_to_sort);
 	if (_draw_dirty_blocks) ViewportDrawDirtyBlocks();
 
-	DrawPixelInfo dp = _vd.dpi;
-	ZoomLevel zoom = _vd.dpi.zoom;
+	DrawPixelInfo dp = _vd->dpi;
+	ZoomLevel zoom = _vd->dpi.zoom;
 	dp.zoom = ZOOM_LVL_NORMAL;
 	dp.width = UnScaleByZoom(dp.width, zoom);
 	dp.height = UnScaleByZoom(dp.height, zoom);
@@ -1553,45 +1675,104 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 		vp->overlay->Draw(&dp);
 	}
 
-	if (_vd.string_sprites_to_draw.Length() != 0) {
+	if (_vd->string_sprites_to_draw.Length() != 0) {
 		/* translate to world coordinates */
-		dp.left = UnScaleByZoom(_vd.dpi.left, zoom);
-		dp.top = UnScaleByZoom(_vd.dpi.top, zoom);
-		ViewportDrawStrings(zoom, &_vd.string_sprites_to_draw);
+		dp.left = UnScaleByZoom(_vd->dpi.left, zoom);
+		dp.top = UnScaleByZoom(_vd->dpi.top, zoom);
+		ViewportDrawStrings(zoom, &_vd->string_sprites_to_draw);
 	}
 
 	_cur_dpi = old_dpi;
 
-	_vd.string_sprites_to_draw.Clear();
-	_vd.tile_sprites_to_draw.Clear();
-	_vd.parent_sprites_to_draw.Clear();
-	_vd.parent_sprites_to_sort.Clear();
-	_vd.child_screen_sprites_to_draw.Clear();
+	_vd->string_sprites_to_draw.Clear();
+	_vd->tile_sprites_to_draw.Clear();
+	_vd->parent_sprites_to_draw.Clear();
+	_vd->parent_sprites_to_sort.Clear();
+	_vd->child_screen_sprites_to_draw.Clear();
+}
+
+/**
+ * Sort the parent sprites of a range of viewport drawers.
+ * @param data  The viewport drawers.
+ * @param first First drawer to sort.
+ * @param last  One past the last drawer to sort.
+ */
+static void ViewportSortSpritesRange(void *data, uint first, uint last)
+{
+	ViewportDrawer *drawers = (ViewportDrawer *)data;
+	for (uint i = first; i < last; i++) _vp_sprite_sorter(&drawers[i].parent_sprites_to_sort);
+}
+
+void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom)
+{
+	ViewportCollectSprites(&_viewport_drawers[0], vp, left, top, right, bottom);
+	_vp_sprite_sorter(&_viewport_drawers[0].parent_sprites_to_sort);
+	ViewportDrawSprites(&_viewport_drawers[0], vp);
 }
 
 /**
  * Make sure we don't draw a too big area at a time.
  * If we do, the sprite memory will overflow.
+ * @param vp The viewport.
+ * @param left   Left edge of the area, in screen coordinates.
+ * @param top    Top edge of the area, in screen coordinates.
+ * @param right  Right edge of the area, in screen coordinates.
+ * @param bottom Bottom edge of the area, in screen coordinates.
+ * @param[out] parts The parts to draw, in virtual coordinates.
  */
-static void ViewportDrawChk(const ViewPort *vp, int left, int top, int right, int bottom)
+static void ViewportSplitArea(const ViewPort *vp, int left, int top, int right, int bottom, SmallVector<Rect, 16> *parts)
 {
 	if (ScaleByZoom(bottom - top, vp->zoom) * ScaleByZoom(right - left, vp->zoom) > 180000 * ZOOM_LVL_BASE * ZOOM_LVL_BASE) {
 		if ((bottom - top) > (right - left)) {
 			int t = (top + bottom) >> 1;
-			ViewportDrawChk(vp, left, top, right, t);
-			ViewportDrawChk(vp, left, t, right, bottom);
+			ViewportSplitArea(vp, left, top, right, t, parts);
+			ViewportSplitArea(vp, left, t, right, bottom, parts);
 		} else {
 			int t = (left + right) >> 1;
-			ViewportDrawChk(vp, left, top, t, bottom);
-			ViewportDrawChk(vp, t, top, right, bottom);
+			ViewportSplitArea(vp, left, top, t, bottom, parts);
+			ViewportSplitArea(vp, t, top, right, bottom, parts);
 		}
 	} else {
-		ViewportDoDraw(vp,
-			ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom(top - vp->top, vp->zoom) + vp->virtual_top,
-			ScaleByZoom(right - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom(bottom - vp->top, vp->zoom) + vp->virtual_top
-		);
+		Rect *r = parts->Append();
+		r->left   = ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left;
+		r->top    = ScaleByZoom(top - vp->top, vp->zoom) + vp->virtual_top;
+		r->right  = ScaleByZoom(right - vp->left, vp->zoom) + vp->virtual_left;
+		r->bottom = ScaleByZoom(bottom - vp->top, vp->zoom) + vp->virtual_top;
+	}
+}
+
+/**
+ * Draw an area of a viewport in parts that are small enough.
+ * When enabled, the sprites of several parts are collected first, so they
+ * can be sorted by the worker threads at the same time. Collecting and
+ * drawing sprites stays on the calling thread, as the sprite and font
+ * caches are not thread safe.
+ * @param vp The viewport.
+ * @param left   Left edge of the area, in screen coordinates.
+ * @param top    Top edge of the area, in screen coordinates.
+ * @param right  Right edge of the area, in screen coordinates.
+ * @param bottom Bottom edge of the area, in screen coordinates.
+ */
+static void ViewportDrawChk(const ViewPort *vp, int left, int top, int right, int bottom)
+{
+	SmallVector<Rect, 16> parts;
+	ViewportSplitArea(vp, left, top, right, bottom, &parts);
+
+	if (!_settings_client.gui.parallel_sprite_sorting || parts.Length() == 1) {
+		for (const Rect *r = parts.Begin(); r != parts.End(); r++) ViewportDoDraw(vp, r->left, r->top, r->right, r->bottom);
+		return;
+	}
+
+	_viewport_sort_pool.SetWorkerCount(max(GetCPUCoreCount(), 1U) - 1);
+
+	for (uint first = 0; first < parts.Length(); first += VIEWPORT_DRAW_BATCH) {
+		uint count = min(parts.Length() - first, VIEWPORT_DRAW_BATCH);
+		for (uint i = 0; i < count; i++) {
+			const Rect &r = parts[first + i];
+			ViewportCollectSprites(&_viewport_drawers[i], vp, r.left, r.top, r.right, r.bottom);
+		}
+		_viewport_sort_pool.ParallelFor(count, &ViewportSortSpritesRange, _viewport_drawers);
+		for (uint i = 0; i < count; i++) ViewportDrawSprites(&_viewport_drawers[i], vp);
 	}
 }
 
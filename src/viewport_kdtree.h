@@ -0,0 +1,65 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file viewport_kdtree.h Spatial index of the signs drawn in viewports. */
+
+#ifndef VIEWPORT_KDTREE_H
+#define VIEWPORT_KDTREE_H
+
+#include "core/kdtree.hpp"
+#include "viewport_type.h"
+#include "station_type.h"
+#include "town_type.h"
+#include "signs_type.h"
+
+/** Sign in a viewport, as stored in the #ViewportSignKdtree. */
+struct ViewportSignKdtreeItem {
+	/** Kind of object the sign belongs to. */
+	enum ItemType {
+		VKI_STATION, ///< Station or waypoint name.
+		VKI_TOWN,    ///< Town name.
+		VKI_SIGN,    ///< Sign placed by a company or game script.
+	};
+
+	byte type;    ///< Kind of object, see #ItemType.
+	uint16 id;    ///< Pool index of the object.
+	int32 center; ///< Center of the sign, as in ViewportSign::center.
+	int32 top;    ///< Top of the sign, as in ViewportSign::top.
+
+	bool operator ==(const ViewportSignKdtreeItem &other) const
+	{
+		return this->type == other.type && this->id == other.id;
+	}
+
+	bool operator <(const ViewportSignKdtreeItem &other) const
+	{
+		if (this->type != other.type) return this->type < other.type;
+		return this->id < other.id;
+	}
+
+	static ViewportSignKdtreeItem MakeStation(StationID id);
+	static ViewportSignKdtreeItem MakeTown(TownID id);
+	static ViewportSignKdtreeItem MakeSign(SignID id);
+};
+
+/** Coordinate function of viewport signs for the k-d tree of signs. */
+struct Kdtree_ViewportSignXYFunc {
+	inline int32 operator()(const ViewportSignKdtreeItem &item, int dim) const
+	{
+		return dim == 0 ? item.center : item.top;
+	}
+};
+
+/** K-d tree of the positions of all viewport signs, in virtual coordinates. */
+typedef Kdtree<ViewportSignKdtreeItem, Kdtree_ViewportSignXYFunc, int32, int32> ViewportSignKdtree;
+extern ViewportSignKdtree _viewport_sign_kdtree;
+
+void RebuildViewportKdtree();
+
+#endif /* VIEWPORT_KDTREE_H */
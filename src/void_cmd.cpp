@@ -88,4 +88,5 @@ extern const TileTypeProcs _tile_type_void_procs = {
 	NULL,                     // vehicle_enter_tile_proc
 	GetFoundation_Void,       // get_foundation_proc
 	TerraformTile_Void,       // terraform_tile_proc
+	NULL,                     // tile_loop_batch_proc
 };
@@ -1332,4 +1332,5 @@ extern const TileTypeProcs _tile_type_water_procs = {
 	VehicleEnter_Water,       // vehicle_enter_tile_proc
 	GetFoundation_Water,      // get_foundation_proc
 	TerraformTile_Water,      // terraform_tile_proc
+	TileLoopBatch<MP_WATER, TileLoop_Water>, // tile_loop_batch_proc
 };